@@ -43,6 +43,7 @@
 #ifndef V4_BOOTSTRAP
 #include <private/qv4engine_p.h>
 #include <private/qv4function_p.h>
+#include <private/qv4identifiertable_p.h>
 #include <private/qv4objectproto_p.h>
 #include <private/qv4lookup_p.h>
 #include <private/qv4regexpobject_p.h>
@@ -50,6 +51,7 @@
 #include <private/qqmltypeloader_p.h>
 #include <private/qqmlengine_p.h>
 #include "qv4compilationunitmapper_p.h"
+#include <private/qv4tieredcompiler_p.h>
 #include <QQmlPropertyMap>
 #include <QDateTime>
 #include <QFile>
@@ -106,11 +108,14 @@ CompilationUnit::CompilationUnit()
     , metaTypeId(-1)
     , listMetaTypeId(-1)
     , isRegisteredWithEngine(false)
+    , tieredCompilation(0)
 {}
 
 CompilationUnit::~CompilationUnit()
 {
     unlink();
+    delete tieredCompilation;
+    tieredCompilation = 0;
     if (data && !(data->flags & QV4::CompiledData::Unit::StaticData))
         free(const_cast<Unit *>(data));
     data = 0;
@@ -123,6 +128,8 @@ QV4::Function *CompilationUnit::linkToEngine(ExecutionEngine *engine)
 
     Q_ASSERT(!runtimeStrings);
     Q_ASSERT(data);
+    if (SharedIdentifierTable *shared = engine->identifierTable->sharedTable())
+        shared->insert(data);
     runtimeStrings = (QV4::Heap::String **)malloc(data->stringTableSize * sizeof(QV4::Heap::String*));
     // memset the strings to 0 in case a GC run happens while we're within the loop below
     memset(runtimeStrings, 0, data->stringTableSize * sizeof(QV4::Heap::String*));
@@ -237,6 +244,10 @@ void CompilationUnit::unlink()
     engine = 0;
     free(runtimeStrings);
     runtimeStrings = 0;
+    if (runtimeLookups) {
+        for (uint i = 0; i < data->lookupTableSize; ++i)
+            runtimeLookups[i].releasePolymorphicCache();
+    }
     delete [] runtimeLookups;
     runtimeLookups = 0;
     delete [] runtimeRegularExpressions;
@@ -93,6 +93,7 @@ struct Function;
 struct Function;
 class EvalISelFactory;
 class CompilationUnitMapper;
+class TieredCompilationJob;
 
 namespace CompiledData {
 
@@ -212,7 +213,8 @@ struct Function
         UsesArgumentsObject = 0x4,
         IsNamedExpression   = 0x8,
         HasCatchOrWith      = 0x10,
-        CanUseSimpleCall    = 0x20
+        CanUseSimpleCall    = 0x20,
+        TempsDontEscape     = 0x40
     };
 
     // Absolute offset into file where the code for this function is located. Only used when the function
@@ -868,6 +870,10 @@ struct Q_QML_PRIVATE_EXPORT CompilationUnit : public QQmlRefCount
 
     QScopedPointer<CompilationUnitMapper> backingFile;
 
+    // Set when the unit was compiled for the interpreter and gets compiled again by the JIT
+    // once it is hot. Owned by the unit.
+    TieredCompilationJob *tieredCompilation;
+
     // --- interface for QQmlPropertyCacheCreator
     typedef Object CompiledObject;
     int objectCount() const { return data->nObjects; }
@@ -298,6 +298,8 @@ void QV4::Compiler::JSUnitGenerator::writeFunction(char *f, QV4::IR::Function *i
         function->flags |= CompiledData::Function::HasCatchOrWith;
     if (irFunction->canUseSimpleCall())
         function->flags |= CompiledData::Function::CanUseSimpleCall;
+    if (irFunction->tempsDontEscape)
+        function->flags |= CompiledData::Function::TempsDontEscape;
     function->nFormals = irFunction->formals.size();
     function->formalsOffset = currentOffset;
     currentOffset += function->nFormals * sizeof(quint32);
@@ -42,6 +42,7 @@
 #include "qv4jsir_p.h"
 #include "qv4isel_p.h"
 #include "qv4isel_util_p.h"
+#include "qv4ssa_p.h"
 #include <private/qv4value_p.h>
 #ifndef V4_BOOTSTRAP
 #include <private/qqmlpropertycache_p.h>
@@ -78,6 +79,10 @@ EvalISelFactory::~EvalISelFactory()
 
 QQmlRefPointer<CompiledData::CompilationUnit> EvalInstructionSelection::compile(bool generateUnitData)
 {
+    static const bool doInlining = qEnvironmentVariableIsEmpty("QV4_NO_INLINE");
+    if (doInlining)
+        IR::Optimizer::inlineFunctionCalls(irModule);
+
     for (int i = 0; i < irModule->functions.size(); ++i)
         run(i);
 
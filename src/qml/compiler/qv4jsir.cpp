@@ -365,6 +365,7 @@ Function::Function(Module *module, Function *outer, const QString &name)
     , hasTry(false)
     , hasWith(false)
     , isQmlBinding(false)
+    , tempsDontEscape(false)
     , unused(0)
     , line(0)
     , column(0)
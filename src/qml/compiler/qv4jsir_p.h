@@ -1295,7 +1295,8 @@ struct Function {
     uint hasTry: 1;
     uint hasWith: 1;
     uint isQmlBinding: 1;
-    uint unused : 24;
+    uint tempsDontEscape: 1; // set by the optimizer, see QV4::Function::tempsDontEscape()
+    uint unused : 23;
 
     // Location of declaration in source code (0 if not specified)
     uint line;
@@ -1190,6 +1190,12 @@ public:
         return _defUses[variable.index].blockOfStatement;
     }
 
+    void setDefStmtBlock(const Temp &variable, BasicBlock *defBlock)
+    {
+        Q_ASSERT(static_cast<unsigned>(variable.index) < _defUses.size());
+        _defUses[variable.index].blockOfStatement = defBlock;
+    }
+
     void replaceBasicBlock(BasicBlock *from, BasicBlock *to)
     {
         for (auto &du : _defUses) {
@@ -4911,6 +4917,385 @@ private:
     }
 };
 
+static bool isInLoop(BasicBlock *bb, BasicBlock *loopHeader)
+{
+    for (BasicBlock *it = bb; it; it = it->containingGroup())
+        if (it == loopHeader)
+            return true;
+    return false;
+}
+
+static int loopDepth(BasicBlock *loopHeader)
+{
+    int depth = 0;
+    for (BasicBlock *it = loopHeader->containingGroup(); it; it = it->containingGroup())
+        ++depth;
+    return depth;
+}
+
+// Range analysis for loop counters. A counter that starts at an int32 value, goes up by one on
+// every iteration, and is kept below an int32 value by the loop condition can never leave the
+// int32 range:
+//
+//     L1: i_1 = phi(init, i_2)
+//         cjump (i_1 < n) L2, L3
+//     L2: ...
+//         i_2 = i_1 + 1
+//         jump L1
+//
+// Type inference has to type the increment as a double, because an addition can overflow. Here
+// it can't: i_1 < n <= INT_MAX whenever the increment is executed. So the counter and the
+// increment are narrowed to int32, which means integer arithmetic and comparisons in the JIT,
+// and an int32 index for any subscript that uses the counter.
+//
+// The bound has to be an int32 for this to work. Loops over "i < arr.length" are left alone:
+// the length is an unsigned 32-bit value, or anything at all for objects that are not arrays.
+class InductionVariableRanges
+{
+    enum { MaxChainLength = 8 };
+
+    DefUses &defUses;
+    DominatorTree &df;
+
+public:
+    InductionVariableRanges(DefUses &defUses, DominatorTree &df)
+        : defUses(defUses)
+        , df(df)
+    {}
+
+    int run(IR::Function *function)
+    {
+        int narrowed = 0;
+        for (BasicBlock *header : function->basicBlocks()) {
+            if (header->isRemoved() || !header->isGroupStart() || header->in.size() != 2)
+                continue;
+
+            Stmt *terminator = header->terminator();
+            CJump *cjump = terminator ? terminator->asCJump() : nullptr;
+            if (!cjump || !isInLoop(cjump->iftrue, header) || isInLoop(cjump->iffalse, header))
+                continue;
+            // The loop body has to be entered through the condition, and only through it.
+            if (cjump->iftrue->in.size() != 1)
+                continue;
+
+            Binop *cond = cjump->cond->asBinop();
+            if (!cond)
+                continue;
+            Expr *counter, *bound;
+            if (cond->op == OpLt) {
+                counter = cond->left;
+                bound = cond->right;
+            } else if (cond->op == OpGt) {
+                counter = cond->right;
+                bound = cond->left;
+            } else {
+                continue;
+            }
+
+            Temp *counterTemp = counter->asTemp();
+            if (!counterTemp || counterTemp->kind != Temp::VirtualRegister || counterTemp->type == SInt32Type)
+                continue;
+            if (bound->type != SInt32Type)
+                continue;
+            if (defUses.defStmtBlock(*counterTemp) != header)
+                continue;
+            Phi *phi = defUses.defStmt(*counterTemp)->asPhi();
+            if (!phi)
+                continue;
+
+            if (narrow(header, cjump->iftrue, phi))
+                ++narrowed;
+        }
+        return narrowed;
+    }
+
+private:
+    bool narrow(BasicBlock *header, BasicBlock *bodyEntry, Phi *phi)
+    {
+        const int backEdge = isInLoop(header->in.at(0), header) ? 0 : 1;
+        if (!isInLoop(header->in.at(backEdge), header) || isInLoop(header->in.at(1 - backEdge), header))
+            return false;
+
+        qint64 min, max;
+        if (!int32Range(phi->incoming.at(1 - backEdge), &min, &max))
+            return false;
+
+        // Walk from the value coming in over the back edge to the increment, and from there to the
+        // counter itself. Only copies and unary pluses may sit in between.
+        QVarLengthArray<Temp *, MaxChainLength> chain;
+        QVarLengthArray<Unop *, MaxChainLength> unaryPluses;
+        Binop *increment = nullptr;
+        BasicBlock *incrementBlock = nullptr;
+        Temp *current = phi->incoming.at(backEdge)->asTemp();
+        while (current && chain.size() < MaxChainLength) {
+            if (UntypedTemp(*current) == UntypedTemp(*phi->targetTemp))
+                break;
+            Stmt *def = defUses.defStmt(*current);
+            Move *move = def ? def->asMove() : nullptr;
+            if (!move || !move->target->asTemp())
+                return false;
+            chain.append(move->target->asTemp());
+
+            Expr *source = move->source;
+            if (!increment) {
+                if (Binop *b = source->asBinop()) {
+                    if (b->op != OpAdd)
+                        return false;
+                    if (isOne(b->right))
+                        source = b->left;
+                    else if (isOne(b->left))
+                        source = b->right;
+                    else
+                        return false;
+                    increment = b;
+                    incrementBlock = defUses.defStmtBlock(*current);
+                }
+            }
+            if (Unop *u = source->asUnop()) {
+                if (u->op != OpUPlus)
+                    return false;
+                unaryPluses.append(u);
+                source = u->expr;
+            }
+            current = source->asTemp();
+        }
+
+        if (!current || UntypedTemp(*current) != UntypedTemp(*phi->targetTemp) || !increment)
+            return false;
+        // The increment only ever sees values for which the loop condition held.
+        if (!incrementBlock || !df.dominates(bodyEntry, incrementBlock))
+            return false;
+
+        PropagateTempTypes propagator(defUses);
+        propagator.run(*phi->targetTemp, SInt32Type);
+        for (Temp *t : chain)
+            propagator.run(*t, SInt32Type);
+        for (Unop *u : unaryPluses)
+            u->type = SInt32Type;
+        increment->type = SInt32Type;
+        return true;
+    }
+
+    static bool isOne(Expr *e)
+    {
+        Const *c = e->asConst();
+        return c && (c->type & NumberType) && c->value == 1;
+    }
+
+    // Calculates the range of e, when it is known to be an integer in the int32 range.
+    bool int32Range(Expr *e, qint64 *min, qint64 *max, int depth = 0) const
+    {
+        if (Const *c = e->asConst()) {
+            if (!(c->type & NumberType) || !canConvertToSignedInteger(c->value))
+                return false;
+            *min = *max = qint64(c->value);
+            return true;
+        }
+
+        Temp *t = e->asTemp();
+        if (!t || t->kind != Temp::VirtualRegister)
+            return false;
+        if (t->type == SInt32Type) {
+            *min = INT_MIN;
+            *max = INT_MAX;
+            return true;
+        }
+        if (depth == MaxChainLength)
+            return false;
+
+        Stmt *def = defUses.defStmt(*t);
+        Move *move = def ? def->asMove() : nullptr;
+        if (!move)
+            return false;
+        Expr *source = move->source;
+        if (Unop *u = source->asUnop()) {
+            if (u->op != OpUPlus)
+                return false;
+            source = u->expr;
+        }
+        if (Binop *b = source->asBinop()) {
+            if (b->op != OpAdd && b->op != OpSub)
+                return false;
+            qint64 leftMin, leftMax, rightMin, rightMax;
+            if (!int32Range(b->left, &leftMin, &leftMax, depth + 1)
+                    || !int32Range(b->right, &rightMin, &rightMax, depth + 1))
+                return false;
+            if (b->op == OpAdd) {
+                *min = leftMin + rightMin;
+                *max = leftMax + rightMax;
+            } else {
+                *min = leftMin - rightMax;
+                *max = leftMax - rightMin;
+            }
+            return *min >= INT_MIN && *max <= INT_MAX;
+        }
+        return int32Range(source, min, max, depth + 1);
+    }
+};
+
+// Loop-invariant code motion: statements in a loop that calculate the same value on every
+// iteration are moved to the block that enters the loop. This means that the statement is
+// executed earlier than before, and also when the loop body is never executed. So only statements
+// that cannot throw or run user code are moved: arithmetic, comparisons and conversions on
+// numbers, booleans, null and undefined, and reads of "this", the QML context, and of QML types
+// and namespaces. Property reads like "arr.length" are not moved, because they can call getters,
+// and the property may be changed in the loop.
+class LoopInvariantCodeMotion
+{
+    IR::Function *function;
+    DefUses &defUses;
+
+public:
+    LoopInvariantCodeMotion(IR::Function *function, DefUses &defUses)
+        : function(function)
+        , defUses(defUses)
+    {}
+
+    int run()
+    {
+        QVector<BasicBlock *> loopHeaders;
+        for (BasicBlock *bb : function->basicBlocks())
+            if (!bb->isRemoved() && bb->isGroupStart())
+                loopHeaders.append(bb);
+
+        // Handle inner loops first, so whatever is moved out of them can then be moved out of the
+        // enclosing loop too.
+        std::stable_sort(loopHeaders.begin(), loopHeaders.end(), [](BasicBlock *a, BasicBlock *b) {
+            return loopDepth(a) > loopDepth(b);
+        });
+
+        int hoisted = 0;
+        for (BasicBlock *loopHeader : qAsConst(loopHeaders))
+            hoisted += hoistOutOf(loopHeader);
+        return hoisted;
+    }
+
+private:
+    int hoistOutOf(BasicBlock *loopHeader)
+    {
+        // The loop must have a single entry edge from a block that only jumps into the loop.
+        BasicBlock *preheader = nullptr;
+        for (BasicBlock *in : loopHeader->in) {
+            if (isInLoop(in, loopHeader))
+                continue;
+            if (preheader)
+                return 0;
+            preheader = in;
+        }
+        if (!preheader || preheader->out.size() != 1)
+            return 0;
+
+        int hoisted = 0;
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (BasicBlock *bb : function->basicBlocks()) {
+                if (bb->isRemoved() || !isInLoop(bb, loopHeader))
+                    continue;
+
+                for (int i = 0; i < bb->statementCount(); ) {
+                    Stmt *s = bb->statements().at(i);
+                    if (!isInvariant(s, loopHeader)) {
+                        ++i;
+                        continue;
+                    }
+
+                    bb->removeStatement(i);
+                    preheader->insertStatementBeforeTerminator(s);
+                    defUses.setDefStmtBlock(*s->asMove()->target->asTemp(), preheader);
+                    ++hoisted;
+                    changed = true;
+                }
+            }
+        }
+        return hoisted;
+    }
+
+    bool isInvariant(Stmt *s, BasicBlock *loopHeader) const
+    {
+        Move *move = s->asMove();
+        if (!move)
+            return false;
+        Temp *target = move->target->asTemp();
+        if (!target || target->kind != Temp::VirtualRegister)
+            return false;
+        // Constants and copies are propagated by optimizeSSA, so there is nothing to gain.
+        if (move->source->asConst() || move->source->asTemp())
+            return false;
+        return isInvariant(move->source, loopHeader);
+    }
+
+    bool isInvariant(Expr *e, BasicBlock *loopHeader) const
+    {
+        if (e->asConst())
+            return true;
+
+        if (Temp *t = e->asTemp()) {
+            if (t->kind != Temp::VirtualRegister)
+                return false;
+            BasicBlock *defBlock = defUses.defStmtBlock(*t);
+            return defBlock && !isInLoop(defBlock, loopHeader);
+        }
+
+        if (Name *n = e->asName()) {
+            if (n->freeOfSideEffects)
+                return true;
+            switch (n->builtin) {
+            case Name::builtin_qml_context:
+            case Name::builtin_qml_imported_scripts_object:
+                return true;
+            case Name::builtin_invalid:
+                return n->id && *n->id == QLatin1String("this");
+            default:
+                return false;
+            }
+        }
+
+        if (Member *m = e->asMember())
+            return m->freeOfSideEffects && isInvariant(m->base, loopHeader);
+
+        if (Convert *c = e->asConvert()) {
+            if (!isPrimitive(c->expr->type) || !((c->type & NumberType) || c->type == BoolType))
+                return false;
+            return isInvariant(c->expr, loopHeader);
+        }
+
+        if (Unop *u = e->asUnop()) {
+            switch (u->op) {
+            case OpNot:
+            case OpUMinus:
+            case OpUPlus:
+            case OpCompl:
+                break;
+            default:
+                return false;
+            }
+            return isPrimitive(u->expr->type) && isInvariant(u->expr, loopHeader);
+        }
+
+        if (Binop *b = e->asBinop()) {
+            switch (b->op) {
+            case OpInstanceof: // these throw a TypeError on primitives
+            case OpIn:
+            case OpAnd:
+            case OpOr:
+                return false;
+            default:
+                break;
+            }
+            return isPrimitive(b->left->type) && isPrimitive(b->right->type)
+                    && isInvariant(b->left, loopHeader) && isInvariant(b->right, loopHeader);
+        }
+
+        return false;
+    }
+
+    // Operations on these types never call out to user code.
+    static bool isPrimitive(Type t)
+    {
+        return (t & NumberType) || t == BoolType || t == UndefinedType || t == NullType;
+    }
+};
+
 static void verifyCFG(IR::Function *function)
 {
     if (!DoVerification)
@@ -5083,6 +5468,74 @@ private:
     void visitTemp(Temp *) Q_DECL_OVERRIDE Q_DECL_FINAL {}
 };
 
+// Checks that the values calculated by a function can only end up in its temps, and in its
+// return value. That is the case when nothing gets stored outside of temps, and no other
+// function gets called explicitly. Strings handed to implicit calls, like getters, are copied
+// by the runtime (see MemoryManager::escapeTemporary). The check is conservative, so any kind
+// of call, subscript, or object creation counts as an escape.
+class EscapingTempsChecker
+{
+public:
+    static bool run(IR::Function *function)
+    {
+        if (function->hasDirectEval || function->usesArgumentsObject
+                || !function->nestedFunctions.isEmpty() || !function->locals.isEmpty())
+            return true;
+
+        EscapingTempsChecker checker;
+        for (BasicBlock *bb : function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+
+            for (Stmt *s : bb->statements()) {
+                if (auto e = s->asExp()) {
+                    checker.visit(e->expr);
+                } else if (auto m = s->asMove()) {
+                    if (!m->target->asTemp())
+                        return true;
+                    checker.visit(m->source);
+                } else if (auto c = s->asCJump()) {
+                    checker.visit(c->cond);
+                } else if (auto r = s->asRet()) {
+                    checker.visit(r->expr);
+                }
+                if (checker.escapes)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    EscapingTempsChecker()
+        : escapes(false)
+    {}
+
+    void visit(Expr *e)
+    {
+        if (e->asConst() || e->asString() || e->asTemp() || e->asArgLocal() || e->asName()) {
+            return;
+        } else if (auto c = e->asConvert()) {
+            visit(c->expr);
+        } else if (auto u = e->asUnop()) {
+            visit(u->expr);
+        } else if (auto b = e->asBinop()) {
+            // 'in' turns its left operand into an identifier
+            if (b->op == OpIn)
+                escapes = true;
+            visit(b->left);
+            visit(b->right);
+        } else if (auto m = e->asMember()) {
+            visit(m->base);
+        } else {
+            // calls, subscripts, closures, regexps, and new
+            escapes = true;
+        }
+    }
+
+    bool escapes;
+};
+
 void mergeBasicBlocks(IR::Function *function, DefUses *du, DominatorTree *dt)
 {
     enum { DebugBlockMerging = 0 };
@@ -5146,6 +5599,483 @@ void mergeBasicBlocks(IR::Function *function, DefUses *du, DominatorTree *dt)
     verifyCFG(function);
 }
 
+// Function inlining works on the whole module, before any of the functions are optimized. It
+// looks for helpers declared inside another function: such a helper is stored in a local of the
+// declaring ("owner") function. If that local is never written to except by the declaration
+// itself, then any call through it, from the owner or from a function nested in the owner, calls
+// that one closure. If the callee is small and simple enough (no nested functions, no this,
+// arguments, eval, try or with), the call is replaced by a copy of the callee's basic blocks. The
+// callee's formals and locals become temps in the caller, and its return statements become a
+// move to the call's target plus a jump to the rest of the caller's basic block.
+//
+// Calls inside the helpers themselves are left alone, so a helper is always copied in its
+// original form, and recursion can't make the pass run away.
+class FunctionInliner
+{
+    enum {
+        MaxInlineeSize = 24,    // statements in the callee
+        MaxCallerSize = 250     // statements in the caller after inlining, stays below the SSA limit
+    };
+
+    typedef QPair<const IR::Function *, unsigned> LocalSlot; // owner function, local index
+
+    IR::Module *module;
+    QHash<LocalSlot, IR::Function *> resolvedLocals;
+    QHash<const IR::Function *, int> inlineeSizes;
+    QHash<const IR::Function *, QSet<QString> > inlineeGlobalNames;
+
+    // Per inlined call:
+    IR::Function *caller;
+    BasicBlock *currentBlock;
+    unsigned scopeOfOwner; // number of scopes between the caller and the owner of the callee
+    unsigned formalsBase;
+    unsigned localsBase;
+    unsigned tempsBase;
+
+public:
+    FunctionInliner(IR::Module *module)
+        : module(module)
+        , caller(0)
+        , currentBlock(0)
+        , scopeOfOwner(0)
+        , formalsBase(0)
+        , localsBase(0)
+        , tempsBase(0)
+    {}
+
+    int run()
+    {
+        if (module->debugMode)
+            return 0;
+
+        resolveLocals();
+        if (resolvedLocals.isEmpty())
+            return 0;
+
+        int inlinedCalls = 0;
+        for (IR::Function *f : qAsConst(module->functions)) {
+            if (!inlineeSizes.contains(f))
+                inlinedCalls += inlineCallsIn(f);
+        }
+        return inlinedCalls;
+    }
+
+private:
+    static IR::Function *scopeOwner(IR::Function *f, unsigned scope)
+    {
+        while (scope--)
+            f = f->outer;
+        return f;
+    }
+
+    // Finds all locals that hold a function declared in their owner, and which are never
+    // written to afterwards.
+    void resolveLocals()
+    {
+        QHash<LocalSlot, IR::Function *> declarations;
+        QSet<LocalSlot> reassigned;
+        QSet<const IR::Function *> dynamicScopes;
+
+        for (IR::Function *f : qAsConst(module->functions)) {
+            // eval and with can write to any local in the scope chain
+            if (f->hasDirectEval || f->hasWith) {
+                for (const IR::Function *it = f; it; it = it->outer)
+                    dynamicScopes.insert(it);
+            }
+
+            for (BasicBlock *bb : f->basicBlocks()) {
+                if (bb->isRemoved())
+                    continue;
+
+                bool inPrologue = bb->index() == 0;
+                for (Stmt *s : bb->statements()) {
+                    Move *m = s->asMove();
+                    if (!m) {
+                        inPrologue = false;
+                        continue;
+                    }
+
+                    if (Name *n = m->target->asName()) {
+                        // an assignment to a name that couldn't be resolved at compile time, so
+                        // it can write to a local of any function up the scope chain
+                        if (n->id) {
+                            for (const IR::Function *it = f; it; it = it->outer) {
+                                for (int i = 0, ei = it->locals.size(); i != ei; ++i) {
+                                    if (*it->locals.at(i) == *n->id)
+                                        reassigned.insert(LocalSlot(it, i));
+                                }
+                            }
+                        }
+                    } else if (ArgLocal *al = m->target->asArgLocal()) {
+                        if (al->kind == ArgLocal::Local || al->kind == ArgLocal::ScopedLocal) {
+                            const LocalSlot slot(scopeOwner(f, al->scope), al->index);
+                            const bool ownLocalInPrologue = inPrologue && al->scope == 0;
+                            if (ownLocalInPrologue && m->source->asConst()
+                                    && !declarations.contains(slot)) {
+                                // initialization of the local to undefined
+                            } else if (ownLocalInPrologue && m->source->asClosure()
+                                       && !declarations.contains(slot)) {
+                                Closure *c = m->source->asClosure();
+                                declarations.insert(slot, module->functions.at(c->value));
+                            } else {
+                                reassigned.insert(slot);
+                            }
+                        }
+                    }
+
+                    // the prologue initializes locals and the return value, and stores the
+                    // function declarations, none of which can call out
+                    if (!m->source->asConst() && !m->source->asClosure())
+                        inPrologue = false;
+                }
+            }
+        }
+
+        for (auto it = declarations.cbegin(), eit = declarations.cend(); it != eit; ++it) {
+            const LocalSlot &slot = it.key();
+            if (reassigned.contains(slot) || dynamicScopes.contains(slot.first))
+                continue;
+            IR::Function *callee = it.value();
+            if (callee->outer != slot.first)
+                continue;
+            QSet<QString> globalNames;
+            const int size = inlineeSize(callee, &globalNames);
+            if (size < 0)
+                continue;
+            resolvedLocals.insert(slot, callee);
+            inlineeSizes.insert(callee, size);
+            inlineeGlobalNames.insert(callee, globalNames);
+        }
+    }
+
+    // Returns the number of statements in the function, or -1 if it cannot be inlined. The
+    // global names the function uses are added to globalNames.
+    static int inlineeSize(IR::Function *f, QSet<QString> *globalNames)
+    {
+        if (!f->nestedFunctions.isEmpty() || f->hasDirectEval || f->usesArgumentsObject
+                || f->usesThis || f->hasTry || f->hasWith || f->isNamedExpression
+                || f->isQmlBinding)
+            return -1;
+        if (!f->idObjectDependencies.isEmpty() || !f->contextObjectPropertyDependencies.isEmpty()
+                || !f->scopeObjectPropertyDependencies.isEmpty())
+            return -1;
+
+        int size = 0;
+        for (BasicBlock *bb : f->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            if (bb->catchBlock || bb->isExceptionHandler())
+                return -1;
+            for (Stmt *s : bb->statements()) {
+                if (++size > MaxInlineeSize)
+                    return -1;
+
+                if (Move *m = s->asMove()) {
+                    if (!canInline(m->target, globalNames) || !canInline(m->source, globalNames))
+                        return -1;
+                } else if (Exp *e = s->asExp()) {
+                    if (!canInline(e->expr, globalNames))
+                        return -1;
+                } else if (CJump *c = s->asCJump()) {
+                    if (!canInline(c->cond, globalNames))
+                        return -1;
+                } else if (Ret *r = s->asRet()) {
+                    if (!canInline(r->expr, globalNames))
+                        return -1;
+                } else if (!s->asJump()) {
+                    return -1;
+                }
+            }
+        }
+        return size;
+    }
+
+    static bool canInline(ExprList *args, QSet<QString> *globalNames)
+    {
+        for (; args; args = args->next) {
+            if (!canInline(args->expr, globalNames))
+                return false;
+        }
+        return true;
+    }
+
+    static bool canInline(Expr *e, QSet<QString> *globalNames)
+    {
+        if (e->asConst() || e->asString() || e->asRegExp() || e->asArgLocal()) {
+            return true;
+        } else if (Temp *t = e->asTemp()) {
+            return t->kind == Temp::VirtualRegister;
+        } else if (Name *n = e->asName()) {
+            // Names that are not global depend on the scope chain of the function they're in.
+            // Global ones can still be hidden in the caller, see hidesGlobalNames().
+            switch (n->builtin) {
+            case Name::builtin_invalid:
+                if (!n->global || n->qmlSingleton)
+                    return false;
+                globalNames->insert(*n->id);
+                return true;
+            case Name::builtin_typeof:
+            case Name::builtin_delete:
+            case Name::builtin_throw:
+            case Name::builtin_foreach_iterator_object:
+            case Name::builtin_foreach_next_property_name:
+            case Name::builtin_define_array:
+            case Name::builtin_define_object_literal:
+                return true;
+            default:
+                return false;
+            }
+        } else if (Convert *c = e->asConvert()) {
+            return canInline(c->expr, globalNames);
+        } else if (Unop *u = e->asUnop()) {
+            return canInline(u->expr, globalNames);
+        } else if (Binop *b = e->asBinop()) {
+            return canInline(b->left, globalNames) && canInline(b->right, globalNames);
+        } else if (Call *c = e->asCall()) {
+            return canInline(c->base, globalNames) && canInline(c->args, globalNames);
+        } else if (New *n = e->asNew()) {
+            return canInline(n->base, globalNames) && canInline(n->args, globalNames);
+        } else if (Subscript *s = e->asSubscript()) {
+            return canInline(s->base, globalNames) && canInline(s->index, globalNames);
+        } else if (Member *m = e->asMember()) {
+            return m->kind == Member::UnspecifiedMember && !m->property && canInline(m->base, globalNames);
+        }
+
+        return false; // closures
+    }
+
+    // Without fast lookups, global names are looked up through the context chain of the function
+    // they end up in. A local or formal of the caller, or of a function between the caller and the
+    // callee's owner, would then hide the global the callee refers to.
+    bool hidesGlobalNames(IR::Function *f, unsigned scopeOfOwner, const IR::Function *callee) const
+    {
+        const QSet<QString> globalNames = inlineeGlobalNames.value(callee);
+        if (globalNames.isEmpty())
+            return false;
+        for (; scopeOfOwner; --scopeOfOwner, f = f->outer) {
+            for (const QString *formal : qAsConst(f->formals)) {
+                if (globalNames.contains(*formal))
+                    return true;
+            }
+            for (const QString *local : qAsConst(f->locals)) {
+                if (globalNames.contains(*local))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    IR::Function *resolveCallee(IR::Function *f, Call *call) const
+    {
+        ArgLocal *base = call->base->asArgLocal();
+        if (!base || (base->kind != ArgLocal::Local && base->kind != ArgLocal::ScopedLocal))
+            return 0;
+        return resolvedLocals.value(LocalSlot(scopeOwner(f, base->scope), base->index), 0);
+    }
+
+    int inlineCallsIn(IR::Function *f)
+    {
+        int size = 0;
+        for (BasicBlock *bb : f->basicBlocks()) {
+            if (!bb->isRemoved())
+                size += bb->statementCount();
+        }
+
+        int inlinedCalls = 0;
+        // Only the blocks that are there now: blocks for the inlined code are appended after these,
+        // and the continuation blocks are handled when their call is inlined.
+        for (int i = 0, ei = f->basicBlockCount(); i != ei; ++i) {
+            BasicBlock *bb = f->basicBlock(i);
+            if (bb->isRemoved())
+                continue;
+
+            for (int j = 0; j < bb->statementCount(); ++j) {
+                Stmt *s = bb->statements().at(j);
+                Move *m = s->asMove();
+                Call *call = 0;
+                if (m)
+                    call = m->source->asCall();
+                else if (Exp *e = s->asExp())
+                    call = e->expr->asCall();
+                if (!call)
+                    continue;
+
+                IR::Function *callee = resolveCallee(f, call);
+                if (!callee || callee->isStrict != f->isStrict
+                        || hidesGlobalNames(f, call->base->asArgLocal()->scope, callee))
+                    continue;
+                const int growth = inlineeSizes.value(callee) + callee->formals.size() + 2;
+                if (size + growth > MaxCallerSize)
+                    return inlinedCalls;
+
+                size += growth;
+                bb = inlineCall(f, bb, j, callee, call, m);
+                j = -1; // continue with the statements after the call
+                ++inlinedCalls;
+            }
+        }
+        return inlinedCalls;
+    }
+
+    // Replaces the call at the given index by the body of the callee, and returns the block with
+    // the statements that came after the call.
+    BasicBlock *inlineCall(IR::Function *f, BasicBlock *bb, int callIndex, IR::Function *callee,
+                           Call *call, Move *resultMove)
+    {
+        caller = f;
+        scopeOfOwner = call->base->asArgLocal()->scope;
+        const QQmlJS::AST::SourceLocation callLocation = bb->statements().at(callIndex)->location;
+        bb->nextLocation = QQmlJS::AST::SourceLocation(); // make sure appendStatement doesn't mess with the line info
+
+        // Split the block after the call:
+        BasicBlock *continuation = f->newBasicBlock(bb->catchBlock);
+        const QVector<Stmt *> statements = bb->statements();
+        for (int i = callIndex + 1, ei = statements.size(); i != ei; ++i) {
+            Stmt *s = statements.at(i);
+            continuation->appendStatement(s);
+            if (CJump *cjump = s->asCJump())
+                cjump->parent = continuation;
+        }
+        for (int i = statements.size() - 1; i >= callIndex; --i)
+            bb->removeStatement(i);
+        continuation->out = bb->out;
+        bb->out.clear();
+        for (BasicBlock *successor : continuation->out) {
+            for (BasicBlock *&backlink : successor->in) {
+                if (backlink == bb)
+                    backlink = continuation;
+            }
+        }
+
+        // Allocate temps for everything the callee stores:
+        tempsBase = f->tempCount;
+        formalsBase = tempsBase + callee->tempCount;
+        localsBase = formalsBase + callee->formals.size();
+        const unsigned result = localsBase + callee->locals.size();
+        f->tempCount = result + 1;
+        f->maxNumberOfArguments = qMax(f->maxNumberOfArguments, callee->maxNumberOfArguments);
+
+        // Pass the arguments. Extra arguments have already been evaluated, so they can be dropped.
+        ExprList *arg = call->args;
+        for (int i = 0, ei = callee->formals.size(); i != ei; ++i) {
+            Expr *value = arg ? arg->expr : bb->CONST(UndefinedType, 0);
+            bb->MOVE(bb->TEMP(formalsBase + i), value)->location = callLocation;
+            if (arg)
+                arg = arg->next;
+        }
+
+        QVector<BasicBlock *> clonedBlocks(callee->basicBlockCount());
+        for (BasicBlock *calleeBlock : callee->basicBlocks()) {
+            if (!calleeBlock->isRemoved())
+                clonedBlocks[calleeBlock->index()] = f->newBasicBlock(bb->catchBlock);
+        }
+        bb->JUMP(clonedBlocks.at(0))->location = callLocation;
+
+        for (BasicBlock *calleeBlock : callee->basicBlocks()) {
+            if (calleeBlock->isRemoved())
+                continue;
+            currentBlock = clonedBlocks.at(calleeBlock->index());
+            for (Stmt *s : calleeBlock->statements()) {
+                Stmt *cloned = 0;
+                if (Exp *e = s->asExp()) {
+                    cloned = currentBlock->EXP(clone(e->expr));
+                } else if (Move *m = s->asMove()) {
+                    cloned = currentBlock->MOVE(clone(m->target), clone(m->source));
+                } else if (Jump *j = s->asJump()) {
+                    cloned = currentBlock->JUMP(clonedBlocks.at(j->target->index()));
+                } else if (CJump *c = s->asCJump()) {
+                    cloned = currentBlock->CJUMP(clone(c->cond),
+                                                 clonedBlocks.at(c->iftrue->index()),
+                                                 clonedBlocks.at(c->iffalse->index()));
+                } else if (Ret *r = s->asRet()) {
+                    if (Stmt *resultStore = currentBlock->MOVE(currentBlock->TEMP(result), clone(r->expr)))
+                        resultStore->location = s->location;
+                    cloned = currentBlock->JUMP(continuation);
+                } else {
+                    Q_UNREACHABLE();
+                }
+                if (cloned)
+                    cloned->location = s->location;
+            }
+        }
+
+        if (resultMove) {
+            resultMove->source = continuation->TEMP(result);
+            continuation->prependStatement(resultMove);
+        }
+
+        currentBlock = 0;
+        caller = 0;
+        return continuation;
+    }
+
+    ExprList *clone(ExprList *list)
+    {
+        ExprList *head = 0;
+        ExprList **tail = &head;
+        for (; list; list = list->next) {
+            ExprList *cloned = caller->New<ExprList>();
+            cloned->init(clone(list->expr));
+            *tail = cloned;
+            tail = &cloned->next;
+        }
+        return head;
+    }
+
+    Expr *clone(Expr *e)
+    {
+        BasicBlock *b = currentBlock;
+        if (Const *c = e->asConst()) {
+            return CloneExpr::cloneConst(c, caller);
+        } else if (String *s = e->asString()) {
+            return b->STRING(caller->newString(*s->value));
+        } else if (RegExp *r = e->asRegExp()) {
+            return b->REGEXP(caller->newString(*r->value), r->flags);
+        } else if (Name *n = e->asName()) {
+            Name *cloned = CloneExpr::cloneName(n, caller);
+            if (n->id)
+                cloned->id = caller->newString(*n->id);
+            return cloned;
+        } else if (Temp *t = e->asTemp()) {
+            Temp *cloned = CloneExpr::cloneTemp(t, caller);
+            cloned->index = tempsBase + t->index;
+            return cloned;
+        } else if (ArgLocal *al = e->asArgLocal()) {
+            if (al->scope == 0) {
+                // the callee has no nested functions, so its variables can live in temps
+                return b->TEMP((al->kind == ArgLocal::Formal ? formalsBase : localsBase) + al->index);
+            }
+            // a variable of the owner, or of a function further out
+            const unsigned scope = al->scope - 1 + scopeOfOwner;
+            ArgLocal *cloned = al->kind == ArgLocal::ScopedFormal ? b->ARG(al->index, scope)
+                                                                  : b->LOCAL(al->index, scope);
+            cloned->type = al->type;
+            cloned->isArgumentsOrEval = al->isArgumentsOrEval;
+            return cloned;
+        } else if (Convert *c = e->asConvert()) {
+            return b->CONVERT(clone(c->expr), c->type);
+        } else if (Unop *u = e->asUnop()) {
+            return b->UNOP(u->op, clone(u->expr));
+        } else if (Binop *bin = e->asBinop()) {
+            return b->BINOP(bin->op, clone(bin->left), clone(bin->right));
+        } else if (Call *c = e->asCall()) {
+            return b->CALL(clone(c->base), clone(c->args));
+        } else if (New *n = e->asNew()) {
+            return b->NEW(clone(n->base), clone(n->args));
+        } else if (Subscript *s = e->asSubscript()) {
+            return b->SUBSCRIPT(clone(s->base), clone(s->index));
+        } else if (Member *m = e->asMember()) {
+            Member *cloned = b->MEMBER(clone(m->base), caller->newString(*m->name), m->property,
+                                       m->kind, m->idIndex)->asMember();
+            cloned->freeOfSideEffects = m->freeOfSideEffects;
+            return cloned;
+        }
+
+        Q_UNREACHABLE();
+        return 0;
+    }
+};
+
 } // anonymous namespace
 
 void LifeTimeInterval::setFrom(int from) {
@@ -5426,6 +6356,9 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine, bool doTypeInference, bool pee
             TypeInference(qmlEngine, defUses).run(worklist);
             showMeTheCode(function, "After type inference");
 
+            InductionVariableRanges(defUses, df).run(function);
+            showMeTheCode(function, "After narrowing loop counters");
+
 //            qout << "Doing reverse inference..." << endl;
             ReverseInference(defUses).run(function);
 //            showMeTheCode(function);
@@ -5443,6 +6376,9 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine, bool doTypeInference, bool pee
             optimizeSSA(worklist, defUses, df);
             showMeTheCode(function, "After optimization");
 
+            LoopInvariantCodeMotion(function, defUses).run();
+            showMeTheCode(function, "After loop-invariant code motion");
+
             verifyImmediateDominators(df, function);
             verifyCFG(function);
         }
@@ -5480,6 +6416,8 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine, bool doTypeInference, bool pee
             showMeTheCode(function, "After line number removal");
         }
 
+        function->tempsDontEscape = !EscapingTempsChecker::run(function);
+
 //        qout << "Finished SSA." << endl;
         inSSA = true;
     } else {
@@ -5603,6 +6541,11 @@ void Optimizer::showMeTheCode(IR::Function *function, const char *marker)
     ::showMeTheCode(function, marker);
 }
 
+int Optimizer::inlineFunctionCalls(IR::Module *module)
+{
+    return FunctionInliner(module).run();
+}
+
 static inline bool overlappingStorage(const Temp &t1, const Temp &t2)
 {
     // This is the same as the operator==, but for one detail: memory locations are not sensitive
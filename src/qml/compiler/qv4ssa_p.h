@@ -259,6 +259,10 @@ public:
 
     static void showMeTheCode(Function *function, const char *marker);
 
+    // Inlines calls to small helper functions declared inside other functions. This has to run
+    // on the whole module before the functions are optimized. Returns the number of inlined calls.
+    static int inlineFunctionCalls(Module *module);
+
 private:
     Function *function;
     bool inSSA;
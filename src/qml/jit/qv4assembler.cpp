@@ -458,6 +458,13 @@ typename Assembler<TargetConfiguration>::Jump Assembler<TargetConfiguration>::ge
 template <typename TargetConfiguration>
 typename Assembler<TargetConfiguration>::Jump Assembler<TargetConfiguration>::branchDouble(bool invertCondition, IR::AluOp op,
                                                    IR::Expr *left, IR::Expr *right)
+{
+    return branchDouble(invertCondition, op, toDoubleRegister(left, FPGpr0), toDoubleRegister(right, JITTargetPlatform::FPGpr1));
+}
+
+template <typename TargetConfiguration>
+typename Assembler<TargetConfiguration>::Jump Assembler<TargetConfiguration>::branchDouble(bool invertCondition, IR::AluOp op,
+                                                   FPRegisterID left, FPRegisterID right)
 {
     DoubleCondition cond;
     switch (op) {
@@ -475,7 +482,7 @@ typename Assembler<TargetConfiguration>::Jump Assembler<TargetConfiguration>::br
     if (invertCondition)
         cond = TargetConfiguration::MacroAssembler::invert(cond);
 
-    return TargetConfiguration::MacroAssembler::branchDouble(cond, toDoubleRegister(left, FPGpr0), toDoubleRegister(right, JITTargetPlatform::FPGpr1));
+    return TargetConfiguration::MacroAssembler::branchDouble(cond, left, right);
 }
 
 template <typename TargetConfiguration>
@@ -639,6 +639,28 @@ typename JITAssembler::Jump Binop<JITAssembler>::genInlineBinop(IR::Expr *leftSo
         if (rightIsNoDbl.isSet())
             rightIsNoDbl.link(as);
     } break;
+    case IR::OpGt:
+    case IR::OpLt:
+    case IR::OpGe:
+    case IR::OpLe: {
+        FPRegisterID lReg = getFreeFPReg<JITAssembler>(rightSource, 2);
+        FPRegisterID rReg = getFreeFPReg<JITAssembler>(leftSource, 4);
+        Jump leftIsNoDbl = as->genTryDoubleConversion(leftSource, lReg);
+        Jump rightIsNoDbl = as->genTryDoubleConversion(rightSource, rReg);
+
+        Jump trueCase = as->branchDouble(false, op, lReg, rReg);
+        as->storeBool(false, target);
+        Jump falseDone = as->jump();
+        trueCase.link(as);
+        as->storeBool(true, target);
+        falseDone.link(as);
+        done = as->jump();
+
+        if (leftIsNoDbl.isSet())
+            leftIsNoDbl.link(as);
+        if (rightIsNoDbl.isSet())
+            rightIsNoDbl.link(as);
+    } break;
     default:
         break;
     }
@@ -646,6 +668,41 @@ typename JITAssembler::Jump Binop<JITAssembler>::genInlineBinop(IR::Expr *leftSo
     return done;
 }
 
+// Branches on a relational comparison when both operands turn out to be numbers at runtime. Typed
+// number operands need no check at all, everything else is tested for an int32 or double tag.
+// When a check fails, execution continues right after the emitted code, where the caller places
+// the generic runtime call.
+template <typename JITAssembler>
+bool Binop<JITAssembler>::genInlineCJump(IR::Expr *leftSource, IR::Expr *rightSource,
+                                         IR::BasicBlock *iftrue, IR::BasicBlock *iffalse)
+{
+    switch (op) {
+    case IR::OpGt:
+    case IR::OpLt:
+    case IR::OpGe:
+    case IR::OpLe:
+        break;
+    default:
+        return false;
+    }
+    if (leftSource->type == IR::StringType || rightSource->type == IR::StringType)
+        return false;
+
+    FPRegisterID lReg = getFreeFPReg<JITAssembler>(rightSource, 2);
+    FPRegisterID rReg = getFreeFPReg<JITAssembler>(leftSource, 4);
+    Jump leftIsNoDbl = as->genTryDoubleConversion(leftSource, lReg);
+    Jump rightIsNoDbl = as->genTryDoubleConversion(rightSource, rReg);
+
+    as->addPatch(iftrue, as->branchDouble(false, op, lReg, rReg));
+    as->addPatch(iffalse, as->jump());
+
+    if (leftIsNoDbl.isSet())
+        leftIsNoDbl.link(as);
+    if (rightIsNoDbl.isSet())
+        rightIsNoDbl.link(as);
+    return true;
+}
+
 template struct QV4::JIT::Binop<QV4::JIT::Assembler<DefaultAssemblerTargetConfiguration>>;
 #if defined(V4_BOOTSTRAP)
 #if !CPU(ARM_THUMB2)
@@ -82,6 +82,7 @@ struct Binop {
     void doubleBinop(IR::Expr *lhs, IR::Expr *rhs, IR::Expr *target);
     bool int32Binop(IR::Expr *leftSource, IR::Expr *rightSource, IR::Expr *target);
     Jump genInlineBinop(IR::Expr *leftSource, IR::Expr *rightSource, IR::Expr *target);
+    bool genInlineCJump(IR::Expr *leftSource, IR::Expr *rightSource, IR::BasicBlock *iftrue, IR::BasicBlock *iffalse);
 
     typedef Jump (Binop::*MemRegOp)(Address, RegisterID);
     typedef Jump (Binop::*ImmRegOp)(TrustedImm32, RegisterID);
@@ -1244,6 +1244,10 @@ void InstructionSelection<JITAssembler>::visitCJump(IR::CJump *s)
             return;
         }
 
+        // Operands that hold numbers at runtime take the inline path, the rest falls through to
+        // the runtime call below.
+        Binop<JITAssembler>(_as, b->op).genInlineCJump(b->left, b->right, s->iftrue, s->iffalse);
+
         typename JITAssembler::RuntimeCall op;
         typename JITAssembler::RuntimeCall opContext;
         const char *opName = 0;
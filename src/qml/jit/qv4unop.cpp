@@ -95,7 +95,28 @@ void Unop<JITAssembler>::generateUMinus(IR::Expr *source, IR::Expr *target)
         return;
     }
 
+    Jump done;
+    if (source->type != IR::StringType) {
+        // Negate numbers inline, and leave everything else to the runtime. FPGpr0 is free again
+        // once the operand has been converted.
+        FPRegisterID sReg = FPRegisterID(2);
+        if (IR::Temp *sourceTemp = source->asTemp()) {
+            if (sourceTemp->type == IR::DoubleType && sourceTemp->kind == IR::Temp::PhysicalRegister
+                    && sourceTemp->index == 2)
+                sReg = FPRegisterID(3);
+        }
+        Jump isNoDbl = _as->genTryDoubleConversion(source, sReg);
+        _as->negateDouble(sReg, JITAssembler::FPGpr0);
+        _as->storeDouble(JITAssembler::FPGpr0, target);
+        done = _as->jump();
+        if (isNoDbl.isSet())
+            isNoDbl.link(_as);
+    }
+
     generateRuntimeCall(_as, target, uMinus, PointerToValue(source));
+
+    if (done.isSet())
+        done.link(_as);
 }
 
 template <typename JITAssembler>
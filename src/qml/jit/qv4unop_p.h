@@ -71,6 +71,8 @@ struct Unop {
     using PointerToValue = typename JITAssembler::PointerToValue;
     using RuntimeCall = typename JITAssembler::RuntimeCall;
     using TrustedImm32 = typename JITAssembler::TrustedImm32;
+    using FPRegisterID = typename JITAssembler::FPRegisterID;
+    using Jump = typename JITAssembler::Jump;
 
     void generate(IR::Expr *source, IR::Expr *target);
 
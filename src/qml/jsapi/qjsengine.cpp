@@ -48,6 +48,7 @@
 #include "private/qv4globalobject_p.h"
 #include "private/qv4script_p.h"
 #include "private/qv4runtime_p.h"
+#include "private/qv4arraybuffer_p.h"
 #include <private/qqmlbuiltinfunctions_p.h>
 #include <private/qqmldebugconnector_p.h>
 #include <private/qv4qobjectwrapper_p.h>
@@ -487,6 +488,28 @@ QJSValue QJSEngine::newArray(uint length)
     return QJSValue(d->m_v4Engine, array.asReturnedValue());
 }
 
+/*!
+  \since 5.10
+
+  Creates a JavaScript ArrayBuffer of \a size bytes that reads the memory
+  at \a data in place, without copying it.
+
+  The memory has to stay valid and unchanged as long as \a owner, or a copy
+  of it, is alive. The engine keeps a copy of \a owner until the ArrayBuffer
+  is garbage collected. The first time a script writes to the buffer, the
+  data is copied and the copy of \a owner is released.
+
+  To create an ArrayBuffer from a QByteArray, use toScriptValue().
+
+  \sa newArray()
+*/
+QJSValue QJSEngine::newArrayBuffer(const char *data, int size, const QSharedPointer<void> &owner)
+{
+    QV4::Scope scope(d->m_v4Engine);
+    QV4::ScopedValue v(scope, d->m_v4Engine->newArrayBuffer(data, size_t(qMax(size, 0)), owner));
+    return QJSValue(d->m_v4Engine, v->asReturnedValue());
+}
+
 /*!
   Creates a JavaScript object that wraps the given QObject \a
   object, using JavaScriptOwnership.
@@ -751,6 +774,16 @@ void QJSEnginePrivate::removeFromDebugServer(QJSEngine *q)
         server->removeEngine(q);
 }
 
+QV4::GCPacingPolicy QJSEnginePrivate::gcPacingPolicy(const QJSEngine *q)
+{
+    return QV8Engine::getV4(q->handle())->memoryManager->gcPacingPolicy();
+}
+
+void QJSEnginePrivate::setGCPacingPolicy(QJSEngine *q, const QV4::GCPacingPolicy &policy)
+{
+    QV8Engine::getV4(q)->memoryManager->setGCPacingPolicy(policy);
+}
+
 QQmlPropertyCache *QJSEnginePrivate::createCache(const QMetaObject *mo)
 {
     if (!mo->superClass()) {
@@ -71,6 +71,7 @@ public:
 
     QJSValue newObject();
     QJSValue newArray(uint length = 0);
+    QJSValue newArrayBuffer(const char *data, int size, const QSharedPointer<void> &owner);
 
     QJSValue newQObject(QObject *object);
 
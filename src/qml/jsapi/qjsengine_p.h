@@ -55,6 +55,7 @@
 #include <QtCore/qmutex.h>
 #include "qjsengine.h"
 #include "private/qtqmlglobal_p.h"
+#include <private/qv4mmdefs_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -79,6 +80,10 @@ public:
     static void addToDebugServer(QJSEngine *q);
     static void removeFromDebugServer(QJSEngine *q);
 
+    // Controls when the garbage collector of the engine runs. Applies to QQmlEngine, too.
+    static QV4::GCPacingPolicy gcPacingPolicy(const QJSEngine *q);
+    static void setGCPacingPolicy(QJSEngine *q, const QV4::GCPacingPolicy &policy);
+
     // Locker locks the QQmlEnginePrivate data structures for read and write, if necessary.
     // Currently, locking is only necessary if the threaded loader is running concurrently.  If it is
     // either idle, or is running with the main thread blocked, no locking is necessary.  This way
@@ -40,7 +40,8 @@ SOURCES += \
     $$PWD/qv4qobjectwrapper.cpp \
     $$PWD/qv4arraybuffer.cpp \
     $$PWD/qv4typedarray.cpp \
-    $$PWD/qv4dataview.cpp
+    $$PWD/qv4dataview.cpp \
+    $$PWD/qv4tieredcompiler.cpp
 
 !contains(QT_CONFIG, no-qml-debug): SOURCES += $$PWD/qv4profiling.cpp
 
@@ -89,7 +90,8 @@ HEADERS += \
     $$PWD/qv4profiling_p.h \
     $$PWD/qv4arraybuffer_p.h \
     $$PWD/qv4typedarray_p.h \
-    $$PWD/qv4dataview_p.h
+    $$PWD/qv4dataview_p.h \
+    $$PWD/qv4tieredcompiler_p.h
 
 qtConfig(qml-interpreter) {
     HEADERS += \
@@ -108,6 +108,7 @@ void Heap::ArrayBuffer::init(size_t length)
     }
     data->size = int(length);
     memset(data->data(), 0, length + 1);
+    externalOwner = nullptr;
 }
 
 void Heap::ArrayBuffer::init(const QByteArray& array)
@@ -115,38 +116,61 @@ void Heap::ArrayBuffer::init(const QByteArray& array)
     Object::init();
     data = const_cast<QByteArray&>(array).data_ptr();
     data->ref.ref();
+    externalOwner = nullptr;
+}
+
+void Heap::ArrayBuffer::init(const char *externalData, size_t length, const QSharedPointer<void> &owner)
+{
+    Object::init();
+    data = QTypedArrayData<char>::fromRawData(externalData, length);
+    externalOwner = new QSharedPointer<void>(owner);
 }
 
 void Heap::ArrayBuffer::destroy()
 {
     if (!data->ref.deref())
         QTypedArrayData<char>::deallocate(data);
+    delete externalOwner;
     Object::destroy();
 }
 
-QByteArray ArrayBuffer::asByteArray() const
+/*
+    Makes sure data is not shared with a QByteArray or external memory before it gets written to.
+    Returns false and throws a RangeError if the copy can't be allocated.
+*/
+bool Heap::ArrayBuffer::detach()
 {
-    QByteArrayDataPtr ba = { d()->data };
-    ba.ptr->ref.ref();
-    return QByteArray(ba);
-}
-
-void ArrayBuffer::detach() {
-    if (!d()->data->ref.isShared())
-        return;
+    if (!data->ref.isShared() && !externalOwner)
+        return true;
 
-    QTypedArrayData<char> *oldData = d()->data;
+    QTypedArrayData<char> *oldData = data;
 
-    d()->data = QTypedArrayData<char>::allocate(oldData->size + 1);
-    if (!d()->data) {
-        engine()->throwRangeError(QStringLiteral("ArrayBuffer: out of memory"));
-        return;
+    QTypedArrayData<char> *newData = QTypedArrayData<char>::allocate(oldData->size + 1);
+    if (!newData) {
+        internalClass->engine->throwRangeError(QStringLiteral("ArrayBuffer: out of memory"));
+        return false;
     }
-
-    memcpy(d()->data->data(), oldData->data(), oldData->size + 1);
+    newData->size = oldData->size;
+    memcpy(newData->data(), oldData->data(), oldData->size);
+    newData->data()[newData->size] = 0;
+    data = newData;
 
     if (!oldData->ref.deref())
         QTypedArrayData<char>::deallocate(oldData);
+    delete externalOwner;
+    externalOwner = nullptr;
+    return true;
+}
+
+QByteArray ArrayBuffer::asByteArray() const
+{
+    // external memory can go away with the buffer, and can't be shared
+    if (d()->isExternal())
+        return QByteArray(d()->data->data(), d()->data->size);
+
+    QByteArrayDataPtr ba = { d()->data };
+    ba.ptr->ref.ref();
+    return QByteArray(ba);
 }
 
 
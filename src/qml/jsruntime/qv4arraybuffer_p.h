@@ -52,6 +52,7 @@
 
 #include "qv4object_p.h"
 #include "qv4functionobject_p.h"
+#include <QtCore/qsharedpointer.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -66,10 +67,17 @@ struct ArrayBufferCtor : FunctionObject {
 struct Q_QML_PRIVATE_EXPORT ArrayBuffer : Object {
     void init(size_t length);
     void init(const QByteArray& array);
+    void init(const char *externalData, size_t length, const QSharedPointer<void> &owner);
     void destroy();
     QTypedArrayData<char> *data;
+    // Keeps external memory that data points to alive. The memory is only read in place,
+    // writes detach from it first.
+    QSharedPointer<void> *externalOwner;
 
     uint byteLength() const { return data->size; }
+    bool isExternal() const { return externalOwner != nullptr; }
+
+    bool detach();
 };
 
 }
@@ -93,11 +101,8 @@ struct Q_QML_PRIVATE_EXPORT ArrayBuffer : Object
 
     QByteArray asByteArray() const;
     uint byteLength() const { return d()->byteLength(); }
-    char *data() { detach(); return d()->data ? d()->data->data() : 0; }
-    const char *constData() { detach(); return d()->data ? d()->data->data() : 0; }
-
-private:
-    void detach();
+    char *data() { return d()->detach() && d()->data ? d()->data->data() : 0; }
+    const char *constData() const { return d()->data ? d()->data->data() : 0; }
 };
 
 struct ArrayBufferPrototype: Object
@@ -43,6 +43,9 @@
 #include "qv4runtime_p.h"
 #include "qv4argumentsobject_p.h"
 #include "qv4string_p.h"
+#include <QtCore/qmath.h>
+
+#include <algorithm>
 
 using namespace QV4;
 
@@ -159,6 +162,10 @@ void ArrayData::realloc(Object *o, Type newType, uint requested, bool enforceAtt
     }
     newData->setAlloc(alloc);
     newData->setType(newType);
+    if (newType != Heap::ArrayData::Simple)
+        newData->d()->elementKind = Heap::ArrayData::Generic;
+    else if (d)
+        newData->d()->elementKind = d->d()->elementKind;
     newData->setAttrs(enforceAttributes ? reinterpret_cast<PropertyAttributes *>(newData->d()->values.values + alloc) : 0);
     o->setArrayData(newData);
 
@@ -250,6 +257,8 @@ bool SimpleArrayData::put(Object *o, uint index, const Value &value)
     Q_ASSERT(index >= dd->values.size || !dd->attrs || !dd->attrs[index].isAccessor());
     // ### honour attributes
     dd->setData(o->engine(), index, value);
+    if (index > dd->values.size)
+        dd->elementKind = Heap::ArrayData::Generic;
     if (index >= dd->values.size) {
         if (dd->attrs)
             dd->attrs[index] = Attr_Data;
@@ -322,6 +331,8 @@ uint SimpleArrayData::truncate(Object *o, uint newLen)
 
     if (!dd->attrs) {
         dd->values.size = newLen;
+        if (!newLen)
+            dd->elementKind = Heap::ArrayData::PackedInt32;
         return newLen;
     }
 
@@ -418,6 +429,58 @@ uint SparseArrayData::allocate(Object *o, bool doubleSlot)
     }
 }
 
+// Stores a value in the sparse array, without converting it to simple storage. Returns the
+// slot the value was stored in, and sets added when a new entry was created for index.
+uint SparseArrayData::insertValue(Object *o, uint index, const Value &value, bool *added)
+{
+    Heap::SparseArrayData *s = o->d()->arrayData.cast<Heap::SparseArrayData>();
+    Q_ASSERT(s->type == Heap::ArrayData::Sparse);
+    SparseArrayNode *n = s->sparse->insert(index);
+    *added = n->value == UINT_MAX;
+    if (*added)
+        n->value = allocate(o);
+    s = o->d()->arrayData.cast<Heap::SparseArrayData>();
+    s->setArrayData(o->engine(), n->value, value);
+    return n->value;
+}
+
+// Converts a sparse array without attributes back to simple storage once at least half of
+// the indices up to its last element are in use. The density is only checked when the
+// number of entries went past a power of two since previousEntries, so that the cost of the
+// check and conversion is amortized over the insertions. Callers storing several values
+// check once all of them are stored, as the array data changes type here.
+void SparseArrayData::densifyIfNeeded(Object *o, uint previousEntries)
+{
+    Heap::SparseArrayData *s = o->d()->arrayData.cast<Heap::SparseArrayData>();
+    Q_ASSERT(s->type == Heap::ArrayData::Sparse);
+    if (s->attrs)
+        return;
+    const uint entries = s->sparse->nEntries();
+    if (entries < 64 || qNextPowerOfTwo(previousEntries) > entries)
+        return;
+    const SparseArray *tree = s->sparse;
+    const uint length = tree->end()->previousNode()->key() + 1;
+    if (length > 2 * entries)
+        return;
+
+    ExecutionEngine *e = o->engine();
+    Scope scope(e);
+    Scoped<SparseArrayData> sparse(scope, s);
+    o->d()->arrayData.set(e, nullptr);
+    realloc(o, Heap::ArrayData::Simple, length, false);
+    Heap::SimpleArrayData *d = o->d()->arrayData.cast<Heap::SimpleArrayData>();
+    d->values.size = length;
+
+    uint index = 0;
+    for (const SparseArrayNode *n = tree->begin(); n != tree->end(); n = n->nextNode()) {
+        const uint key = n->key();
+        for (; index < key; ++index)
+            d->setData(e, index, Primitive::emptyValue());
+        d->setData(e, index++, sparse->d()->values[n->value]);
+    }
+    Q_ASSERT(index == length);
+}
+
 ReturnedValue SparseArrayData::get(const Heap::ArrayData *d, uint index)
 {
     const Heap::SparseArrayData *s = static_cast<const Heap::SparseArrayData *>(d);
@@ -433,14 +496,15 @@ bool SparseArrayData::put(Object *o, uint index, const Value &value)
         return true;
 
     Heap::SparseArrayData *s = o->d()->arrayData.cast<Heap::SparseArrayData>();
-    SparseArrayNode *n = s->sparse->insert(index);
-    Q_ASSERT(n->value == UINT_MAX || !s->attrs || !s->attrs[n->value].isAccessor());
-    if (n->value == UINT_MAX)
-        n->value = allocate(o);
+    Q_ASSERT(!s->attrs || s->mappedIndex(index) == UINT_MAX || !s->attrs[s->mappedIndex(index)].isAccessor());
+    const uint entries = s->sparse->nEntries();
+    bool added;
+    const uint slot = insertValue(o, index, value, &added);
     s = o->d()->arrayData.cast<Heap::SparseArrayData>();
-    s->setArrayData(o->engine(), n->value, value);
     if (s->attrs)
-        s->attrs[n->value] = Attr_Data;
+        s->attrs[slot] = Attr_Data;
+    if (added)
+        densifyIfNeeded(o, entries);
     return true;
 }
 
@@ -559,8 +623,22 @@ uint SparseArrayData::length(const Heap::ArrayData *d)
 
 bool SparseArrayData::putArray(Object *o, uint index, const Value *values, uint n)
 {
-    for (uint i = 0; i < n; ++i)
-        put(o, index + i, values[i]);
+    // Store everything before converting to simple storage, the values are all put into
+    // the sparse data
+    const uint entries = o->d()->arrayData->sparse->nEntries();
+    bool anyAdded = false;
+    for (uint i = 0; i < n; ++i) {
+        if (values[i].isEmpty())
+            continue;
+        bool added;
+        const uint slot = insertValue(o, index + i, values[i], &added);
+        Heap::ArrayData *d = o->d()->arrayData;
+        if (d->attrs)
+            d->attrs[slot] = Attr_Data;
+        anyAdded |= added;
+    }
+    if (anyAdded)
+        densifyIfNeeded(o, entries);
     return true;
 }
 
@@ -596,9 +674,17 @@ uint ArrayData::append(Object *obj, ArrayObject *otherObj, uint n)
                 obj->arraySet(oldSize + it->key(), v);
             }
         } else {
+            // obj is sparse now, and only gets converted to simple storage after the loop
+            const uint entries = obj->d()->arrayData->sparse->nEntries();
+            bool anyAdded = false;
             for (const SparseArrayNode *it = other->d()->sparse->begin();
-                 it != os->sparse->end(); it = it->nextNode())
-                obj->arraySet(oldSize + it->key(), os->values[it->value]);
+                 it != os->sparse->end(); it = it->nextNode()) {
+                bool added;
+                SparseArrayData::insertValue(obj, oldSize + it->key(), os->values[it->value], &added);
+                anyAdded |= added;
+            }
+            if (anyAdded)
+                SparseArrayData::densifyIfNeeded(obj, entries);
         }
     } else {
         Heap::SimpleArrayData *os = static_cast<Heap::SimpleArrayData *>(other->d());
@@ -636,14 +722,22 @@ void ArrayData::insert(Object *o, uint index, const Value *v, bool isAccessor)
     }
 
     o->initSparseArray();
+    if (!isAccessor) {
+        const uint entries = o->d()->arrayData->sparse->nEntries();
+        bool added;
+        SparseArrayData::insertValue(o, index, *v, &added);
+        if (added)
+            SparseArrayData::densifyIfNeeded(o, entries);
+        return;
+    }
+
     Heap::SparseArrayData *s = o->d()->arrayData.cast<Heap::SparseArrayData>();
     SparseArrayNode *n = s->sparse->insert(index);
     if (n->value == UINT_MAX)
         n->value = SparseArrayData::allocate(o, isAccessor);
     s = o->d()->arrayData.cast<Heap::SparseArrayData>();
     s->setArrayData(o->engine(), n->value, *v);
-    if (isAccessor)
-        s->setArrayData(o->engine(), n->value + Object::SetterOffset, v[Object::SetterOffset]);
+    s->setArrayData(o->engine(), n->value + Object::SetterOffset, v[Object::SetterOffset]);
 }
 
 
@@ -687,6 +781,33 @@ bool ArrayElementLessThan::operator()(Value v1, Value v2) const
     return p1s->toQString() < p2s->toQString();
 }
 
+namespace {
+struct PackedSortEntry
+{
+    QString key;
+    Value value;
+
+    bool operator<(const PackedSortEntry &other) const { return key < other.key; }
+};
+}
+
+// The default sort order compares the string representations of the elements. For
+// packed arrays converting a number to a string has no side effects, so we can do it
+// once per element instead of twice per comparison.
+static void sortPacked(ExecutionEngine *engine, Heap::SimpleArrayData *d, uint len)
+{
+    Q_ASSERT(d->isPacked());
+    QVector<PackedSortEntry> entries;
+    entries.reserve(len);
+    for (uint i = 0; i < len; ++i) {
+        Value v = d->data(i);
+        entries.append({ v.toQString(), v });
+    }
+    std::sort(entries.begin(), entries.end());
+    for (uint i = 0; i < len; ++i)
+        d->setData(engine, i, entries.at(i).value);
+}
+
 template <typename RandomAccessIterator, typename T, typename LessThan>
 void sortHelper(RandomAccessIterator start, RandomAccessIterator end, const T &t, LessThan lessThan)
 {
@@ -828,6 +949,11 @@ void ArrayData::sort(ExecutionEngine *engine, Object *thisObject, const Value &c
 
         if (!len)
             return;
+
+        if (comparefn.isUndefined() && d->isPacked()) {
+            sortPacked(engine, d, len);
+            return;
+        }
     }
 
 
@@ -93,6 +93,7 @@ namespace Heap {
 #define ArrayDataMembers(class, Member) \
     Member(class, NoMark, uint, type) \
     Member(class, NoMark, uint, offset) \
+    Member(class, NoMark, uint, elementKind) \
     Member(class, NoMark, PropertyAttributes *, attrs) \
     Member(class, NoMark, ReturnedValue, freeList) \
     Member(class, NoMark, SparseArray *, sparse) \
@@ -103,11 +104,26 @@ DECLARE_HEAP_OBJECT(ArrayData, Base) {
 
     enum Type { Simple = 0, Complex = 1, Sparse = 2, Custom = 3 };
 
+    // Describes what is stored in [0, values.size) of a Simple array. The packed kinds
+    // guarantee that there are no holes and that every element is an int (PackedInt32)
+    // or a number (PackedDouble). Kinds only ever move towards Generic, except when a
+    // Simple array is truncated to zero length.
+    //
+    // Packed elements are still stored as 8 byte Values. Storing PackedInt32 arrays as
+    // 4 byte ints would halve their size, but the lookups, the runtime and the JIT all
+    // read values directly, and would each need a second path. For now the kind only
+    // lets the Array.prototype functions skip per element work: indexOf and lastIndexOf
+    // compare numbers without a type check and return right away for non-numeric search
+    // values, sort converts each element to a string once, and map reads elements
+    // without a property lookup.
+    enum ElementKind { PackedInt32 = 0, PackedDouble = 1, Generic = 2 };
+
     struct Index {
         Heap::ArrayData *arrayData;
         uint index;
 
         void set(ExecutionEngine *e, Value newVal) {
+            arrayData->updateElementKind(newVal);
             arrayData->values.set(e, index, newVal);
         }
         const Value *operator->() const { return &arrayData->values[index]; }
@@ -116,6 +132,15 @@ DECLARE_HEAP_OBJECT(ArrayData, Base) {
     };
 
     bool isSparse() const { return type == Sparse; }
+    bool isPacked() const { return type == Simple && elementKind != Generic; }
+
+    void updateElementKind(Value v) {
+        if (elementKind == Generic)
+            return;
+        if (elementKind == PackedInt32 && v.isInteger())
+            return;
+        elementKind = v.isNumber() ? PackedDouble : Generic;
+    }
 
     const ArrayVTable *vtable() const { return reinterpret_cast<const ArrayVTable *>(Base::vtable()); }
 
@@ -136,6 +161,7 @@ DECLARE_HEAP_OBJECT(ArrayData, Base) {
     }
 
     void setArrayData(ExecutionEngine *e, uint index, Value newVal) {
+        updateElementKind(newVal);
         values.set(e, index, newVal);
     }
 
@@ -147,6 +173,7 @@ struct SimpleArrayData : public ArrayData {
     uint mappedIndex(uint index) const { return (index + offset) % values.alloc; }
     const Value &data(uint index) const { return values[mappedIndex(index)]; }
     void setData(ExecutionEngine *e, uint index, Value newVal) {
+        updateElementKind(newVal);
         values.set(e, mappedIndex(index), newVal);
     }
 
@@ -194,6 +221,8 @@ struct Q_QML_EXPORT ArrayData : public Managed
     void setAlloc(uint a) { d()->values.alloc = a; }
     Type type() const { return static_cast<Type>(d()->type); }
     void setType(Type t) { d()->type = t; }
+    Heap::ArrayData::ElementKind elementKind() const { return static_cast<Heap::ArrayData::ElementKind>(d()->elementKind); }
+    bool isPacked() const { return d()->isPacked(); }
     PropertyAttributes *attrs() const { return d()->attrs; }
     void setAttrs(PropertyAttributes *a) { d()->attrs = a; }
     const Value *arrayData() const { return d()->values.data(); }
@@ -266,6 +295,8 @@ struct Q_QML_EXPORT SparseArrayData : public ArrayData
 
     static uint allocate(Object *o, bool doubleSlot = false);
     static void free(Heap::ArrayData *d, uint idx);
+    static uint insertValue(Object *o, uint index, const Value &value, bool *added);
+    static void densifyIfNeeded(Object *o, uint previousEntries);
 
     uint mappedIndex(uint index) const { return d()->mappedIndex(index); }
 
@@ -312,6 +343,7 @@ void ArrayData::setProperty(QV4::ExecutionEngine *e, uint index, const Property
 {
     uint mapped = mappedIndex(index);
     Q_ASSERT(mapped != UINT_MAX);
+    updateElementKind(p->value);
     values.set(e, mapped, p->value);
     if (attributes(index).isAccessor())
         values.set(e, mapped + 1 /*QV4::Object::SetterOffset*/, p->set);
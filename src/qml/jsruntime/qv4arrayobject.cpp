@@ -629,6 +629,16 @@ void ArrayPrototype::method_unshift(const BuiltinFunction *, Scope &scope, CallD
     scope.result = Encode(newLen);
 }
 
+// Packed arrays hold nothing but numbers, so strict equality against a numeric search
+// value reduces to a numeric comparison, and any other search value can't match.
+static inline bool strictEqualsPackedElement(Value element, const Value &searchValue)
+{
+    Q_ASSERT(element.isNumber() && searchValue.isNumber());
+    if (element.isInteger() && searchValue.isInteger())
+        return element.int_32() == searchValue.int_32();
+    return element.toNumber() == searchValue.toNumber();
+}
+
 void ArrayPrototype::method_indexOf(const BuiltinFunction *, Scope &scope, CallData *callData)
 {
     ScopedObject instance(scope, callData->thisObject.toObject(scope.engine));
@@ -692,6 +702,18 @@ void ArrayPrototype::method_indexOf(const BuiltinFunction *, Scope &scope, CallD
         Heap::SimpleArrayData *sa = instance->d()->arrayData.cast<Heap::SimpleArrayData>();
         if (len > sa->values.size)
             len = sa->values.size;
+        if (sa->isPacked()) {
+            if (searchValue->isNumber()) {
+                for (uint idx = fromIndex; idx < len; ++idx) {
+                    if (strictEqualsPackedElement(sa->data(idx), searchValue)) {
+                        scope.result = Encode(idx);
+                        return;
+                    }
+                }
+            }
+            scope.result = Encode(-1);
+            return;
+        }
         uint idx = fromIndex;
         while (idx < len) {
             value = sa->data(idx);
@@ -741,6 +763,22 @@ void ArrayPrototype::method_lastIndexOf(const BuiltinFunction *, Scope &scope, C
         fromIndex = (uint) f + 1;
     }
 
+    Heap::ArrayData *arrayData = instance->d()->arrayData;
+    if (instance->isArrayObject() && arrayData && arrayData->isPacked() && !instance->protoHasArray()) {
+        Heap::SimpleArrayData *sa = static_cast<Heap::SimpleArrayData *>(arrayData);
+        if (searchValue->isNumber()) {
+            for (uint k = qMin(fromIndex, sa->values.size); k > 0;) {
+                --k;
+                if (strictEqualsPackedElement(sa->data(k), searchValue)) {
+                    scope.result = Encode(k);
+                    return;
+                }
+            }
+        }
+        scope.result = Encode(-1);
+        return;
+    }
+
     ScopedValue v(scope);
     for (uint k = fromIndex; k > 0;) {
         --k;
@@ -871,12 +909,19 @@ void ArrayPrototype::method_map(const BuiltinFunction *, Scope &scope, CallData
     cData->thisObject = callData->argument(1);
     cData->args[2] = instance;
 
+    const bool isArray = instance->isArrayObject();
     ScopedValue v(scope);
     for (uint k = 0; k < len; ++k) {
-        bool exists;
-        v = instance->getIndexed(k, &exists);
-        if (!exists)
-            continue;
+        // the callback may modify the array, so check for packed elements on every iteration
+        Heap::ArrayData *arrayData = instance->d()->arrayData;
+        if (isArray && arrayData && arrayData->isPacked() && k < arrayData->values.size) {
+            v = static_cast<Heap::SimpleArrayData *>(arrayData)->data(k);
+        } else {
+            bool exists;
+            v = instance->getIndexed(k, &exists);
+            if (!exists)
+                continue;
+        }
 
         cData->args[0] = v;
         cData->args[1] = Primitive::fromDouble(k);
@@ -237,6 +237,8 @@ void DataViewPrototype::method_setChar(const BuiltinFunction *, Scope &scope, Ca
     idx += v->d()->byteOffset;
 
     int val = callData->argc >= 2 ? callData->args[1].toInt32() : 0;
+    if (!v->d()->buffer->detach())
+        RETURN_UNDEFINED();
     v->d()->buffer->data->data()[idx] = (char)val;
 
     RETURN_UNDEFINED();
@@ -257,6 +259,8 @@ void DataViewPrototype::method_set(const BuiltinFunction *, Scope &scope, CallDa
     int val = callData->argc >= 2 ? callData->args[1].toInt32() : 0;
 
     bool littleEndian = callData->argc < 3 ? false : callData->args[2].toBoolean();
+    if (!v->d()->buffer->detach())
+        RETURN_UNDEFINED();
 
     if (littleEndian)
         qToLittleEndian<T>(val, (uchar *)v->d()->buffer->data->data() + idx);
@@ -280,6 +284,8 @@ void DataViewPrototype::method_setFloat(const BuiltinFunction *, Scope &scope, C
 
     double val = callData->argc >= 2 ? callData->args[1].toNumber() : qt_qnan();
     bool littleEndian = callData->argc < 3 ? false : callData->args[2].toBoolean();
+    if (!v->d()->buffer->detach())
+        RETURN_UNDEFINED();
 
     if (sizeof(T) == 4) {
         // float
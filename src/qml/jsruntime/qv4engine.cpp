@@ -69,6 +69,7 @@
 #include "qv4arraybuffer_p.h"
 #include "qv4dataview_p.h"
 #include "qv4typedarray_p.h"
+#include "qv4tieredcompiler_p.h"
 #include <private/qv8engine_p.h>
 #include <private/qjsvalue_p.h>
 #include <private/qqmltypewrapper_p.h>
@@ -133,16 +134,18 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     : callDepth(0)
     , memoryManager(new QV4::MemoryManager(this))
     , executableAllocator(new QV4::ExecutableAllocator)
-    , regExpAllocator(new QV4::ExecutableAllocator)
     , currentContext(0)
     , bumperPointerAllocator(new WTF::BumpPointerAllocator)
     , jsStack(new WTF::PageAllocation)
+    , isGCMarkingInParallel(false)
     , globalCode(0)
     , v8Engine(0)
     , argumentsAccessors(0)
     , nArgumentsAccessors(0)
+    , nMegamorphicLookups(0)
     , m_engineId(engineSerial.fetchAndAddOrdered(1))
     , regExpCache(0)
+    , tieredCompiler(0)
     , m_multiplyWrappedQObjects(0)
 #ifndef QT_NO_QML_DEBUGGER
     , m_debugger(0)
@@ -172,6 +175,7 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
         } else {
             factory = new JIT::ISelFactory<>;
             jitDisabled = false;
+            tieredCompiler = TieredCompiler::create(this);
         }
 #else // !V4_ENABLE_JIT
         factory = new Moth::ISelFactory;
@@ -207,6 +211,8 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     typedArrayPrototype = static_cast<Object *>(jsAlloca(NTypedArrayTypes));
     typedArrayCtors = static_cast<FunctionObject *>(jsAlloca(NTypedArrayTypes));
     jsStrings = jsAlloca(NJSStrings);
+    numberStringCache = jsAlloca(NumberStringCacheSize);
+    memset(numberStringCacheKeys, 0, sizeof(numberStringCacheKeys));
 
     // set up stack limits
     jsStackLimit = jsStackBase + JSStackLimit/sizeof(Value);
@@ -470,6 +476,10 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
 
 ExecutionEngine::~ExecutionEngine()
 {
+    // stop background compilation before anything it uses goes away
+    delete tieredCompiler;
+    tieredCompiler = 0;
+
 #ifndef QT_NO_QML_DEBUGGER
     delete m_debugger;
     m_debugger = 0;
@@ -490,7 +500,6 @@ ExecutionEngine::~ExecutionEngine()
     delete classPool;
     delete bumperPointerAllocator;
     delete regExpCache;
-    delete regExpAllocator;
     delete executableAllocator;
     jsStack->deallocate();
     delete jsStack;
@@ -534,6 +543,11 @@ InternalClass *ExecutionEngine::newClass(const InternalClass &other)
     return new (classPool) InternalClass(other);
 }
 
+InternalClassStatistics ExecutionEngine::internalClassStatistics() const
+{
+    return InternalClass::statistics(emptyClass);
+}
+
 ExecutionContext *ExecutionEngine::pushGlobalContext()
 {
     pushContext(rootContext()->d());
@@ -565,7 +579,9 @@ Heap::String *ExecutionEngine::newIdentifier(const QString &text)
 
 Heap::Object *ExecutionEngine::newStringObject(const String *string)
 {
-    return memoryManager->allocObject<StringObject>(string);
+    Scope scope(this);
+    ScopedString s(scope, memoryManager->escapeTemporary(*string));
+    return memoryManager->allocObject<StringObject>(s.getPointer());
 }
 
 Heap::Object *ExecutionEngine::newNumberObject(double value)
@@ -607,6 +623,8 @@ Heap::ArrayObject *ExecutionEngine::newArrayObject(const Value *values, int leng
         // this doesn't require a write barrier, things will be ok, when the new array data gets inserted into
         // the parent object
         memcpy(&d->values.values, values, length*sizeof(Value));
+        for (int i = 0; i < length && d->elementKind != Heap::ArrayData::Generic; ++i)
+            d->updateElementKind(values[i]);
         a->d()->arrayData.set(this, d);
         a->setArrayLengthUnchecked(length);
     }
@@ -637,6 +655,13 @@ Heap::ArrayBuffer *ExecutionEngine::newArrayBuffer(size_t length)
     return memoryManager->allocObject<ArrayBuffer>(length);
 }
 
+// Creates an ArrayBuffer that reads length bytes at data in place. owner keeps the memory
+// alive, and is released once the buffer is collected or written to.
+Heap::ArrayBuffer *ExecutionEngine::newArrayBuffer(const char *data, size_t length, const QSharedPointer<void> &owner)
+{
+    return memoryManager->allocObject<ArrayBuffer>(data, length, owner);
+}
+
 
 Heap::DateObject *ExecutionEngine::newDateObject(const Value &value)
 {
@@ -950,6 +975,9 @@ void ExecutionEngine::markObjects(bool incremental)
              it != end; ++it)
             (*it)->markObjects(this);
     }
+
+    if (regExpCache)
+        regExpCache->markObjects(this);
 }
 
 ReturnedValue ExecutionEngine::throwError(const Value &value)
@@ -56,6 +56,7 @@
 #include "qv4context_p.h"
 #include "qv4runtimeapi_p.h"
 #include <private/qintrusivelist_p.h>
+#include <QtCore/qsharedpointer.h>
 
 #ifndef V4_BOOTSTRAP
 #  include <private/qv8engine_p.h>
@@ -87,6 +88,8 @@ struct CompilationUnit;
 
 struct InternalClass;
 struct InternalClassPool;
+struct InternalClassStatistics;
+class TieredCompiler;
 
 struct Q_QML_EXPORT ExecutionEngine : public EngineBase
 {
@@ -101,7 +104,6 @@ public:
 
     MemoryManager *memoryManager;
     ExecutableAllocator *executableAllocator;
-    ExecutableAllocator *regExpAllocator;
     QScopedPointer<EvalISelFactory> iselFactory;
 
     ExecutionContext *currentContext;
@@ -115,6 +117,9 @@ public:
     enum { JSStackLimit = 4*1024*1024 };
     WTF::PageAllocation *jsStack;
     Value *jsStackBase;
+    // Set while several threads trace the heap. Marked objects then go to the mark stack
+    // of the current marking thread instead of the JS stack.
+    bool isGCMarkingInParallel;
 
     void pushForGC(Heap::Base *m) {
         *jsStackTop = m;
@@ -273,6 +278,10 @@ public:
     Property *argumentsAccessors;
     int nArgumentsAccessors;
 
+    // property lookup sites that saw too many InternalClasses to cache them all,
+    // the qt.qml.lookups logging category reports where they are
+    int nMegamorphicLookups;
+
     enum JSStrings {
         String_Empty,
         String_undefined,
@@ -351,12 +360,25 @@ public:
     String *id_buffer() const { return reinterpret_cast<String *>(jsStrings + String_buffer); }
     String *id_lastIndex() const { return reinterpret_cast<String *>(jsStrings + String_lastIndex); }
 
+    // Strings for recently converted small non-negative integers, indexed by the integer
+    // modulo the cache size. The keys tell which integer a slot currently holds.
+    enum {
+        NumberStringCacheSize = 256,
+        NumberStringCacheLimit = 0x10000
+    };
+    Value *numberStringCache;
+    uint numberStringCacheKeys[NumberStringCacheSize];
+
     QSet<CompiledData::CompilationUnit*> compilationUnits;
 
     quint32 m_engineId;
 
     RegExpCache *regExpCache;
 
+    // Compiles code for the interpreter first and hands hot units to the JIT. 0 if everything
+    // goes straight to iselFactory.
+    TieredCompiler *tieredCompiler;
+
     // Scarce resources are "exceptionally high cost" QVariant types where allowing the
     // normal JavaScript GC to clean them up is likely to lead to out-of-memory or other
     // out-of-resource situations.  When such a resource is passed into JavaScript we
@@ -416,6 +438,7 @@ public:
 
     Heap::ArrayBuffer *newArrayBuffer(const QByteArray &array);
     Heap::ArrayBuffer *newArrayBuffer(size_t length);
+    Heap::ArrayBuffer *newArrayBuffer(const char *data, size_t length, const QSharedPointer<void> &owner);
 
     Heap::DateObject *newDateObject(const Value &value);
     Heap::DateObject *newDateObject(const QDateTime &dt);
@@ -455,6 +478,7 @@ public:
     void initRootContext();
 
     InternalClass *newClass(const InternalClass &other);
+    InternalClassStatistics internalClassStatistics() const;
 
     // Exception handling
     Value *exceptionValue;
@@ -550,6 +574,10 @@ inline
 void Heap::Base::mark(QV4::ExecutionEngine *engine)
 {
     Q_ASSERT(inUse());
+    if (Q_UNLIKELY(engine->isGCMarkingInParallel)) {
+        markInParallel();
+        return;
+    }
     const HeapItem *h = reinterpret_cast<const HeapItem *>(this);
     Chunk *c = h->chunk();
     size_t index = h - c->realBase();
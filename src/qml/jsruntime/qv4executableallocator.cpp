@@ -141,7 +141,8 @@ bool ExecutableAllocator::ChunkOfPages::contains(Allocation *alloc) const
 }
 
 ExecutableAllocator::ExecutableAllocator()
-    : mutex(QMutex::NonRecursive)
+    : used(0)
+    , mutex(QMutex::NonRecursive)
 {
 }
 
@@ -194,6 +195,7 @@ ExecutableAllocator::Allocation *ExecutableAllocator::allocate(size_t size)
             freeAllocations.insert(remainder->size, remainder);
     }
 
+    used += allocation->size;
     return allocation;
 }
 
@@ -203,6 +205,7 @@ void ExecutableAllocator::free(Allocation *allocation)
 
     Q_ASSERT(allocation);
 
+    used -= allocation->size;
     allocation->free = true;
 
     QMap<quintptr, ChunkOfPages*>::Iterator it = chunks.lowerBound(allocation->addr);
@@ -227,6 +230,12 @@ void ExecutableAllocator::free(Allocation *allocation)
     }
 }
 
+size_t ExecutableAllocator::usedSize() const
+{
+    QMutexLocker locker(&mutex);
+    return used;
+}
+
 ExecutableAllocator::ChunkOfPages *ExecutableAllocator::chunkForAllocation(Allocation *allocation) const
 {
     QMutexLocker locker(&mutex);
@@ -113,6 +113,8 @@ public:
     // for debugging / unit-testing
     int freeAllocationCount() const { return freeAllocations.count(); }
     int chunkCount() const { return chunks.count(); }
+    // bytes handed out for generated code
+    size_t usedSize() const;
 
     struct ChunkOfPages
     {
@@ -133,6 +135,7 @@ public:
 private:
     QMultiMap<size_t, Allocation*> freeAllocations;
     QMap<quintptr, ChunkOfPages*> chunks;
+    size_t used;
     mutable QMutex mutex;
 };
 
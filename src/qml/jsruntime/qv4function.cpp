@@ -56,6 +56,7 @@ Function::Function(ExecutionEngine *engine, CompiledData::CompilationUnit *unit,
         , code(codePtr)
         , codeData(0)
         , hasQmlDependencies(function->hasQmlDependencies())
+        , executionCount(0)
 {
     Q_UNUSED(engine);
 
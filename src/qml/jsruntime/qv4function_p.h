@@ -72,6 +72,9 @@ struct Q_QML_EXPORT Function {
     bool hasQmlDependencies;
     bool canUseSimpleCall;
 
+    // calls and loop iterations in the interpreter, see TieredCompiler
+    uint executionCount;
+
     Function(ExecutionEngine *engine, CompiledData::CompilationUnit *unit, const CompiledData::Function *function,
              ReturnedValue (*codePtr)(ExecutionEngine *, const uchar *));
     ~Function();
@@ -89,6 +92,9 @@ struct Q_QML_EXPORT Function {
     inline bool isNamedExpression() const { return compiledFunction->flags & CompiledData::Function::IsNamedExpression; }
 
     inline bool canUseSimpleFunction() const { return canUseSimpleCall; }
+    // None of the values computed by the function can be stored anywhere but in its temps,
+    // or be passed to other functions. Only its return value outlives a call.
+    inline bool tempsDontEscape() const { return compiledFunction->flags & CompiledData::Function::TempsDontEscape; }
 
     QQmlSourceLocation sourceLocation() const
     {
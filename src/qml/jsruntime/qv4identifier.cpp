@@ -168,8 +168,8 @@ const IdentifierHashEntry *IdentifierHashBase::lookup(String *str) const
 {
     if (!d)
         return 0;
-    if (str->d()->identifier)
-        return lookup(str->d()->identifier);
+    if (Identifier *identifier = str->identifier())
+        return lookup(identifier);
     return lookup(str->toQString());
 }
 
@@ -37,6 +37,8 @@
 **
 ****************************************************************************/
 #include "qv4identifiertable_p.h"
+#include <private/qv4compileddata_p.h>
+#include <QtCore/qvector.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -53,8 +55,143 @@ static inline int primeForNumBits(int numBits)
 }
 
 
+static bool sharedIdentifiersEnabled = !qEnvironmentVariableIsEmpty("QV4_SHARED_IDENTIFIERS");
+Q_GLOBAL_STATIC(SharedIdentifierTable, sharedIdentifierTable)
+
+SharedIdentifierTable::Level *SharedIdentifierTable::newLevel(int numBits)
+{
+    Level *level = new Level;
+    level->numBits = numBits;
+    level->alloc = primeForNumBits(numBits);
+    level->size = 0;
+    level->entries = new QAtomicPointer<Identifier>[level->alloc];
+    return level;
+}
+
+SharedIdentifierTable::SharedIdentifierTable()
+{
+    levels[0].store(newLevel(8));
+    levelCount.store(1);
+}
+
+SharedIdentifierTable::~SharedIdentifierTable()
+{
+    for (int i = 0; i < levelCount.load(); ++i) {
+        Level *level = levels[i].load();
+        for (int j = 0; j < level->alloc; ++j)
+            delete level->entries[j].load();
+        delete [] level->entries;
+        delete level;
+    }
+}
+
+SharedIdentifierTable *SharedIdentifierTable::instance()
+{
+    return sharedIdentifiersEnabled ? sharedIdentifierTable() : nullptr;
+}
+
+void SharedIdentifierTable::setEnabled(bool enabled)
+{
+    sharedIdentifiersEnabled = enabled;
+}
+
+template <typename S>
+Identifier *SharedIdentifierTable::find(const S &s, uint hash) const
+{
+    for (int i = levelCount.loadAcquire() - 1; i >= 0; --i) {
+        const Level *level = levels[i].loadAcquire();
+        uint idx = hash % level->alloc;
+        while (Identifier *e = level->entries[idx].loadAcquire()) {
+            if (e->hashValue == hash && e->string == s)
+                return e;
+            ++idx;
+            idx %= level->alloc;
+        }
+    }
+    return nullptr;
+}
+
+Identifier *SharedIdentifierTable::lookup(const QString &s, uint hash) const
+{
+    return find(s, hash);
+}
+
+Identifier *SharedIdentifierTable::lookup(const QLatin1String &s, uint hash) const
+{
+    return find(s, hash);
+}
+
+void SharedIdentifierTable::addEntry(Identifier *identifier)
+{
+    int count = levelCount.load();
+    Level *level = levels[count - 1].load();
+    if (level->alloc <= (level->size + 1)*2) {
+        // MaxLevels levels hold several hundred million identifiers
+        if (count == MaxLevels)
+            qFatal("SharedIdentifierTable: too many identifiers");
+        level = newLevel(level->numBits + 1);
+        levels[count].storeRelease(level);
+        levelCount.storeRelease(count + 1);
+    }
+
+    uint idx = identifier->hashValue % level->alloc;
+    while (level->entries[idx].load()) {
+        ++idx;
+        idx %= level->alloc;
+    }
+    level->entries[idx].storeRelease(identifier);
+    ++level->size;
+    totalSize.ref();
+}
+
+// Only names that can appear as property or variable names are worth keeping for the
+// lifetime of the process. Other string literals in the unit are left to the engine.
+static bool isIdentifierLike(const QString &s)
+{
+    if (s.isEmpty())
+        return false;
+    const QChar first = s.at(0);
+    if (!first.isLetter() && first != QLatin1Char('$') && first != QLatin1Char('_'))
+        return false;
+    for (int i = 1; i < s.length(); ++i) {
+        const QChar ch = s.at(i);
+        if (!ch.isLetterOrNumber() && ch != QLatin1Char('$') && ch != QLatin1Char('_'))
+            return false;
+    }
+    return true;
+}
+
+void SharedIdentifierTable::insert(const CompiledData::Unit *unit)
+{
+    // Most units only use names that other units brought in already, so check that before
+    // taking the lock.
+    QVector<QString> missing;
+    for (uint i = 0; i < unit->stringTableSize; ++i) {
+        const QString s = unit->stringAt(i);
+        if (!isIdentifierLike(s))
+            continue;
+        uint hash = String::createHashValue(s.constData(), s.length(), nullptr);
+        if (!find(s, hash))
+            missing.append(s);
+    }
+    if (missing.isEmpty())
+        return;
+
+    QMutexLocker locker(&writeLock);
+    for (const QString &s : qAsConst(missing)) {
+        uint hash = String::createHashValue(s.constData(), s.length(), nullptr);
+        if (find(s, hash))
+            continue;
+        Identifier *identifier = new Identifier;
+        identifier->string = s;
+        identifier->hashValue = hash;
+        addEntry(identifier);
+    }
+}
+
 IdentifierTable::IdentifierTable(ExecutionEngine *engine)
     : engine(engine)
+    , shared(SharedIdentifierTable::instance())
     , size(0)
     , numBits(8)
 {
@@ -65,22 +202,32 @@ IdentifierTable::IdentifierTable(ExecutionEngine *engine)
 
 IdentifierTable::~IdentifierTable()
 {
-    for (int i = 0; i < alloc; ++i)
-        if (entries[i])
-            delete entries[i]->identifier;
+    // identifiers coming from the shared table belong to it
+    const bool sharedTableAlive = shared && !sharedIdentifierTable.isDestroyed();
+    for (int i = 0; i < alloc; ++i) {
+        if (!entries[i])
+            continue;
+        if (shared && (!sharedTableAlive || shared->contains(entries[i]->identifier)))
+            continue;
+        delete entries[i]->identifier;
+    }
     free(entries);
 }
 
-void IdentifierTable::addEntry(Heap::String *str)
+void IdentifierTable::addEntry(Heap::String *str, Identifier *identifier)
 {
     uint hash = str->hashValue();
 
     if (str->subtype == Heap::String::StringType_ArrayIndex)
         return;
 
-    str->identifier = new Identifier;
-    str->identifier->string = str->toQString();
-    str->identifier->hashValue = hash;
+    if (identifier) {
+        str->identifier = identifier;
+    } else {
+        str->identifier = new Identifier;
+        str->identifier->string = str->toQString();
+        str->identifier->hashValue = hash;
+    }
     str->setMarkBit();
 
     bool grow = (alloc <= size*2);
@@ -117,10 +264,8 @@ void IdentifierTable::addEntry(Heap::String *str)
 
 
 
-Heap::String *IdentifierTable::insertString(const QString &s)
+Heap::String *IdentifierTable::lookup(const QString &s, uint hash) const
 {
-    uint subtype;
-    uint hash = String::createHashValue(s.constData(), s.length(), &subtype);
     uint idx = hash % alloc;
     while (Heap::String *e = entries[idx]) {
         if (e->stringHash == hash && e->toQString() == s)
@@ -128,17 +273,35 @@ Heap::String *IdentifierTable::insertString(const QString &s)
         ++idx;
         idx %= alloc;
     }
+    return nullptr;
+}
 
-    Heap::String *str = engine->newString(s);
+Heap::String *IdentifierTable::insertString(const QString &s)
+{
+    uint subtype;
+    uint hash = String::createHashValue(s.constData(), s.length(), &subtype);
+    if (Heap::String *e = lookup(s, hash))
+        return e;
+
+    // Identifiers this engine doesn't know yet come from the shared table if possible. The
+    // engine's own table keeps taking precedence, so an engine never sees two identifiers
+    // for the same name.
+    Identifier *identifier = nullptr;
+    if (shared && subtype != Heap::String::StringType_ArrayIndex)
+        identifier = shared->lookup(s, hash);
+
+    Heap::String *str = engine->newString(identifier ? identifier->string : s);
     str->stringHash = hash;
     str->subtype = subtype;
-    addEntry(str);
+    addEntry(str, identifier);
     return str;
 }
 
 
 Identifier *IdentifierTable::identifierImpl(const Heap::String *str)
 {
+    if (str->largestSubLength)
+        str->simplifyString();
     if (str->identifier)
         return str->identifier;
     uint hash = str->hashValue();
@@ -155,6 +318,14 @@ Identifier *IdentifierTable::identifierImpl(const Heap::String *str)
         idx %= alloc;
     }
 
+    // shared identifiers live as long as the process, so str doesn't need to be kept alive
+    if (shared) {
+        if (Identifier *identifier = shared->lookup(str->toQString(), hash)) {
+            str->identifier = identifier;
+            return identifier;
+        }
+    }
+
     addEntry(const_cast<QV4::Heap::String *>(str));
     return str->identifier;
 }
@@ -165,18 +336,34 @@ Heap::String *IdentifierTable::stringFromIdentifier(Identifier *i)
         return 0;
 
     uint idx = i->hashValue % alloc;
-    while (1) {
-        Heap::String *e = entries[idx];
-        Q_ASSERT(e);
+    while (Heap::String *e = entries[idx]) {
         if (e->identifier == i)
             return e;
         ++idx;
         idx %= alloc;
     }
+
+    // shared identifiers only get a string in this engine once somebody asks for one
+    Q_ASSERT(shared && shared->contains(i));
+    Heap::String *str = engine->newString(i->string);
+    str->stringHash = i->hashValue;
+    str->subtype = Heap::String::StringType_Regular;
+    addEntry(str, i);
+    return str;
 }
 
 Identifier *IdentifierTable::identifier(const QString &s)
 {
+    if (shared) {
+        uint subtype;
+        uint hash = String::createHashValue(s.constData(), s.length(), &subtype);
+        if (Heap::String *e = lookup(s, hash))
+            return e->identifier;
+        if (subtype == Heap::String::StringType_ArrayIndex)
+            return 0;
+        if (Identifier *identifier = shared->lookup(s, hash))
+            return identifier;
+    }
     return insertString(s)->identifier;
 }
 
@@ -196,6 +383,11 @@ Identifier *IdentifierTable::identifier(const char *s, int len)
         idx %= alloc;
     }
 
+    if (shared && subtype != Heap::String::StringType_ArrayIndex) {
+        if (Identifier *identifier = shared->lookup(latin, hash))
+            return identifier;
+    }
+
     Heap::String *str = engine->newString(QString::fromLatin1(s, len));
     str->stringHash = hash;
     str->subtype = subtype;
@@ -53,32 +53,87 @@
 #include "qv4identifier_p.h"
 #include "qv4string_p.h"
 #include "qv4engine_p.h"
+#include <QtCore/qatomic.h>
+#include <QtCore/qmutex.h>
 #include <limits.h>
 
 QT_BEGIN_NAMESPACE
 
 namespace QV4 {
 
+namespace CompiledData {
+struct Unit;
+}
+
+// A process wide set of identifiers that engines consult before creating identifiers of
+// their own, so that engines running the same code share them instead of keeping a copy
+// each. Identifiers are only ever added, and never move once they are in the table, so
+// lookups don't need to lock. Enabled by setting QV4_SHARED_IDENTIFIERS, or setEnabled(),
+// for the engines created afterwards.
+struct Q_QML_PRIVATE_EXPORT SharedIdentifierTable
+{
+    SharedIdentifierTable();
+    ~SharedIdentifierTable();
+
+    static SharedIdentifierTable *instance();
+    static void setEnabled(bool enabled);
+
+    Identifier *lookup(const QString &s, uint hash) const;
+    Identifier *lookup(const QLatin1String &s, uint hash) const;
+    bool contains(const Identifier *identifier) const {
+        return lookup(identifier->string, identifier->hashValue) == identifier;
+    }
+
+    void insert(const CompiledData::Unit *unit);
+    int size() const { return totalSize.load(); }
+
+private:
+    // Instead of being rehashed into a bigger copy, the table grows by adding a level twice
+    // the size of the previous one. Levels and slots are published with release stores, so
+    // readers see complete entries without any of them being copied or retired.
+    struct Level {
+        int alloc;
+        int size;
+        int numBits;
+        QAtomicPointer<Identifier> *entries;
+    };
+    enum { MaxLevels = 22 };
+
+    static Level *newLevel(int numBits);
+    template <typename S>
+    Identifier *find(const S &s, uint hash) const;
+    void addEntry(Identifier *identifier);
+
+    QAtomicPointer<Level> levels[MaxLevels];
+    QAtomicInt levelCount;
+    QAtomicInt totalSize;
+    QMutex writeLock;
+};
+
 struct IdentifierTable
 {
     ExecutionEngine *engine;
+    SharedIdentifierTable *shared;
 
     int alloc;
     int size;
     int numBits;
     Heap::String **entries;
 
-    void addEntry(Heap::String *str);
+    void addEntry(Heap::String *str, Identifier *identifier = nullptr);
+    Heap::String *lookup(const QString &s, uint hash) const;
 
 public:
 
     IdentifierTable(ExecutionEngine *engine);
     ~IdentifierTable();
 
+    SharedIdentifierTable *sharedTable() const { return shared; }
+
     Heap::String *insertString(const QString &s);
 
     Identifier *identifier(const Heap::String *str) {
-        if (str->identifier)
+        if (!str->largestSubLength && str->identifier)
             return str->identifier;
         return identifierImpl(str);
     }
@@ -44,6 +44,8 @@
 #include "qv4object_p.h"
 #include "qv4identifiertable_p.h"
 
+#include <QtCore/qset.h>
+
 QT_BEGIN_NAMESPACE
 
 using namespace QV4;
@@ -146,12 +148,47 @@ void InternalClass::changeMember(Object *object, String *string, PropertyAttribu
 
 InternalClassTransition &InternalClass::lookupOrInsertTransition(const InternalClassTransition &t)
 {
-    std::vector<Transition>::iterator it = std::lower_bound(transitions.begin(), transitions.end(), t);
-    if (it != transitions.end() && *it == t) {
-        return *it;
-    } else {
-        it = transitions.insert(it, t);
-        return *it;
+    if (transitionIndex.empty()) {
+        for (Transition &existing : transitions) {
+            if (existing == t)
+                return existing;
+        }
+        transitions.push_back(t);
+        if (transitions.size() > LinearTransitionLimit)
+            rebuildTransitionIndex();
+        return transitions.back();
+    }
+
+    const uint mask = uint(transitionIndex.size()) - 1;
+    uint idx = t.hash() & mask;
+    while (uint entry = transitionIndex[idx]) {
+        if (transitions[entry - 1] == t)
+            return transitions[entry - 1];
+        idx = (idx + 1) & mask;
+    }
+
+    transitions.push_back(t);
+    // fill up to max 50%
+    if (transitions.size() * 2 > transitionIndex.size())
+        rebuildTransitionIndex();
+    else
+        transitionIndex[idx] = uint(transitions.size());
+    return transitions.back();
+}
+
+void InternalClass::rebuildTransitionIndex()
+{
+    size_t alloc = 32;
+    while (alloc < transitions.size() * 4)
+        alloc *= 2;
+    transitionIndex.assign(alloc, 0);
+
+    const uint mask = uint(alloc) - 1;
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        uint idx = transitions[i].hash() & mask;
+        while (transitionIndex[idx])
+            idx = (idx + 1) & mask;
+        transitionIndex[idx] = uint(i + 1);
     }
 }
 
@@ -172,13 +209,21 @@ InternalClass *InternalClass::changeMember(Identifier *identifier, PropertyAttri
     if (t.lookup)
         return t.lookup;
 
-    // create a new class and add it to the tree
-    InternalClass *newClass = engine->emptyClass;
-    for (uint i = 0; i < size; ++i) {
-        if (i == idx) {
-            newClass = newClass->addMember(nameMap.at(i), data);
-        } else if (!propertyData.at(i).isEmpty()) {
-            newClass = newClass->addMember(nameMap.at(i), propertyData.at(i));
+    InternalClass *newClass;
+    if (extensible && data.isAccessor() == propertyData.at(idx).isAccessor()) {
+        // The layout stays the same, so the new class can share the property table and the
+        // name map with this one and only needs its own attributes.
+        newClass = engine->newClass(*this);
+        newClass->propertyData.set(idx, data, size);
+    } else {
+        // create a new class and add it to the tree
+        newClass = engine->emptyClass;
+        for (uint i = 0; i < size; ++i) {
+            if (i == idx) {
+                newClass = newClass->addMember(nameMap.at(i), data);
+            } else if (!propertyData.at(i).isEmpty()) {
+                newClass = newClass->addMember(nameMap.at(i), propertyData.at(i));
+            }
         }
     }
 
@@ -385,9 +430,58 @@ void InternalClass::destroy()
         }
 
         next->transitions.~vector<Transition>();
+        next->transitionIndex.~vector<uint>();
     }
 }
 
+InternalClassStatistics InternalClass::statistics(const InternalClass *root)
+{
+    InternalClassStatistics stats = { 0, 0, 0 };
+
+    // Several transitions can lead to the same class, and classes share their property
+    // tables, so remember what was already counted.
+    QSet<const void *> seen;
+    std::vector<const InternalClass *> stack;
+    stack.push_back(root);
+    seen.insert(root);
+
+    while (!stack.empty()) {
+        const InternalClass *ic = stack.back();
+        stack.pop_back();
+
+        ++stats.classCount;
+        stats.transitionCount += uint(ic->transitions.size());
+        stats.memoryUsage += sizeof(InternalClass)
+                + ic->transitions.capacity() * sizeof(Transition)
+                + ic->transitionIndex.capacity() * sizeof(uint);
+
+        const PropertyHashData *table = ic->propertyTable.d;
+        if (!seen.contains(table)) {
+            seen.insert(table);
+            stats.memoryUsage += sizeof(PropertyHashData) + table->alloc * sizeof(PropertyHash::Entry);
+        }
+        const auto *names = ic->nameMap.d;
+        if (!seen.contains(names)) {
+            seen.insert(names);
+            stats.memoryUsage += sizeof(*names) + names->alloc * sizeof(Identifier *);
+        }
+        const auto *attributes = ic->propertyData.d;
+        if (!seen.contains(attributes)) {
+            seen.insert(attributes);
+            stats.memoryUsage += sizeof(*attributes) + attributes->alloc * sizeof(PropertyAttributes);
+        }
+
+        for (const Transition &t : ic->transitions) {
+            if (!seen.contains(t.lookup)) {
+                seen.insert(t.lookup);
+                stack.push_back(t.lookup);
+            }
+        }
+    }
+
+    return stats;
+}
+
 void InternalClassPool::markObjects(ExecutionEngine *engine)
 {
     Q_UNUSED(engine);
@@ -190,13 +190,15 @@ struct SharedInternalClassData {
         ++d->size;
     }
 
-    void set(uint pos, T value) {
-        Q_ASSERT(pos < d->size);
+    // size is the number of entries used by the owning class; the shared
+    // data can hold more entries that belong to one of its children.
+    void set(uint pos, T value, uint size) {
+        Q_ASSERT(pos < size && size <= d->size);
         if (d->refcount > 1) {
             // need to detach
-            Private *dd = new Private(d->alloc);
-            memcpy(dd->data, d->data, d->size*sizeof(T));
-            dd->size = d->size;
+            Private *dd = new Private(size + 8);
+            memcpy(dd->data, d->data, size*sizeof(T));
+            dd->size = size;
             if (!--d->refcount)
                 delete d;
             d = dd;
@@ -233,8 +235,15 @@ struct InternalClassTransition
     bool operator==(const InternalClassTransition &other) const
     { return id == other.id && flags == other.flags; }
 
-    bool operator<(const InternalClassTransition &other) const
-    { return id < other.id || (id == other.id && flags < other.flags); }
+    uint hash() const
+    { return (id ? id->hashValue : 0) ^ (uint(flags) * 0x9e3779b9u); }
+};
+
+struct InternalClassStatistics
+{
+    uint classCount;
+    uint transitionCount;
+    size_t memoryUsage; // in bytes, counting shared property tables only once
 };
 
 struct InternalClass : public QQmlJS::Managed {
@@ -246,6 +255,9 @@ struct InternalClass : public QQmlJS::Managed {
 
     typedef InternalClassTransition Transition;
     std::vector<Transition> transitions;
+    // Open addressed index into transitions, holding position + 1. Classes with few transitions
+    // are searched linearly and don't have one.
+    std::vector<uint> transitionIndex;
     InternalClassTransition &lookupOrInsertTransition(const InternalClassTransition &t);
 
     InternalClass *m_sealed;
@@ -270,7 +282,11 @@ struct InternalClass : public QQmlJS::Managed {
 
     void destroy();
 
+    static InternalClassStatistics statistics(const InternalClass *root);
+
 private:
+    enum { LinearTransitionLimit = 8 };
+    void rebuildTransitionIndex();
     InternalClass *addMemberImpl(Identifier *identifier, PropertyAttributes data, uint *index);
     friend struct ExecutionEngine;
     InternalClass(ExecutionEngine *engine);
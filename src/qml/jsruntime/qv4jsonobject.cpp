@@ -49,9 +49,15 @@
 
 #include <qstack.h>
 #include <qstringlist.h>
+#include <qalgorithms.h>
+#include <qvarlengtharray.h>
+#include <private/qsimd_p.h>
 
 #include <wtf/MathExtras.h>
 
+#include <algorithm>
+#include <iterator>
+
 using namespace QV4;
 
 //#define PARSER_DEBUG
@@ -72,10 +78,15 @@ DEFINE_OBJECT_VTABLE(JsonObject);
 static const int nestingLimit = 1024;
 
 
+JsonObjectBuilder::JsonObjectBuilder(ExecutionEngine *engine)
+    : engine(engine)
+{
+    memset(keyCache, 0, sizeof(keyCache));
+}
+
 JsonParser::JsonParser(ExecutionEngine *engine, const QChar *json, int length)
-    : engine(engine), head(json), json(json), nestingLevel(0), lastError(QJsonParseError::NoError)
+    : JsonGrammar(json, length), engine(engine), builder(engine)
 {
-    end = json + length;
 }
 
 
@@ -120,304 +131,165 @@ enum {
     Quote = 0x22
 };
 
-bool JsonParser::eatSpace()
-{
-    while (json < end) {
-        if (*json > Space)
-            break;
-        if (*json != Space &&
-            *json != Tab &&
-            *json != LineFeed &&
-            *json != Return)
-            break;
-        ++json;
-    }
-    return (json < end);
-}
-
-QChar JsonParser::nextToken()
+static inline bool isWhitespace(QChar c)
 {
-    if (!eatSpace())
-        return 0;
-    QChar token = *json++;
-    switch (token.unicode()) {
-    case BeginArray:
-    case BeginObject:
-    case NameSeparator:
-    case ValueSeparator:
-    case EndArray:
-    case EndObject:
-        eatSpace();
-    case Quote:
-        break;
-    default:
-        token = 0;
-        break;
-    }
-    return token;
+    return c == Space || c == Tab || c == LineFeed || c == Return;
 }
 
-/*
-    JSON-text = object / array
-*/
-ReturnedValue JsonParser::parse(QJsonParseError *error)
+// Returns the first character in [ch, end) that isn't JSON whitespace
+static inline const QChar *skipWhitespace(const QChar *ch, const QChar *end)
 {
-#ifdef PARSER_DEBUG
-    indent = 0;
-    qDebug() << ">>>>> parser begin";
-#endif
-
-    eatSpace();
-
-    Scope scope(engine);
-    ScopedValue v(scope);
-    if (!parseValue(v)) {
-#ifdef PARSER_DEBUG
-        qDebug() << ">>>>> parser error";
-#endif
-        if (lastError == QJsonParseError::NoError)
-            lastError = QJsonParseError::IllegalValue;
-        error->offset = json - head;
-        error->error  = lastError;
-        return Encode::undefined();
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi16(Space);
+    const __m128i tab = _mm_set1_epi16(Tab);
+    const __m128i lineFeed = _mm_set1_epi16(LineFeed);
+    const __m128i carriageReturn = _mm_set1_epi16(Return);
+    while (end - ch >= 8) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ch));
+        const __m128i whitespace = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi16(data, space), _mm_cmpeq_epi16(data, tab)),
+                    _mm_or_si128(_mm_cmpeq_epi16(data, lineFeed), _mm_cmpeq_epi16(data, carriageReturn)));
+        const uint mask = ~uint(_mm_movemask_epi8(whitespace)) & 0xffff;
+        if (mask)
+            return ch + qCountTrailingZeroBits(mask) / 2;
+        ch += 8;
     }
-
-    // some input left...
-    if (eatSpace()) {
-        lastError = QJsonParseError::IllegalValue;
-        error->offset = json - head;
-        error->error  = lastError;
-        return Encode::undefined();
+#elif defined(__ARM_NEON__) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const uint16x8_t space = vdupq_n_u16(Space);
+    const uint16x8_t tab = vdupq_n_u16(Tab);
+    const uint16x8_t lineFeed = vdupq_n_u16(LineFeed);
+    const uint16x8_t carriageReturn = vdupq_n_u16(Return);
+    while (end - ch >= 8) {
+        const uint16x8_t data = vld1q_u16(reinterpret_cast<const uint16_t *>(ch));
+        const uint16x8_t whitespace = vorrq_u16(
+                    vorrq_u16(vceqq_u16(data, space), vceqq_u16(data, tab)),
+                    vorrq_u16(vceqq_u16(data, lineFeed), vceqq_u16(data, carriageReturn)));
+        const quint64 mask = ~vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(whitespace)), 0);
+        if (mask)
+            return ch + qCountTrailingZeroBits(mask) / 8;
+        ch += 8;
     }
-
-    END;
-    error->offset = 0;
-    error->error = QJsonParseError::NoError;
-    return v->asReturnedValue();
+#endif
+    while (ch < end && isWhitespace(*ch))
+        ++ch;
+    return ch;
 }
 
-/*
-    object = begin-object [ member *( value-separator member ) ]
-    end-object
-*/
-
-ReturnedValue JsonParser::parseObject()
+// Returns the first character in [ch, end) that ends a run of characters that can be copied
+// verbatim into or out of a JSON string: a quote, a backslash or a control character
+static inline const QChar *scanUnescaped(const QChar *ch, const QChar *end)
 {
-    if (++nestingLevel > nestingLimit) {
-        lastError = QJsonParseError::DeepNesting;
-        return Encode::undefined();
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi16('"');
+    const __m128i backslash = _mm_set1_epi16('\\');
+    const __m128i lastControl = _mm_set1_epi16(0x1f);
+    const __m128i zero = _mm_setzero_si128();
+    while (end - ch >= 8) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ch));
+        // unsigned data <= 0x1f, by saturating the subtraction at zero
+        const __m128i control = _mm_cmpeq_epi16(_mm_subs_epu16(data, lastControl), zero);
+        const __m128i special = _mm_or_si128(control,
+                    _mm_or_si128(_mm_cmpeq_epi16(data, quote), _mm_cmpeq_epi16(data, backslash)));
+        const uint mask = uint(_mm_movemask_epi8(special));
+        if (mask)
+            return ch + qCountTrailingZeroBits(mask) / 2;
+        ch += 8;
     }
-
-    BEGIN << "parseObject pos=" << json;
-    Scope scope(engine);
-
-    ScopedObject o(scope, engine->newObject());
-
-    QChar token = nextToken();
-    while (token == Quote) {
-        if (!parseMember(o))
-            return Encode::undefined();
-        token = nextToken();
-        if (token != ValueSeparator)
-            break;
-        token = nextToken();
-        if (token == EndObject) {
-            lastError = QJsonParseError::MissingObject;
-            return Encode::undefined();
-        }
+#elif defined(__ARM_NEON__) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const uint16x8_t quote = vdupq_n_u16('"');
+    const uint16x8_t backslash = vdupq_n_u16('\\');
+    const uint16x8_t lastControl = vdupq_n_u16(0x1f);
+    while (end - ch >= 8) {
+        const uint16x8_t data = vld1q_u16(reinterpret_cast<const uint16_t *>(ch));
+        const uint16x8_t special = vorrq_u16(vcleq_u16(data, lastControl),
+                    vorrq_u16(vceqq_u16(data, quote), vceqq_u16(data, backslash)));
+        const quint64 mask = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(special)), 0);
+        if (mask)
+            return ch + qCountTrailingZeroBits(mask) / 8;
+        ch += 8;
     }
-
-    DEBUG << "end token=" << token;
-    if (token != EndObject) {
-        lastError = QJsonParseError::UnterminatedObject;
-        return Encode::undefined();
+#endif
+    while (ch < end) {
+        const ushort c = ch->unicode();
+        if (c == '"' || c == '\\' || c <= 0x1f)
+            break;
+        ++ch;
     }
-
-    END;
-
-    --nestingLevel;
-    return o.asReturnedValue();
+    return ch;
 }
 
-/*
-    member = string name-separator value
-*/
-bool JsonParser::parseMember(Object *o)
+ReturnedValue JsonObjectBuilder::createObject(int nestingLevel, const Value *members, int count)
 {
-    BEGIN << "parseMember";
     Scope scope(engine);
 
-    QString key;
-    if (!parseString(&key))
-        return false;
-    QChar token = nextToken();
-    if (token != NameSeparator) {
-        lastError = QJsonParseError::MissingNameSeparator;
-        return false;
-    }
-    ScopedValue val(scope);
-    if (!parseValue(val))
-        return false;
-
-    ScopedString s(scope, engine->newIdentifier(key));
-    uint idx = s->asArrayIndex();
-    if (idx < UINT_MAX) {
-        o->putIndexed(idx, val);
+    const auto key = [members](int i) {
+        return static_cast<Heap::String *>(members[2 * i].heapObject());
+    };
+
+    InternalClass *ic = nullptr;
+    if (nestingLevel >= shapes.size())
+        shapes.resize(nestingLevel + 1);
+    Shape &shape = shapes[nestingLevel];
+    bool sameKeys = shape.internalClass && shape.keys.size() == count;
+    for (int i = 0; sameKeys && i < count; ++i)
+        sameKeys = (key(i) == shape.keys.at(i));
+    if (sameKeys) {
+        ic = shape.internalClass;
     } else {
-        o->insertMember(s, val);
-    }
-
-    END;
-    return true;
-}
-
-/*
-    array = begin-array [ value *( value-separator value ) ] end-array
-*/
-ReturnedValue JsonParser::parseArray()
-{
-    Scope scope(engine);
-    BEGIN << "parseArray";
-    ScopedArrayObject array(scope, engine->newArrayObject());
-
-    if (++nestingLevel > nestingLimit) {
-        lastError = QJsonParseError::DeepNesting;
-        return Encode::undefined();
-    }
-
-    if (!eatSpace()) {
-        lastError = QJsonParseError::UnterminatedArray;
-        return Encode::undefined();
-    }
-    if (*json == EndArray) {
-        nextToken();
-    } else {
-        uint index = 0;
-        while (1) {
-            ScopedValue val(scope);
-            if (!parseValue(val))
-                return Encode::undefined();
-            array->arraySet(index, val);
-            QChar token = nextToken();
-            if (token == EndArray)
+        ic = engine->emptyClass;
+        for (int i = 0; i < count; ++i) {
+            Identifier *id = key(i)->identifier;
+            // array indices and duplicate keys need the generic path
+            if (!id || ic->find(id) != UINT_MAX) {
+                ic = nullptr;
                 break;
-            else if (token != ValueSeparator) {
-                if (!eatSpace())
-                    lastError = QJsonParseError::UnterminatedArray;
-                else
-                    lastError = QJsonParseError::MissingValueSeparator;
-                return Encode::undefined();
             }
-            ++index;
+            ic = ic->addMember(id, Attr_Data);
+        }
+        if (ic) {
+            // All of these keys have an identifier, so the identifier table keeps them alive
+            shape.keys = QVector<Heap::String *>();
+            shape.keys.reserve(count);
+            for (int i = 0; i < count; ++i)
+                shape.keys.append(key(i));
+            shape.internalClass = ic;
         }
     }
 
-    DEBUG << "size =" << array->getLength();
-    END;
+    if (ic) {
+        ScopedObject o(scope, engine->newObject(ic, engine->objectPrototype()));
+        for (int i = 0; i < count; ++i)
+            o->setProperty(scope.engine, i, members[2 * i + 1]);
+        return o.asReturnedValue();
+    }
 
-    --nestingLevel;
-    return array.asReturnedValue();
+    ScopedObject o(scope, engine->newObject());
+    ScopedString s(scope);
+    for (int i = 0; i < count; ++i) {
+        s = key(i);
+        uint idx = s->asArrayIndex();
+        if (idx < UINT_MAX)
+            o->putIndexed(idx, members[2 * i + 1]);
+        else
+            o->insertMember(s, members[2 * i + 1]);
+    }
+    return o.asReturnedValue();
 }
 
-/*
-value = false / null / true / object / array / number / string
-
-*/
-
-bool JsonParser::parseValue(Value *val)
+Heap::String *JsonObjectBuilder::keyIdentifier(const QChar *key, int length)
 {
-    BEGIN << "parse Value" << *json;
-
-    switch ((json++)->unicode()) {
-    case 'n':
-        if (end - json < 3) {
-            lastError = QJsonParseError::IllegalValue;
-            return false;
-        }
-        if (*json++ == 'u' &&
-            *json++ == 'l' &&
-            *json++ == 'l') {
-            *val = Primitive::nullValue();
-            DEBUG << "value: null";
-            END;
-            return true;
-        }
-        lastError = QJsonParseError::IllegalValue;
-        return false;
-    case 't':
-        if (end - json < 3) {
-            lastError = QJsonParseError::IllegalValue;
-            return false;
-        }
-        if (*json++ == 'r' &&
-            *json++ == 'u' &&
-            *json++ == 'e') {
-            *val = Primitive::fromBoolean(true);
-            DEBUG << "value: true";
-            END;
-            return true;
-        }
-        lastError = QJsonParseError::IllegalValue;
-        return false;
-    case 'f':
-        if (end - json < 4) {
-            lastError = QJsonParseError::IllegalValue;
-            return false;
-        }
-        if (*json++ == 'a' &&
-            *json++ == 'l' &&
-            *json++ == 's' &&
-            *json++ == 'e') {
-            *val = Primitive::fromBoolean(false);
-            DEBUG << "value: false";
-            END;
-            return true;
-        }
-        lastError = QJsonParseError::IllegalValue;
-        return false;
-    case Quote: {
-        QString value;
-        if (!parseString(&value))
-            return false;
-        DEBUG << "value: string";
-        END;
-        *val = Value::fromHeapObject(engine->newString(value));
-        return true;
-    }
-    case BeginArray: {
-        *val = parseArray();
-        if (val->isUndefined())
-            return false;
-        DEBUG << "value: array";
-        END;
-        return true;
-    }
-    case BeginObject: {
-        *val = parseObject();
-        if (val->isUndefined())
-            return false;
-        DEBUG << "value: object";
-        END;
-        return true;
-    }
-    case EndArray:
-        lastError = QJsonParseError::MissingObject;
-        return false;
-    default:
-        --json;
-        if (!parseNumber(val))
-            return false;
-        DEBUG << "value: number";
-        END;
-    }
-
-    return true;
+    uint hash = String::createHashValue(key, length, nullptr);
+    Heap::String *&cached = keyCache[hash % KeyCacheSize];
+    if (cached && cached->len == uint(length)
+            && !memcmp(cached->text->data(), key, length * sizeof(QChar)))
+        return cached;
+    Heap::String *str = engine->newIdentifier(QString(key, length));
+    // Array indices don't go into the identifier table, and may be collected
+    if (str->identifier)
+        cached = str;
+    return str;
 }
 
-
-
-
-
 /*
         number = [ minus ] int [ frac ] [ exp ]
         decimal-point = %x2E       ; .
@@ -432,7 +304,7 @@ bool JsonParser::parseValue(Value *val)
 
 */
 
-bool JsonParser::parseNumber(Value *val)
+static bool scanNumber(const QChar *&json, const QChar *end, Value *val)
 {
     BEGIN << "parseNumber" << *json;
 
@@ -469,6 +341,27 @@ bool JsonParser::parseNumber(Value *val)
             ++json;
     }
 
+    // Small integers are by far the most common numbers, and don't need a QString
+    if (isInt) {
+        const QChar *ch = start;
+        const bool negative = (*ch == '-');
+        if (negative)
+            ++ch;
+        if (json > ch && json - ch <= 9) {
+            int n = 0;
+            for (; ch < json; ++ch)
+                n = n * 10 + (ch->unicode() - '0');
+            if (negative)
+                n = -n;
+            if (n < (1<<25) && n > -(1<<25))
+                *val = Primitive::fromInt32(n);
+            else
+                *val = Primitive::fromDouble(n);
+            END;
+            return true;
+        }
+    }
+
     QString number(start, json - start);
     DEBUG << "numberstring" << number;
 
@@ -486,10 +379,8 @@ bool JsonParser::parseNumber(Value *val)
     double d;
     d = number.toDouble(&ok);
 
-    if (!ok) {
-        lastError = QJsonParseError::IllegalNumber;
+    if (!ok)
         return false;
-    }
 
     * val = Primitive::fromDouble(d);
 
@@ -577,17 +468,29 @@ static inline bool scanEscapeSequence(const QChar *&json, const QChar *end, uint
 }
 
 
-bool JsonParser::parseString(QString *string)
+static bool scanString(const QChar *&json, const QChar *end, QString *string,
+                       QJsonParseError::ParseError *error)
 {
     BEGIN << "parse string stringPos=" << json;
 
     while (json < end) {
-        if (*json == '"')
+        const QChar *run = json;
+        json = scanUnescaped(json, end);
+        if (json != run) {
+            if (string->isEmpty() && json < end && *json == '"')
+                *string = QString(run, json - run);
+            else
+                string->append(run, json - run);
+        }
+        if (json >= end)
             break;
-        else if (*json == '\\') {
+
+        if (*json == '"') {
+            break;
+        } else if (*json == '\\') {
             uint ch = 0;
             if (!scanEscapeSequence(json, end, &ch)) {
-                lastError = QJsonParseError::IllegalEscapeSequence;
+                *error = QJsonParseError::IllegalEscapeSequence;
                 return false;
             }
             if (QChar::requiresSurrogates(ch)) {
@@ -596,26 +499,451 @@ bool JsonParser::parseString(QString *string)
                 *string += QChar(ch);
             }
         } else {
-            if (json->unicode() <= 0x1f) {
-                lastError = QJsonParseError::IllegalEscapeSequence;
-                return false;
-            }
-            *string += *json;
-            ++json;
+            // control characters have to be escaped
+            *error = QJsonParseError::IllegalEscapeSequence;
+            return false;
         }
     }
     ++json;
 
     if (json > end) {
-        lastError = QJsonParseError::UnterminatedString;
+        *error = QJsonParseError::UnterminatedString;
+        return false;
+    }
+
+    END;
+    return true;
+}
+
+template <typename Derived, typename Slot>
+bool JsonGrammar<Derived, Slot>::eatSpace()
+{
+    // compact JSON has no whitespace at all, don't bother with the vector loop for it
+    if (json < end && !isWhitespace(*json))
+        return true;
+    json = skipWhitespace(json, end);
+    return (json < end);
+}
+
+template <typename Derived, typename Slot>
+QChar JsonGrammar<Derived, Slot>::nextToken()
+{
+    if (!eatSpace())
+        return 0;
+    QChar token = *json++;
+    switch (token.unicode()) {
+    case BeginArray:
+    case BeginObject:
+    case NameSeparator:
+    case ValueSeparator:
+    case EndArray:
+    case EndObject:
+        eatSpace();
+    case Quote:
+        break;
+    default:
+        token = 0;
+        break;
+    }
+    return token;
+}
+
+/*
+    JSON-text = object / array
+*/
+template <typename Derived, typename Slot>
+bool JsonGrammar<Derived, Slot>::parseDocument(Slot result, QJsonParseError *error)
+{
+#ifdef PARSER_DEBUG
+    indent = 0;
+    qDebug() << ">>>>> parser begin";
+#endif
+
+    eatSpace();
+
+    if (!parseValue(result)) {
+#ifdef PARSER_DEBUG
+        qDebug() << ">>>>> parser error";
+#endif
+        if (lastError == QJsonParseError::NoError)
+            lastError = QJsonParseError::IllegalValue;
+    } else if (eatSpace()) {
+        // some input left...
+        lastError = QJsonParseError::IllegalValue;
+    }
+
+    if (lastError != QJsonParseError::NoError) {
+        error->offset = json - head;
+        error->error = lastError;
+        return false;
+    }
+
+    error->offset = 0;
+    error->error = QJsonParseError::NoError;
+    return true;
+}
+
+/*
+    object = begin-object [ member *( value-separator member ) ]
+    end-object
+
+    member = string name-separator value
+*/
+template <typename Derived, typename Slot>
+bool JsonGrammar<Derived, Slot>::parseObject(Slot val)
+{
+    if (++nestingLevel > nestingLimit) {
+        lastError = QJsonParseError::DeepNesting;
+        return false;
+    }
+
+    BEGIN << "parseObject pos=" << json;
+    typename Derived::Members members(derived());
+
+    QChar token = nextToken();
+    while (token == Quote) {
+        Slot key;
+        Slot value;
+        if (!members.add(&key, &value)) {
+            lastError = QJsonParseError::DocumentTooLarge;
+            return false;
+        }
+        if (!derived()->parseKey(key))
+            return false;
+        if (nextToken() != NameSeparator) {
+            lastError = QJsonParseError::MissingNameSeparator;
+            return false;
+        }
+        if (!parseValue(value))
+            return false;
+        token = nextToken();
+        if (token != ValueSeparator)
+            break;
+        token = nextToken();
+        if (token == EndObject) {
+            lastError = QJsonParseError::MissingObject;
+            return false;
+        }
+    }
+
+    DEBUG << "end token=" << token;
+    if (token != EndObject) {
+        lastError = QJsonParseError::UnterminatedObject;
         return false;
     }
 
     END;
+
+    --nestingLevel;
+    derived()->storeObject(val, members);
+    return true;
+}
+
+/*
+    array = begin-array [ value *( value-separator value ) ] end-array
+*/
+template <typename Derived, typename Slot>
+bool JsonGrammar<Derived, Slot>::parseArray(Slot val)
+{
+    if (++nestingLevel > nestingLimit) {
+        lastError = QJsonParseError::DeepNesting;
+        return false;
+    }
+
+    BEGIN << "parseArray";
+    typename Derived::Elements elements(derived());
+
+    if (!eatSpace()) {
+        lastError = QJsonParseError::UnterminatedArray;
+        return false;
+    }
+    if (*json == EndArray) {
+        nextToken();
+    } else {
+        while (1) {
+            if (!parseValue(elements.next()))
+                return false;
+            elements.append();
+            QChar token = nextToken();
+            if (token == EndArray)
+                break;
+            else if (token != ValueSeparator) {
+                if (!eatSpace())
+                    lastError = QJsonParseError::UnterminatedArray;
+                else
+                    lastError = QJsonParseError::MissingValueSeparator;
+                return false;
+            }
+        }
+    }
+
+    END;
+
+    --nestingLevel;
+    derived()->storeArray(val, elements);
     return true;
 }
 
+/*
+value = false / null / true / object / array / number / string
 
+*/
+template <typename Derived, typename Slot>
+bool JsonGrammar<Derived, Slot>::parseValue(Slot val)
+{
+    if (json >= end) {
+        lastError = QJsonParseError::IllegalValue;
+        return false;
+    }
+
+    DEBUG << "parse Value" << *json;
+
+    switch ((json++)->unicode()) {
+    case 'n':
+        return parseLiteral(val, "ull", 3, Primitive::nullValue());
+    case 't':
+        return parseLiteral(val, "rue", 3, Primitive::fromBoolean(true));
+    case 'f':
+        return parseLiteral(val, "alse", 4, Primitive::fromBoolean(false));
+    case Quote: {
+        QString string;
+        if (!parseString(&string))
+            return false;
+        derived()->storeString(val, string);
+        return true;
+    }
+    case BeginArray:
+        return parseArray(val);
+    case BeginObject:
+        return parseObject(val);
+    case EndArray:
+        lastError = QJsonParseError::MissingObject;
+        return false;
+    default: {
+        --json;
+        Value number;
+        if (!scanNumber(json, end, &number)) {
+            lastError = QJsonParseError::IllegalNumber;
+            return false;
+        }
+        derived()->storeValue(val, number);
+        return true;
+    }
+    }
+}
+
+template <typename Derived, typename Slot>
+bool JsonGrammar<Derived, Slot>::parseLiteral(Slot val, const char *rest, int length, const Value &value)
+{
+    if (end - json < length) {
+        lastError = QJsonParseError::IllegalValue;
+        return false;
+    }
+    for (int i = 0; i < length; ++i) {
+        if (*json++ != QLatin1Char(rest[i])) {
+            lastError = QJsonParseError::IllegalValue;
+            return false;
+        }
+    }
+    derived()->storeValue(val, value);
+    return true;
+}
+
+template <typename Derived, typename Slot>
+bool JsonGrammar<Derived, Slot>::parseString(QString *string)
+{
+    return scanString(json, end, string, &lastError);
+}
+
+
+ReturnedValue JsonParser::parse(QJsonParseError *error)
+{
+    Scope scope(engine);
+    ScopedValue v(scope);
+    if (!parseDocument(v, error))
+        return Encode::undefined();
+    return v->asReturnedValue();
+}
+
+bool JsonParser::Members::add(Value **key, Value **value)
+{
+    // Everything the nested parse calls allocate gets freed again before they return, so
+    // the pairs end up next to each other.
+    if (Q_UNLIKELY(scope.engine->jsStackTop + 1 >= scope.engine->jsStackLimit))
+        return false;
+    Value *member = scope.alloc(2);
+    if (!members)
+        members = member;
+    Q_ASSERT(member == members + 2 * count);
+    ++count;
+    *key = member;
+    *value = member + 1;
+    return true;
+}
+
+JsonParser::Elements::Elements(JsonParser *parser)
+    : scope(parser->engine)
+    , array(scope, parser->engine->newArrayObject())
+    , val(scope)
+{
+}
+
+void JsonParser::storeString(Value *val, const QString &string)
+{
+    *val = Value::fromHeapObject(engine->newString(string));
+}
+
+bool JsonParser::parseKey(Value *key)
+{
+    // keys rarely contain escape sequences, and can then be looked up in place
+    const QChar *start = json;
+    const QChar *stop = scanUnescaped(json, end);
+    if (stop < end && *stop == Quote) {
+        json = stop + 1;
+        *key = builder.keyIdentifier(start, stop - start);
+        return true;
+    }
+
+    QString string;
+    if (!parseString(&string))
+        return false;
+    *key = engine->newIdentifier(string);
+    return true;
+}
+
+void JsonParser::storeObject(Value *val, Members &members)
+{
+    *val = builder.createObject(nestingLevel, members.members, members.count);
+}
+
+
+namespace QV4 {
+
+// JsonTreeParser only records the values in the tree, in document order
+struct JsonTreeSlot {};
+
+class JsonTreeParser : public JsonGrammar<JsonTreeParser, JsonTreeSlot>
+{
+public:
+    JsonTreeParser(JsonTree *tree, const QChar *json, int length)
+        : JsonGrammar(json, length), tree(tree)
+    {}
+
+    bool parse(QJsonParseError *error) { return parseDocument(JsonTreeSlot(), error); }
+
+private:
+    friend class JsonGrammar<JsonTreeParser, JsonTreeSlot>;
+
+    int addNode(JsonTree::Node::Type type)
+    {
+        JsonTree::Node node;
+        node.type = type;
+        node.value = 0;
+        tree->nodes.append(node);
+        return tree->nodes.size() - 1;
+    }
+    void addString(JsonTree::Node::Type type, const QString &string)
+    {
+        tree->nodes[addNode(type)].string = tree->strings.size();
+        tree->strings.append(string);
+    }
+
+    // Objects and arrays are stored in front of their members, which have to be counted
+    struct Members {
+        Members(JsonTreeParser *parser) : node(parser->addNode(JsonTree::Node::Object)) {}
+        bool add(JsonTreeSlot *, JsonTreeSlot *) { ++size; return true; }
+
+        int node;
+        int size = 0;
+    };
+    struct Elements {
+        Elements(JsonTreeParser *parser) : node(parser->addNode(JsonTree::Node::Array)) {}
+        JsonTreeSlot next() { return JsonTreeSlot(); }
+        void append() { ++size; }
+
+        int node;
+        int size = 0;
+    };
+
+    void storeValue(JsonTreeSlot, const Value &value)
+    { tree->nodes[addNode(JsonTree::Node::Scalar)].value = value.rawValue(); }
+    void storeString(JsonTreeSlot, const QString &string)
+    { addString(JsonTree::Node::String, string); }
+    bool parseKey(JsonTreeSlot)
+    {
+        QString string;
+        if (!parseString(&string))
+            return false;
+        addString(JsonTree::Node::Key, string);
+        return true;
+    }
+    void storeObject(JsonTreeSlot, Members &members) { tree->nodes[members.node].size = members.size; }
+    void storeArray(JsonTreeSlot, Elements &elements) { tree->nodes[elements.node].size = elements.size; }
+
+    JsonTree *tree;
+};
+
+}
+
+JsonTree JsonTree::parse(const QString &json, QJsonParseError *error)
+{
+    JsonTree tree;
+    JsonTreeParser parser(&tree, json.constData(), json.length());
+    if (!parser.parse(error))
+        return JsonTree();
+    return tree;
+}
+
+ReturnedValue JsonTree::toValue(ExecutionEngine *engine) const
+{
+    Q_ASSERT(isValid());
+    JsonObjectBuilder builder(engine);
+    int node = 0;
+    return toValue(engine, builder, 0, &node);
+}
+
+ReturnedValue JsonTree::toValue(ExecutionEngine *engine, JsonObjectBuilder &builder, int nestingLevel, int *node) const
+{
+    const Node &n = nodes.at((*node)++);
+    switch (n.type) {
+    case Node::Scalar:
+        return n.value;
+    case Node::String:
+        return engine->newString(strings.at(n.string))->asReturnedValue();
+    case Node::Array: {
+        Scope scope(engine);
+        ScopedArrayObject array(scope, engine->newArrayObject());
+        ScopedValue val(scope);
+        for (int i = 0; i < n.size; ++i) {
+            val = toValue(engine, builder, nestingLevel + 1, node);
+            if (scope.hasException())
+                return Encode::undefined();
+            array->arraySet(i, val);
+        }
+        return array.asReturnedValue();
+    }
+    case Node::Object: {
+        Scope scope(engine);
+        if (Q_UNLIKELY(engine->jsStackTop + 2 * n.size >= engine->jsStackLimit))
+            return engine->throwRangeError(QStringLiteral("JSON.parse: Document too large"));
+        Value *members = scope.alloc(2 * n.size);
+        for (int i = 0; i < n.size; ++i) {
+            const QString &key = strings.at(nodes.at((*node)++).string);
+            members[2 * i] = builder.keyIdentifier(key.constData(), key.length());
+            members[2 * i + 1] = toValue(engine, builder, nestingLevel + 1, node);
+            if (scope.hasException())
+                return Encode::undefined();
+        }
+        return builder.createObject(nestingLevel, members, n.size);
+    }
+    case Node::Key:
+        break;
+    }
+    Q_UNREACHABLE();
+    return Encode::undefined();
+}
+
+// Writes the JSON text into a single buffer, instead of building a string for every value
 struct Stringify
 {
     ExecutionEngine *v4;
@@ -625,6 +953,7 @@ struct Stringify
     QString gap;
     QString indent;
     QStack<Object *> stack;
+    QString result;
 
     bool stackContains(Object *o) {
         for (int i = 0; i < stack.size(); ++i)
@@ -635,22 +964,28 @@ struct Stringify
 
     Stringify(ExecutionEngine *e) : v4(e), replacerFunction(0), propertyList(0), propertyListSize(0) {}
 
-    QString Str(const QString &key, const Value &v);
-    QString JA(ArrayObject *a);
-    QString JO(Object *o);
+    // These append to result, and return false if the value is undefined in JSON
+    bool Str(const QString &key, const Value &v);
+    void JA(ArrayObject *a);
+    void JO(Object *o);
 
-    QString makeMember(const QString &key, const Value &v);
+    bool makeMember(const QString &key, const Value &v, bool first);
 };
 
-static QString quote(const QString &str)
+static void quote(QString &product, const QString &str)
 {
-    QString product;
-    const int length = str.length();
-    product.reserve(length + 2);
+    const QChar *ch = str.constData();
+    const QChar *end = ch + str.length();
     product += QLatin1Char('"');
-    for (int i = 0; i < length; ++i) {
-        QChar c = str.at(i);
-        switch (c.unicode()) {
+    while (ch < end) {
+        const QChar *run = ch;
+        ch = scanUnescaped(ch, end);
+        product.append(run, ch - run);
+        if (ch == end)
+            break;
+
+        const ushort c = ch->unicode();
+        switch (c) {
         case '"':
             product += QLatin1String("\\\"");
             break;
@@ -673,20 +1008,17 @@ static QString quote(const QString &str)
             product += QLatin1String("\\t");
             break;
         default:
-            if (c.unicode() <= 0x1f) {
-                product += QLatin1String("\\u00");
-                product += (c.unicode() > 0xf ? QLatin1Char('1') : QLatin1Char('0')) +
-                        QLatin1Char("0123456789abcdef"[c.unicode() & 0xf]);
-            } else {
-                product += c;
-            }
+            Q_ASSERT(c <= 0x1f);
+            product += QLatin1String("\\u00");
+            product += (c > 0xf ? QLatin1Char('1') : QLatin1Char('0'));
+            product += QLatin1Char("0123456789abcdef"[c & 0xf]);
         }
+        ++ch;
     }
     product += QLatin1Char('"');
-    return product;
 }
 
-QString Stringify::Str(const QString &key, const Value &v)
+bool Stringify::Str(const QString &key, const Value &v)
 {
     Scope scope(v4);
     scope.result = v;
@@ -723,64 +1055,84 @@ QString Stringify::Str(const QString &key, const Value &v)
             scope.result = Encode(b->value());
     }
 
-    if (scope.result.isNull())
-        return QStringLiteral("null");
-    if (scope.result.isBoolean())
-        return scope.result.booleanValue() ? QStringLiteral("true") : QStringLiteral("false");
-    if (String *s = scope.result.stringValue())
-        return quote(s->toQString());
+    if (scope.result.isNull()) {
+        result += QLatin1String("null");
+        return true;
+    }
+    if (scope.result.isBoolean()) {
+        result += scope.result.booleanValue() ? QLatin1String("true") : QLatin1String("false");
+        return true;
+    }
+    if (String *s = scope.result.stringValue()) {
+        quote(result, s->toQString());
+        return true;
+    }
 
     if (scope.result.isNumber()) {
         double d = scope.result.toNumber();
-        return std::isfinite(d) ? scope.result.toQString() : QStringLiteral("null");
+        if (std::isfinite(d))
+            result += scope.result.toQString();
+        else
+            result += QLatin1String("null");
+        return true;
     }
 
     if (const QV4::VariantObject *v = scope.result.as<QV4::VariantObject>()) {
-        return v->d()->data().toString();
+        const QString s = v->d()->data().toString();
+        result += s;
+        return !s.isEmpty();
     }
 
     o = scope.result.asReturnedValue();
     if (o) {
         if (!o->as<FunctionObject>()) {
             if (o->as<ArrayObject>()) {
-                return JA(static_cast<ArrayObject *>(o.getPointer()));
+                JA(static_cast<ArrayObject *>(o.getPointer()));
             } else {
-                return JO(o);
+                JO(o);
             }
+            return true;
         }
     }
 
-    return QString();
+    return false;
 }
 
-QString Stringify::makeMember(const QString &key, const Value &v)
+bool Stringify::makeMember(const QString &key, const Value &v, bool first)
 {
-    QString strP = Str(key, v);
-    if (!strP.isEmpty()) {
-        QString member = quote(key) + QLatin1Char(':');
-        if (!gap.isEmpty())
-            member += QLatin1Char(' ');
-        member += strP;
-        return member;
-    }
-    return QString();
+    const int position = result.size();
+    if (!first)
+        result += QLatin1Char(',');
+    if (!gap.isEmpty()) {
+        result += QLatin1Char('\n');
+        result += indent;
+    }
+    quote(result, key);
+    result += QLatin1Char(':');
+    if (!gap.isEmpty())
+        result += QLatin1Char(' ');
+    if (Str(key, v))
+        return true;
+    // undefined members are left out
+    result.truncate(position);
+    return false;
 }
 
-QString Stringify::JO(Object *o)
+void Stringify::JO(Object *o)
 {
     if (stackContains(o)) {
         v4->throwTypeError();
-        return QString();
+        return;
     }
 
     Scope scope(v4);
 
-    QString result;
     stack.push(o);
     QString stepback = indent;
     indent += gap;
 
-    QStringList partial;
+    result += QLatin1Char('{');
+    bool empty = true;
     if (!propertyListSize) {
         ObjectIterator it(scope, o, ObjectIterator::EnumerableOnly);
         ScopedValue name(scope);
@@ -791,9 +1143,8 @@ QString Stringify::JO(Object *o)
             if (name->isNull())
                 break;
             QString key = name->toQString();
-            QString member = makeMember(key, val);
-            if (!member.isEmpty())
-                partial += member;
+            if (makeMember(key, val, empty))
+                empty = false;
         }
     } else {
         ScopedValue v(scope);
@@ -805,70 +1156,68 @@ QString Stringify::JO(Object *o)
             v = o->get(s, &exists);
             if (!exists)
                 continue;
-            QString member = makeMember(s->toQString(), v);
-            if (!member.isEmpty())
-                partial += member;
+            if (makeMember(s->toQString(), v, empty))
+                empty = false;
         }
     }
 
-    if (partial.isEmpty()) {
-        result = QStringLiteral("{}");
-    } else if (gap.isEmpty()) {
-        result = QLatin1Char('{') + partial.join(QLatin1Char(',')) + QLatin1Char('}');
-    } else {
-        QString separator = QLatin1String(",\n") + indent;
-        result = QLatin1String("{\n") + indent + partial.join(separator) + QLatin1Char('\n')
-                 + stepback + QLatin1Char('}');
+    if (!empty && !gap.isEmpty()) {
+        result += QLatin1Char('\n');
+        result += stepback;
     }
+    result += QLatin1Char('}');
 
     indent = stepback;
     stack.pop();
-    return result;
 }
 
-QString Stringify::JA(ArrayObject *a)
+void Stringify::JA(ArrayObject *a)
 {
     if (stackContains(a)) {
         v4->throwTypeError();
-        return QString();
+        return;
     }
 
     Scope scope(a->engine());
 
-    QString result;
     stack.push(a);
     QString stepback = indent;
     indent += gap;
 
-    QStringList partial;
+    result += QLatin1Char('[');
     uint len = a->getLength();
     ScopedValue v(scope);
     for (uint i = 0; i < len; ++i) {
+        if (i)
+            result += QLatin1Char(',');
+        if (!gap.isEmpty()) {
+            result += QLatin1Char('\n');
+            result += indent;
+        }
+
         bool exists;
         v = a->getIndexed(i, &exists);
         if (!exists) {
-            partial += QStringLiteral("null");
+            result += QLatin1String("null");
             continue;
         }
-        QString strP = Str(QString::number(i), v);
-        if (!strP.isEmpty())
-            partial += strP;
-        else
-            partial += QStringLiteral("null");
+        // the key is only needed for toJSON() and the replacer
+        const QString key = (replacerFunction || v->isObject()) ? QString::number(i) : QString();
+        const int position = result.size();
+        if (!Str(key, v)) {
+            result.truncate(position);
+            result += QLatin1String("null");
+        }
     }
 
-    if (partial.isEmpty()) {
-        result = QStringLiteral("[]");
-    } else if (gap.isEmpty()) {
-        result = QLatin1Char('[') + partial.join(QLatin1Char(',')) + QLatin1Char(']');
-    } else {
-        QString separator = QLatin1String(",\n") + indent;
-        result = QLatin1String("[\n") + indent + partial.join(separator) + QLatin1Char('\n') + stepback + QLatin1Char(']');
+    if (len && !gap.isEmpty()) {
+        result += QLatin1Char('\n');
+        result += stepback;
     }
+    result += QLatin1Char(']');
 
     indent = stepback;
     stack.pop();
-    return result;
 }
 
 
@@ -943,10 +1292,10 @@ void JsonObject::method_stringify(const BuiltinFunction *, Scope &scope, CallDat
 
 
     ScopedValue arg0(scope, callData->argument(0));
-    QString result = stringify.Str(QString(), arg0);
-    if (result.isEmpty() || scope.engine->hasException)
+    stringify.result.reserve(256);
+    if (!stringify.Str(QString(), arg0) || stringify.result.isEmpty() || scope.engine->hasException)
         RETURN_UNDEFINED();
-    scope.result = scope.engine->newString(result);
+    scope.result = scope.engine->newString(stringify.result);
 }
 
 
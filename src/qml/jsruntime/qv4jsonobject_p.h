@@ -56,6 +56,7 @@
 #include <qjsonvalue.h>
 #include <qjsondocument.h>
 #include <qhash.h>
+#include <qvector.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -109,25 +110,67 @@ private:
 
 };
 
-class JsonParser
+// Creates the objects for parsed JSON members. Objects with the same keys at the same nesting
+// level share their InternalClass.
+class JsonObjectBuilder
 {
 public:
-    JsonParser(ExecutionEngine *engine, const QChar *json, int length);
+    JsonObjectBuilder(ExecutionEngine *engine);
 
-    ReturnedValue parse(QJsonParseError *error);
+    Heap::String *keyIdentifier(const QChar *key, int length);
+    // members holds count pairs of a key string and its value.
+    ReturnedValue createObject(int nestingLevel, const Value *members, int count);
 
 private:
+    ExecutionEngine *engine;
+
+    // Identifiers of recently seen keys, indexed by their hash. Only strings that are in the
+    // identifier table are cached, as the table keeps them alive. Array index keys are not in
+    // it, so they are never cached.
+    enum { KeyCacheSize = 64 };
+    Heap::String *keyCache[KeyCacheSize];
+
+    // The keys and InternalClass of the last object created at each nesting level. Arrays of
+    // records usually repeat the same keys, and can reuse the shape without walking the
+    // InternalClass transitions again.
+    struct Shape {
+        QVector<Heap::String *> keys;
+        InternalClass *internalClass = nullptr;
+    };
+    QVector<Shape> shapes;
+};
+
+// Reads the JSON grammar, and hands the values to Derived, which decides how to store them.
+// Slot is where Derived wants a value to be stored. Derived provides:
+//   void storeValue(Slot, const Value &) for null, booleans and numbers
+//   void storeString(Slot, const QString &)
+//   bool parseKey(Slot) to read a member name after its opening quote
+//   Members and Elements types, constructed from Derived * when an object or an array begins,
+//     with bool Members::add(Slot *key, Slot *value), which returns false if there is no room
+//     for another member, and Slot Elements::next() and void Elements::append()
+//   void storeObject(Slot, Members &) and void storeArray(Slot, Elements &)
+template <typename Derived, typename Slot>
+class JsonGrammar
+{
+protected:
+    JsonGrammar(const QChar *json, int length)
+        : head(json), json(json), end(json + length)
+        , nestingLevel(0), lastError(QJsonParseError::NoError)
+    {}
+
+    bool parseDocument(Slot result, QJsonParseError *error);
+
     inline bool eatSpace();
     inline QChar nextToken();
 
-    ReturnedValue parseObject();
-    ReturnedValue parseArray();
-    bool parseMember(Object *o);
+    bool parseObject(Slot val);
+    bool parseArray(Slot val);
+    bool parseValue(Slot val);
+    bool parseLiteral(Slot val, const char *rest, int length, const Value &value);
     bool parseString(QString *string);
-    bool parseValue(Value *val);
-    bool parseNumber(Value *val);
 
-    ExecutionEngine *engine;
+    Derived *derived() { return static_cast<Derived *>(this); }
+
     const QChar *head;
     const QChar *json;
     const QChar *end;
@@ -136,6 +179,78 @@ private:
     QJsonParseError::ParseError lastError;
 };
 
+class JsonParser : public JsonGrammar<JsonParser, Value *>
+{
+public:
+    JsonParser(ExecutionEngine *engine, const QChar *json, int length);
+
+    ReturnedValue parse(QJsonParseError *error);
+
+private:
+    friend class JsonGrammar<JsonParser, Value *>;
+
+    // The members are collected first, so that the object can be created with its final
+    // InternalClass. Each key and value is allocated as a pair on the JS stack, which keeps
+    // the key alive while the value is parsed.
+    struct Members {
+        Members(JsonParser *parser) : scope(parser->engine) {}
+        bool add(Value **key, Value **value);
+
+        Scope scope;
+        Value *members = nullptr;
+        int count = 0;
+    };
+    struct Elements {
+        Elements(JsonParser *parser);
+        Value *next() { return val; }
+        void append() { array->arraySet(size++, val); }
+
+        Scope scope;
+        ScopedObject array;
+        ScopedValue val;
+        uint size = 0;
+    };
+
+    void storeValue(Value *val, const Value &value) { *val = value; }
+    void storeString(Value *val, const QString &string);
+    bool parseKey(Value *key);
+    void storeObject(Value *val, Members &members);
+    void storeArray(Value *val, Elements &elements) { *val = elements.array; }
+
+    ExecutionEngine *engine;
+    JsonObjectBuilder builder;
+};
+
+// Parsed JSON text that does not reference any engine. parse() can run on any thread, and
+// toValue() creates all the JS values in one go on the thread of the engine.
+class JsonTree
+{
+public:
+    static JsonTree parse(const QString &json, QJsonParseError *error);
+
+    bool isValid() const { return !nodes.isEmpty(); }
+    ReturnedValue toValue(ExecutionEngine *engine) const;
+
+private:
+    friend class JsonTreeParser;
+
+    // The values are stored in document order. Objects and arrays are followed by their
+    // members, object members are a Key node followed by the value.
+    struct Node {
+        enum Type : quint8 { Scalar, String, Key, Array, Object };
+        Type type;
+        union {
+            quint64 value; // null, booleans and numbers
+            int size;      // members of an array or object
+            int string;    // index into strings
+        };
+    };
+    QVector<Node> nodes;
+    QVector<QString> strings;
+
+    ReturnedValue toValue(ExecutionEngine *engine, JsonObjectBuilder &builder, int nestingLevel, int *node) const;
+};
+
 }
 
 QT_END_NAMESPACE
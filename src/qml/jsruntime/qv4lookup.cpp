@@ -40,11 +40,24 @@
 #include "qv4functionobject_p.h"
 #include "qv4scopedvalue_p.h"
 #include "qv4string_p.h"
+#include <private/qv4mm_p.h>
+#include <QtCore/qloggingcategory.h>
 
 QT_BEGIN_NAMESPACE
 
 using namespace QV4;
 
+Q_LOGGING_CATEGORY(lcLookups, "qt.qml.lookups")
+
+static inline void addToCache(PolymorphicLookupCache *cache, InternalClass *objectClass, InternalClass *prototypeClass, uint index)
+{
+    Q_ASSERT(cache->size < PolymorphicLookupCache::MaxEntries);
+    PolymorphicLookupCache::Entry &e = cache->entries[cache->size++];
+    e.objectClass = objectClass;
+    e.prototypeClass = prototypeClass;
+    e.index = index;
+}
+
 
 ReturnedValue Lookup::lookup(const Value &thisObject, Object *o, PropertyAttributes *attrs)
 {
@@ -339,6 +352,85 @@ ReturnedValue Lookup::getterTwoClasses(Lookup *l, ExecutionEngine *engine, const
     return getterFallback(l, engine, object);
 }
 
+ReturnedValue Lookup::getterToPolymorphic(Lookup *l, ExecutionEngine *engine, const Value &object)
+{
+    PolymorphicLookupCache *cache = new PolymorphicLookupCache;
+    cache->size = 0;
+    if (l->getter == getter0getter0) {
+        addToCache(cache, l->classList[0], nullptr, l->index);
+        addToCache(cache, l->classList[2], nullptr, l->index2);
+    } else if (l->getter == getter0getter1) {
+        addToCache(cache, l->classList[0], nullptr, l->index);
+        addToCache(cache, l->classList[2], l->classList[3], l->index2);
+    } else {
+        Q_ASSERT(l->getter == getter1getter1);
+        addToCache(cache, l->classList[0], l->classList[1], l->index);
+        addToCache(cache, l->classList[2], l->classList[3], l->index2);
+    }
+    l->polymorphicCache = cache;
+    l->getter = getterPolymorphic;
+    return getterPolymorphicMiss(l, engine, object);
+}
+
+ReturnedValue Lookup::getterPolymorphic(Lookup *l, ExecutionEngine *engine, const Value &object)
+{
+    // we can safely cast to a QV4::Object here. If object is actually a string,
+    // the internal class won't match
+    Heap::Object *o = static_cast<Heap::Object *>(object.heapObject());
+    if (o) {
+        const PolymorphicLookupCache *cache = l->polymorphicCache;
+        InternalClass *c = o->internalClass;
+        for (uint i = 0; i < cache->size; ++i) {
+            const PolymorphicLookupCache::Entry &e = cache->entries[i];
+            if (e.objectClass != c)
+                continue;
+            if (!e.prototypeClass)
+                return o->propertyData(e.index)->asReturnedValue();
+            if (o->prototype && o->prototype->internalClass == e.prototypeClass)
+                return o->prototype->propertyData(e.index)->asReturnedValue();
+        }
+    }
+    return getterPolymorphicMiss(l, engine, object);
+}
+
+ReturnedValue Lookup::getterPolymorphicMiss(Lookup *l, ExecutionEngine *engine, const Value &object)
+{
+    // Primitives have no shape to cache, and don't say anything about the objects the
+    // lookup sees otherwise
+    const Object *o = object.as<Object>();
+    if (!o)
+        return getterFallback(l, engine, object);
+
+    PolymorphicLookupCache *cache = l->polymorphicCache;
+    if (cache->size < PolymorphicLookupCache::MaxEntries) {
+        // Resolve the property the way a monomorphic lookup would, and keep the result
+        // if it's something we can cache. Other shapes just don't get cached.
+        Lookup single = *l;
+        single.getter = getterGeneric;
+        ReturnedValue v = o->getLookup(&single);
+        if (single.index != UINT_MAX && (single.getter == getter0 || single.getter == getter1))
+            addToCache(cache, single.classList[0], single.getter == getter1 ? single.classList[1] : nullptr, single.index);
+        return v;
+    }
+
+    becomeMegamorphic(l, engine);
+    l->getter = getterFallback;
+    return getterFallback(l, engine, object);
+}
+
+void Lookup::becomeMegamorphic(Lookup *l, ExecutionEngine *engine)
+{
+    ++engine->nMegamorphicLookups;
+    if (lcLookups().isDebugEnabled() && engine->current && engine->current->compilationUnit) {
+        CompiledData::CompilationUnit *unit = engine->current->compilationUnit;
+        qCDebug(lcLookups) << "Lookup of" << unit->runtimeStrings[l->nameIndex]->toQString()
+                           << "at" << unit->fileName() << "line" << engine->current->lineNumber
+                           << "went megamorphic after" << l->polymorphicCache->size << "shapes";
+    }
+    delete l->polymorphicCache;
+    l->polymorphicCache = nullptr;
+}
+
 ReturnedValue Lookup::getterFallback(Lookup *l, ExecutionEngine *engine, const Value &object)
 {
     QV4::Scope scope(engine);
@@ -403,8 +495,7 @@ ReturnedValue Lookup::getter0getter0(Lookup *l, ExecutionEngine *engine, const V
         if (l->classList[2] == o->internalClass)
             return o->propertyData(l->index2)->asReturnedValue();
     }
-    l->getter = getterFallback;
-    return getterFallback(l, engine, object);
+    return getterToPolymorphic(l, engine, object);
 }
 
 ReturnedValue Lookup::getter0getter1(Lookup *l, ExecutionEngine *engine, const Value &object)
@@ -418,8 +509,7 @@ ReturnedValue Lookup::getter0getter1(Lookup *l, ExecutionEngine *engine, const V
         if (l->classList[2] == o->internalClass && l->classList[3] == o->prototype->internalClass)
             return o->prototype->propertyData(l->index2)->asReturnedValue();
     }
-    l->getter = getterFallback;
-    return getterFallback(l, engine, object);
+    return getterToPolymorphic(l, engine, object);
 }
 
 ReturnedValue Lookup::getter1getter1(Lookup *l, ExecutionEngine *engine, const Value &object)
@@ -434,10 +524,8 @@ ReturnedValue Lookup::getter1getter1(Lookup *l, ExecutionEngine *engine, const V
         if (l->classList[2] == o->internalClass &&
             l->classList[3] == o->prototype->internalClass)
             return o->prototype->propertyData(l->index2)->asReturnedValue();
-        return getterFallback(l, engine, object);
     }
-    l->getter = getterFallback;
-    return getterFallback(l, engine, object);
+    return getterToPolymorphic(l, engine, object);
 }
 
 
@@ -548,7 +636,7 @@ ReturnedValue Lookup::primitiveGetterAccessor0(Lookup *l, ExecutionEngine *engin
                 return Encode::undefined();
 
             ScopedCallData callData(scope, 0);
-            callData->thisObject = object;
+            callData->thisObject = engine->memoryManager->escapeTemporary(object);
             getter->call(scope, callData);
             return scope.result.asReturnedValue();
         }
@@ -569,7 +657,7 @@ ReturnedValue Lookup::primitiveGetterAccessor1(Lookup *l, ExecutionEngine *engin
                 return Encode::undefined();
 
             ScopedCallData callData(scope, 0);
-            callData->thisObject = object;
+            callData->thisObject = engine->memoryManager->escapeTemporary(object);
             getter->call(scope, callData);
             return scope.result.asReturnedValue();
         }
@@ -843,9 +931,56 @@ void Lookup::setter0setter0(Lookup *l, ExecutionEngine *engine, Value &object, c
         }
     }
 
+    setterToPolymorphic(l, engine, object, value);
+}
+
+void Lookup::setterToPolymorphic(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value)
+{
+    PolymorphicLookupCache *cache = new PolymorphicLookupCache;
+    cache->size = 0;
+    addToCache(cache, l->classList[0], nullptr, l->index);
+    addToCache(cache, l->classList[1], nullptr, l->index2);
+    l->polymorphicCache = cache;
+    l->setter = setterPolymorphic;
+    setterPolymorphicMiss(l, engine, object, value);
+}
+
+void Lookup::setterPolymorphic(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value)
+{
+    if (Object *o = object.as<Object>()) {
+        const PolymorphicLookupCache *cache = l->polymorphicCache;
+        InternalClass *c = o->internalClass();
+        for (uint i = 0; i < cache->size; ++i) {
+            if (cache->entries[i].objectClass == c) {
+                o->setProperty(engine, cache->entries[i].index, value);
+                return;
+            }
+        }
+    }
+    setterPolymorphicMiss(l, engine, object, value);
+}
+
+void Lookup::setterPolymorphicMiss(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value)
+{
+    Object *o = object.as<Object>();
+    if (!o) {
+        setterFallback(l, engine, object, value);
+        return;
+    }
+
+    PolymorphicLookupCache *cache = l->polymorphicCache;
+    if (cache->size < PolymorphicLookupCache::MaxEntries) {
+        Lookup single = *l;
+        single.setter = setterGeneric;
+        o->setLookup(&single, value);
+        if (single.setter == setter0)
+            addToCache(cache, single.classList[0], nullptr, single.index);
+        return;
+    }
+
+    becomeMegamorphic(l, engine);
     l->setter = setterFallback;
     setterFallback(l, engine, object, value);
-
 }
 
 QT_END_NAMESPACE
@@ -64,6 +64,19 @@ QT_BEGIN_NAMESPACE
 
 namespace QV4 {
 
+// Shapes seen by a property access site that outgrew the two InternalClasses a Lookup
+// can hold itself. Entries without a prototypeClass find the property on the object.
+struct PolymorphicLookupCache {
+    enum { MaxEntries = 8 };
+    struct Entry {
+        InternalClass *objectClass;
+        InternalClass *prototypeClass;
+        uint index;
+    };
+    uint size;
+    Entry entries[MaxEntries];
+};
+
 struct Lookup {
     enum { Size = 4 };
     union {
@@ -81,6 +94,7 @@ struct Lookup {
             Object *proto;
             unsigned type;
         };
+        PolymorphicLookupCache *polymorphicCache;
     };
     union {
         int level;
@@ -100,6 +114,7 @@ struct Lookup {
     static ReturnedValue getterGeneric(Lookup *l, ExecutionEngine *engine, const Value &object);
     static ReturnedValue getterTwoClasses(Lookup *l, ExecutionEngine *engine, const Value &object);
     static ReturnedValue getterFallback(Lookup *l, ExecutionEngine *engine, const Value &object);
+    static ReturnedValue getterPolymorphic(Lookup *l, ExecutionEngine *engine, const Value &object);
 
     static ReturnedValue getter0(Lookup *l, ExecutionEngine *engine, const Value &object);
     static ReturnedValue getter1(Lookup *l, ExecutionEngine *engine, const Value &object);
@@ -129,6 +144,7 @@ struct Lookup {
     static void setterGeneric(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
     static void setterTwoClasses(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
     static void setterFallback(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
+    static void setterPolymorphic(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
     static void setter0(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
     static void setterInsert0(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
     static void setterInsert1(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
@@ -138,6 +154,18 @@ struct Lookup {
     ReturnedValue lookup(const Value &thisObject, Object *obj, PropertyAttributes *attrs);
     ReturnedValue lookup(const Object *obj, PropertyAttributes *attrs);
 
+    void releasePolymorphicCache() {
+        if (getter == getterPolymorphic || setter == setterPolymorphic)
+            delete polymorphicCache;
+    }
+
+private:
+    static ReturnedValue getterToPolymorphic(Lookup *l, ExecutionEngine *engine, const Value &object);
+    static ReturnedValue getterPolymorphicMiss(Lookup *l, ExecutionEngine *engine, const Value &object);
+    static void setterToPolymorphic(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
+    static void setterPolymorphicMiss(Lookup *l, ExecutionEngine *engine, Value &object, const Value &value);
+    static void becomeMegamorphic(Lookup *l, ExecutionEngine *engine);
+
 };
 
 }
@@ -307,7 +307,18 @@ void NumberPrototype::method_toFixed(const BuiltinFunction *, Scope &scope, Call
         str = QStringLiteral("NaN");
     else if (qt_is_inf(v))
         str = QString::fromLatin1(v < 0 ? "-Infinity" : "Infinity");
-    else if (v < 1.e21)
+    else if (v > -9007199254740992.0 && v < 9007199254740992.0 && v == std::floor(v)) {
+        // Integers are exact, so only zeros need to be appended. -0 prints without a sign.
+        RuntimeHelpers::numberToString(&str, v, 10);
+        if (fdigits > 0) {
+            const int length = str.length();
+            str.resize(length + 1 + int(fdigits));
+            QChar *out = str.data() + length;
+            *out++ = QLatin1Char('.');
+            for (int i = 0; i < int(fdigits); ++i)
+                *out++ = QLatin1Char('0');
+        }
+    } else if (v < 1.e21)
         str = NumberLocale::instance()->toString(v, 'f', int(fdigits));
     else {
         scope.result = RuntimeHelpers::stringFromNumber(scope.engine, v);
@@ -103,7 +103,7 @@ ReturnedValue Object::getValue(const Value &thisObject, const Value &v, Property
 
     Scope scope(f->engine());
     ScopedCallData callData(scope);
-    callData->thisObject = thisObject;
+    callData->thisObject = scope.engine->memoryManager->escapeTemporary(thisObject);
     f->call(scope, callData);
     return scope.result.asReturnedValue();
 }
@@ -572,8 +572,17 @@ void Object::advanceIterator(Managed *m, ObjectIterator *it, Value *name, uint *
     *index = UINT_MAX;
 
     if (o->arrayData()) {
-        if (!it->arrayIndex)
+        SparseArray *sparse = o->arrayType() == Heap::ArrayData::Sparse ? o->d()->arrayData->sparse : nullptr;
+        if (!it->arrayIndex) {
             it->arrayNode = o->sparseBegin();
+        } else if (it->arrayIndex != UINT_MAX
+                   && (sparse != it->arraySparse || (sparse && sparse->version() != it->arraySparseVersion))) {
+            // The array changed its storage, or released nodes, while iterating. Continue
+            // after the last index we returned, without touching the old node.
+            it->arrayNode = sparse ? sparse->lowerBound(it->arrayIndex) : nullptr;
+        }
+        it->arraySparse = sparse;
+        it->arraySparseVersion = sparse ? sparse->version() : 0;
 
         // sparse arrays
         if (it->arrayNode) {
@@ -1145,6 +1154,7 @@ void Object::copyArrayData(Object *other)
             Heap::ArrayData *dd = d()->arrayData;
             dd->values.size = other->d()->arrayData->values.size;
             dd->offset = other->d()->arrayData->offset;
+            dd->elementKind = other->d()->arrayData->elementKind;
         }
         // ### need a write barrier
         memcpy(d()->arrayData->values.values, other->d()->arrayData->values.values, other->d()->arrayData->values.alloc*sizeof(Value));
@@ -69,6 +69,9 @@ struct Q_QML_EXPORT ObjectIteratorData
     Value *object;
     Value *current;
     SparseArrayNode *arrayNode;
+    // the sparse array arrayNode belongs to, and its version when arrayNode was taken
+    SparseArray *arraySparse;
+    uint arraySparseVersion;
     uint arrayIndex;
     uint memberIndex;
     uint flags;
@@ -83,6 +86,8 @@ struct Q_QML_EXPORT ObjectIterator: ObjectIteratorData
         object = scratch1;
         current = scratch2;
         arrayNode = nullptr;
+        arraySparse = nullptr;
+        arraySparseVersion = 0;
         arrayIndex = 0;
         memberIndex = 0;
         this->flags = flags;
@@ -95,6 +100,8 @@ struct Q_QML_EXPORT ObjectIterator: ObjectIteratorData
         object = scope.alloc(1);
         current = scope.alloc(1);
         arrayNode = nullptr;
+        arraySparse = nullptr;
+        arraySparseVersion = 0;
         arrayIndex = 0;
         memberIndex = 0;
         this->flags = flags;
@@ -225,7 +225,10 @@ void PersistentValueStorage::mark(ExecutionEngine *e)
             if (Managed *m = p->values[i].as<Managed>())
                 m->mark(e);
         }
-        e->memoryManager->drainMarkStack(markBase);
+        // Only drain when running out of stack space, so that an incremental collection
+        // can trace the objects reachable from here in later slices.
+        if (e->jsStackTop >= e->jsStackLimit)
+            e->memoryManager->drainMarkStack(markBase);
 
         p = p->header.next;
     }
@@ -384,7 +387,7 @@ void WeakValue::allocVal(ExecutionEngine *engine)
     val = engine->memoryManager->m_weakValues->allocate();
 }
 
-void WeakValue::markOnce(ExecutionEngine *e)
+void WeakValue::markOnce(ExecutionEngine *e) const
 {
     if (!val)
         return;
@@ -203,7 +203,7 @@ public:
     bool isNullOrUndefined() const { return !val || val->isNullOrUndefined(); }
     void clear() { free(); }
 
-    void markOnce(ExecutionEngine *e);
+    void markOnce(ExecutionEngine *e) const;
 
 private:
     Value *val;
@@ -69,6 +69,7 @@ Profiler::Profiler(QV4::ExecutionEngine *engine) : featuresEnabled(0), m_engine(
     static const int metatypes[] = {
         qRegisterMetaType<QVector<QV4::Profiling::FunctionCallProperties> >(),
         qRegisterMetaType<QVector<QV4::Profiling::MemoryAllocationProperties> >(),
+        qRegisterMetaType<QVector<QV4::Profiling::GarbageCollectionProperties> >(),
         qRegisterMetaType<FunctionLocationHash>()
     };
     Q_UNUSED(metatypes);
@@ -110,8 +111,10 @@ void Profiler::reportData(bool trackLocations)
     }
 
     emit dataReady(locations, properties, m_memory_data);
+    emit gcDataReady(m_gc_data);
     m_data.clear();
     m_memory_data.clear();
+    m_gc_data.clear();
 }
 
 void Profiler::startProfiling(quint64 features)
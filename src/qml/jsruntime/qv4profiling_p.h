@@ -54,6 +54,7 @@
 #include "qv4global_p.h"
 #include "qv4engine_p.h"
 #include "qv4function_p.h"
+#include <private/qv4mmdefs_p.h>
 
 #include <QElapsedTimer>
 
@@ -61,6 +62,7 @@
 
 #define Q_V4_PROFILE_ALLOC(engine, size, type) (!engine)
 #define Q_V4_PROFILE_DEALLOC(engine, size, type) (!engine)
+#define Q_V4_PROFILE_GC(engine, reason, duration, usedSize, heapSize) (!engine)
 #define Q_V4_PROFILE(engine, function) (function->code(engine, function->codeData))
 
 QT_BEGIN_NAMESPACE
@@ -85,6 +87,11 @@ QT_END_NAMESPACE
             (engine->profiler()->featuresEnabled & (1 << Profiling::FeatureMemoryAllocation)) ?\
         engine->profiler()->trackDealloc(size, type) : false)
 
+#define Q_V4_PROFILE_GC(engine, reason, duration, usedSize, heapSize) \
+    (engine->profiler() &&\
+            (engine->profiler()->featuresEnabled & (1 << Profiling::FeatureMemoryAllocation)) ?\
+        engine->profiler()->trackGC(reason, duration, usedSize, heapSize) : false)
+
 #define Q_V4_PROFILE(engine, function)\
     (Q_UNLIKELY(engine->profiler()) &&\
             (engine->profiler()->featuresEnabled & (1 << Profiling::FeatureFunctionCall)) ?\
@@ -139,6 +146,14 @@ struct MemoryAllocationProperties {
     MemoryType type;
 };
 
+struct GarbageCollectionProperties {
+    qint64 start;
+    qint64 end;
+    GCReason reason;
+    qint64 usedSize;    // memory in use by managed objects after the collection
+    qint64 heapSize;    // size of the heap after the collection
+};
+
 class FunctionCall {
 public:
 
@@ -242,6 +257,14 @@ public:
         return true;
     }
 
+    bool trackGC(GCReason reason, qint64 duration, size_t usedSize, size_t heapSize)
+    {
+        const qint64 end = m_timer.nsecsElapsed();
+        GarbageCollectionProperties gc = {end - duration, end, reason, (qint64)usedSize, (qint64)heapSize};
+        m_gc_data.append(gc);
+        return true;
+    }
+
     quint64 featuresEnabled;
 
     void stopProfiling();
@@ -253,12 +276,14 @@ signals:
     void dataReady(const QV4::Profiling::FunctionLocationHash &,
                    const QVector<QV4::Profiling::FunctionCallProperties> &,
                    const QVector<QV4::Profiling::MemoryAllocationProperties> &);
+    void gcDataReady(const QVector<QV4::Profiling::GarbageCollectionProperties> &);
 
 private:
     QV4::ExecutionEngine *m_engine;
     QElapsedTimer m_timer;
     QVector<FunctionCall> m_data;
     QVector<MemoryAllocationProperties> m_memory_data;
+    QVector<GarbageCollectionProperties> m_gc_data;
     QHash<quintptr, SentMarker> m_sentLocations;
 
     friend class FunctionCallProfiler;
@@ -295,6 +320,7 @@ public:
 } // namespace QV4
 
 Q_DECLARE_TYPEINFO(QV4::Profiling::MemoryAllocationProperties, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(QV4::Profiling::GarbageCollectionProperties, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(QV4::Profiling::FunctionCallProperties, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(QV4::Profiling::FunctionCall, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(QV4::Profiling::FunctionLocation, Q_MOVABLE_TYPE);
@@ -303,6 +329,7 @@ Q_DECLARE_TYPEINFO(QV4::Profiling::Profiler::SentMarker, Q_MOVABLE_TYPE);
 QT_END_NAMESPACE
 Q_DECLARE_METATYPE(QV4::Profiling::FunctionLocationHash)
 Q_DECLARE_METATYPE(QVector<QV4::Profiling::FunctionCallProperties>)
+Q_DECLARE_METATYPE(QVector<QV4::Profiling::GarbageCollectionProperties>)
 Q_DECLARE_METATYPE(QVector<QV4::Profiling::MemoryAllocationProperties>)
 
 #endif // QT_NO_QML_DEBUGGER
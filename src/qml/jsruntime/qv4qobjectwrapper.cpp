@@ -140,7 +140,7 @@ static QV4::ReturnedValue loadProperty(QV4::ExecutionEngine *v4, QObject *object
     } else if (property.propType() == QMetaType::QString) {
         QString v;
         property.readProperty(object, &v);
-        return v4->newString(v)->asReturnedValue();
+        return v4->memoryManager->allocTemporaryString(v)->asReturnedValue();
     } else if (property.propType() == QMetaType::UInt) {
         uint v = 0;
         property.readProperty(object, &v);
@@ -1363,9 +1363,9 @@ Resolve the overloaded method to call.  The algorithm works conceptually like th
         If two or more overloads have the same match score, call the last one.  The match
         score is constructed by adding the matchScore() result for each of the parameters.
 */
-static QV4::ReturnedValue CallOverloaded(const QQmlObjectOrGadget &object, const QQmlPropertyData &data,
-                                         QV4::ExecutionEngine *engine, QV4::CallData *callArgs, const QQmlPropertyCache *propertyCache,
-                                         QMetaObject::Call callType = QMetaObject::InvokeMetaMethod)
+static bool ResolveOverload(const QQmlObjectOrGadget &object, const QQmlPropertyData &data,
+                            QV4::ExecutionEngine *engine, QV4::CallData *callArgs,
+                            const QQmlPropertyCache *propertyCache, QQmlPropertyData *result)
 {
     int argumentCount = callArgs->argc;
 
@@ -1414,9 +1414,19 @@ static QV4::ReturnedValue CallOverloaded(const QQmlObjectOrGadget &object, const
 
     } while ((attempt = RelatedMethod(object, attempt, dummy, propertyCache)) != 0);
 
-    if (best.isValid()) {
+    *result = best;
+    return best.isValid();
+}
+
+static QV4::ReturnedValue CallOverloaded(const QQmlObjectOrGadget &object, const QQmlPropertyData &data,
+                                         QV4::ExecutionEngine *engine, QV4::CallData *callArgs, const QQmlPropertyCache *propertyCache,
+                                         QMetaObject::Call callType = QMetaObject::InvokeMetaMethod)
+{
+    QQmlPropertyData best;
+    if (ResolveOverload(object, data, engine, callArgs, propertyCache, &best)) {
         return CallPrecise(object, best, engine, callArgs, callType);
     } else {
+        QQmlPropertyData dummy;
         QString error = QLatin1String("Unable to determine callable overload.  Candidates are:");
         const QQmlPropertyData *candidate = &data;
         while (candidate) {
@@ -1430,6 +1440,248 @@ static QV4::ReturnedValue CallOverloaded(const QQmlObjectOrGadget &object, const
     }
 }
 
+static bool IsDirectType(int type)
+{
+    switch (type) {
+    case QMetaType::Void:
+    case QMetaType::Int:
+    case QMetaType::Double:
+    case QMetaType::Bool:
+    case QMetaType::QString:
+    case QMetaType::QObjectStar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*!
+Returns the call plan of the method, creating it on the first call.  Returns 0 if the return
+type or a parameter type is unknown, CallPrecise() then reports the error.
+*/
+static QQmlMethodCallPlan *MethodCallPlan(const QQmlObjectOrGadget &object, const QQmlPropertyData &data,
+                                          QQmlPropertyCache *propertyCache)
+{
+    if (QQmlMethodCallPlan *plan = propertyCache->methodCallPlan(data.coreIndex()))
+        return plan;
+
+    int returnType = object.methodReturnType(data, 0);
+    if (returnType == QMetaType::UnknownType)
+        return 0;
+
+    int *args = 0;
+    QQmlMetaObject::ArgTypeStorage storage;
+    if (data.hasArguments()) {
+        args = object.methodParameterTypes(data.coreIndex(), &storage, 0);
+        if (!args)
+            return 0;
+    }
+
+    QQmlMethodCallPlan *plan = new QQmlMethodCallPlan;
+    plan->returnType = returnType;
+    plan->direct = IsDirectType(returnType);
+    if (args) {
+        plan->parameterTypes.reserve(args[0]);
+        for (int ii = 0; ii < args[0]; ++ii) {
+            plan->parameterTypes.append(args[ii + 1]);
+            plan->direct &= IsDirectType(args[ii + 1]) && args[ii + 1] != QMetaType::Void;
+        }
+        plan->direct &= args[0] <= QQmlMethodCallPlan::MaxDirectArguments;
+    }
+
+    propertyCache->setMethodCallPlan(data.coreIndex(), plan);
+    return plan;
+}
+
+/*!
+Summarizes the types of the arguments as far as MatchScore() is concerned.  Returns false if
+the score of an argument depends on more than its type, and the overload can't be cached.
+*/
+static bool ArgumentSignature(QV4::CallData *callArgs, quint32 *signature)
+{
+    if (callArgs->argc > 10)
+        return false;
+
+    quint32 result = 0;
+    for (int ii = 0; ii < callArgs->argc; ++ii) {
+        const QV4::Value &value = callArgs->args[ii];
+        quint32 kind;
+        if (value.isUndefined())
+            kind = 1;
+        else if (value.isNull())
+            kind = 2;
+        else if (value.isBoolean())
+            kind = 3;
+        else if (value.isNumber())
+            kind = 4;
+        else if (value.isString())
+            kind = 5;
+        else if (value.as<QObjectWrapper>())
+            kind = 6;
+        else
+            return false;
+        result |= kind << (3 * ii);
+    }
+
+    *signature = result;
+    return true;
+}
+
+/*!
+Calls a method that only takes and returns void, int, double, bool, QString and QObject*,
+converting the arguments directly instead of going through CallArgument.
+*/
+static QV4::ReturnedValue CallDirect(const QQmlObjectOrGadget &object, int index,
+                                     const QQmlMethodCallPlan &plan, QV4::ExecutionEngine *engine,
+                                     QV4::CallData *callArgs)
+{
+    union Argument {
+        int intValue;
+        double doubleValue;
+        bool boolValue;
+        QObject *qobjectPtr;
+    };
+
+    enum { MaxArguments = QQmlMethodCallPlan::MaxDirectArguments + 1 };
+    Argument values[MaxArguments];
+    QString strings[MaxArguments];
+    void *argv[MaxArguments];
+
+    const int argc = plan.parameterTypes.count();
+    for (int ii = 0; ii < argc; ++ii) {
+        const QV4::Value &value = callArgs->args[ii];
+        Argument &arg = values[ii + 1];
+        switch (plan.parameterTypes.at(ii)) {
+        case QMetaType::Int:
+            arg.intValue = value.toInt32();
+            argv[ii + 1] = &arg.intValue;
+            break;
+        case QMetaType::Double:
+            arg.doubleValue = value.toNumber();
+            argv[ii + 1] = &arg.doubleValue;
+            break;
+        case QMetaType::Bool:
+            arg.boolValue = value.toBoolean();
+            argv[ii + 1] = &arg.boolValue;
+            break;
+        case QMetaType::QString:
+            if (!value.isNullOrUndefined())
+                strings[ii + 1] = value.toQStringNoThrow();
+            argv[ii + 1] = &strings[ii + 1];
+            break;
+        case QMetaType::QObjectStar:
+            arg.qobjectPtr = 0;
+            if (const QV4::QObjectWrapper *qobjectWrapper = value.as<QV4::QObjectWrapper>())
+                arg.qobjectPtr = qobjectWrapper->object();
+            argv[ii + 1] = &arg.qobjectPtr;
+            break;
+        default:
+            Q_UNREACHABLE();
+        }
+    }
+
+    if (engine->hasException)
+        return QV4::Encode::undefined();
+
+    // the plan isn't used after the call, the method might change the property cache
+    const int returnType = plan.returnType;
+    Argument &result = values[0];
+    switch (returnType) {
+    case QMetaType::Int:
+        result.intValue = 0;
+        argv[0] = &result.intValue;
+        break;
+    case QMetaType::Double:
+        result.doubleValue = 0;
+        argv[0] = &result.doubleValue;
+        break;
+    case QMetaType::Bool:
+        result.boolValue = false;
+        argv[0] = &result.boolValue;
+        break;
+    case QMetaType::QString:
+        argv[0] = &strings[0];
+        break;
+    case QMetaType::QObjectStar:
+        result.qobjectPtr = 0;
+        argv[0] = &result.qobjectPtr;
+        break;
+    default:
+        argv[0] = 0;
+        break;
+    }
+
+    object.metacall(QMetaObject::InvokeMetaMethod, index, argv);
+
+    switch (returnType) {
+    case QMetaType::Int:
+        return QV4::Encode(result.intValue);
+    case QMetaType::Double:
+        return QV4::Encode(result.doubleValue);
+    case QMetaType::Bool:
+        return QV4::Encode(result.boolValue);
+    case QMetaType::QString:
+        return QV4::Encode(engine->newString(strings[0]));
+    case QMetaType::QObjectStar:
+        if (result.qobjectPtr)
+            QQmlData::get(result.qobjectPtr, true)->setImplicitDestructible();
+        return QV4::QObjectWrapper::wrap(engine, result.qobjectPtr);
+    default:
+        return QV4::Encode::undefined();
+    }
+}
+
+/*!
+Calls a method through the call plans in \a propertyCache.  Overloads are resolved once for
+each argument signature, and the argument types are only looked up on the first call.
+*/
+static QV4::ReturnedValue CallCached(const QQmlObjectOrGadget &object, const QQmlPropertyData &data,
+                                     QV4::ExecutionEngine *engine, QV4::CallData *callArgs,
+                                     QQmlPropertyCache *propertyCache)
+{
+    QQmlPropertyData method = data;
+
+    if (data.isOverload()) {
+        QQmlMethodCallPlan *plan = MethodCallPlan(object, data, propertyCache);
+        quint32 signature;
+        if (!plan || !ArgumentSignature(callArgs, &signature))
+            return CallOverloaded(object, data, engine, callArgs, propertyCache);
+
+        if (const QQmlPropertyData *cached = plan->overload(callArgs->argc, signature)) {
+            method = *cached;
+        } else {
+            if (!ResolveOverload(object, data, engine, callArgs, propertyCache, &method))
+                return CallOverloaded(object, data, engine, callArgs, propertyCache);
+            plan->addOverload(callArgs->argc, signature, method);
+        }
+    }
+
+    QQmlMethodCallPlan *plan = MethodCallPlan(object, method, propertyCache);
+    if (!plan)
+        return CallPrecise(object, method, engine, callArgs);
+
+    const int argc = plan->parameterTypes.count();
+    if (argc > callArgs->argc)
+        return engine->throwError(QLatin1String("Insufficient arguments"));
+
+    if (plan->direct) {
+        // singletons passed as QObject* are looked up by CallArgument
+        bool direct = true;
+        for (int ii = 0; ii < argc; ++ii) {
+            if (plan->parameterTypes.at(ii) == QMetaType::QObjectStar
+                    && callArgs->args[ii].as<QV4::QmlTypeWrapper>()) {
+                direct = false;
+                break;
+            }
+        }
+        if (direct)
+            return CallDirect(object, method.coreIndex(), *plan, engine, callArgs);
+    }
+
+    return CallMethod(object, method.coreIndex(), plan->returnType, argc,
+                      plan->parameterTypes.data(), engine, callArgs);
+}
+
 CallArgument::CallArgument()
 : type(QVariant::Invalid)
 {
@@ -1834,7 +2086,9 @@ void QObjectMethod::callInternal(CallData *callData, Scope &scope) const
         return;
     }
 
-    if (!method.isOverload()) {
+    if (d()->propertyCache()) {
+        scope.result = CallCached(object, method, v4, callData, d()->propertyCache());
+    } else if (!method.isOverload()) {
         scope.result = CallPrecise(object, method, v4, callData);
     } else {
         scope.result = CallOverloaded(object, method, v4, callData, d()->propertyCache());
@@ -2068,8 +2322,9 @@ void MultiplyWrappedQObjectMap::remove(QObject *key)
 
 void MultiplyWrappedQObjectMap::mark(QObject *key, ExecutionEngine *engine)
 {
-    Iterator it = find(key);
-    if (it == end())
+    // may run on several marking threads at once, so don't detach
+    ConstIterator it = constFind(key);
+    if (it == constEnd())
         return;
     it->markOnce(engine);
 }
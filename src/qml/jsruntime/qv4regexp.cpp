@@ -40,18 +40,160 @@
 #include "qv4regexp_p.h"
 #include "qv4engine_p.h"
 #include "qv4scopedvalue_p.h"
+#include "qv4executableallocator_p.h"
 #include <private/qv4mm_p.h>
 
+#include <QtCore/qmutex.h>
+
 using namespace QV4;
 
+#if ENABLE(YARR_JIT)
+namespace {
+struct SharedRegExpJitCodeRegistry
+{
+    QMutex mutex;
+    QHash<RegExpCacheKey, SharedRegExpJitCode *> codes;
+    ExecutableAllocator allocator;
+    uint hits = 0;
+    uint misses = 0;
+};
+}
+
+Q_GLOBAL_STATIC(SharedRegExpJitCodeRegistry, sharedJitCodeRegistry)
+
+SharedRegExpJitCode *SharedRegExpJitCode::get(const RegExpCacheKey &key, JSC::Yarr::YarrPattern &pattern)
+{
+    SharedRegExpJitCodeRegistry *registry = sharedJitCodeRegistry();
+    QMutexLocker locker(&registry->mutex);
+    SharedRegExpJitCode *&code = registry->codes[key];
+    if (code) {
+        ++code->refCount;
+        ++registry->hits;
+        return code;
+    }
+
+    ++registry->misses;
+    code = new SharedRegExpJitCode(key);
+    JSC::JSGlobalData dummy(&registry->allocator);
+    JSC::Yarr::jitCompile(pattern, JSC::Yarr::Char16, &dummy, code->codeBlock);
+    return code;
+}
+
+void SharedRegExpJitCode::release()
+{
+    // engines that outlive the registry leak their code, its memory is gone already
+    if (sharedJitCodeRegistry.isDestroyed())
+        return;
+
+    SharedRegExpJitCodeRegistry *registry = sharedJitCodeRegistry();
+    QMutexLocker locker(&registry->mutex);
+    if (--refCount)
+        return;
+    registry->codes.remove(key);
+    delete this;
+}
+
+uint SharedRegExpJitCode::hits()
+{
+    SharedRegExpJitCodeRegistry *registry = sharedJitCodeRegistry();
+    QMutexLocker locker(&registry->mutex);
+    return registry->hits;
+}
+
+uint SharedRegExpJitCode::misses()
+{
+    SharedRegExpJitCodeRegistry *registry = sharedJitCodeRegistry();
+    QMutexLocker locker(&registry->mutex);
+    return registry->misses;
+}
+#endif
+
+RegExpCache::RegExpCache()
+{
+    bool ok = false;
+    int capacity = qEnvironmentVariableIntValue("QV4_REGEXP_CACHE_SIZE", &ok);
+    setStrongCapacity(ok ? capacity : int(DefaultStrongCapacity));
+}
+
 RegExpCache::~RegExpCache()
 {
-    for (RegExpCache::Iterator it = begin(), e = end(); it != e; ++it) {
-        if (RegExp *re = it.value().as<RegExp>())
+    for (auto it = entries.begin(), end = entries.end(); it != end; ++it) {
+        if (RegExp *re = it->regExp.as<RegExp>())
             re->d()->cache = 0;
     }
 }
 
+Heap::RegExp *RegExpCache::find(const RegExpCacheKey &key)
+{
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        if (RegExp *re = it->regExp.as<RegExp>()) {
+            ++hitCount;
+            touch(*it);
+            return re->d();
+        }
+    }
+    ++missCount;
+    return nullptr;
+}
+
+void RegExpCache::insert(ExecutionEngine *engine, const RegExpCacheKey &key, Heap::RegExp *regExp)
+{
+    Entry &entry = entries[key];
+    entry.regExp.set(engine, regExp);
+    regExp->cache = this;
+    touch(entry);
+}
+
+void RegExpCache::remove(const RegExpCacheKey &key)
+{
+    auto it = entries.find(key);
+    if (it == entries.end())
+        return;
+    if (it->strongIndex >= 0)
+        strongEntries[it->strongIndex] = StrongEntry();
+    entries.erase(it);
+}
+
+void RegExpCache::touch(Entry &entry)
+{
+    if (strongEntries.isEmpty())
+        return;
+
+    if (entry.strongIndex < 0) {
+        // replace the least recently used regexp
+        int index = 0;
+        for (int i = 1; i < strongEntries.size() && strongEntries.at(index).regExp; ++i) {
+            if (!strongEntries.at(i).regExp || strongEntries.at(i).lastUse < strongEntries.at(index).lastUse)
+                index = i;
+        }
+        StrongEntry &strong = strongEntries[index];
+        if (strong.regExp)
+            entries[RegExpCacheKey(strong.regExp)].strongIndex = -1;
+        strong.regExp = entry.regExp.as<RegExp>()->d();
+        entry.strongIndex = index;
+    }
+    strongEntries[entry.strongIndex].lastUse = ++useCounter;
+}
+
+void RegExpCache::setStrongCapacity(int capacity)
+{
+    capacity = qMax(capacity, 0);
+    for (int i = capacity; i < strongEntries.size(); ++i) {
+        if (Heap::RegExp *re = strongEntries.at(i).regExp)
+            entries[RegExpCacheKey(re)].strongIndex = -1;
+    }
+    strongEntries.resize(capacity);
+}
+
+void RegExpCache::markObjects(ExecutionEngine *e)
+{
+    for (const StrongEntry &strong : qAsConst(strongEntries)) {
+        if (strong.regExp)
+            strong.regExp->mark(e);
+    }
+}
+
 DEFINE_MANAGED_VTABLE(RegExp);
 
 uint RegExp::match(const QString &string, int start, uint *matchOffsets)
@@ -62,7 +204,7 @@ uint RegExp::match(const QString &string, int start, uint *matchOffsets)
     WTF::String s(string);
 
 #if ENABLE(YARR_JIT)
-    if (!jitCode()->isFallBack() && jitCode()->has16BitCode())
+    if (d()->jitCode && !jitCode()->isFallBack() && jitCode()->has16BitCode())
         return uint(jitCode()->execute(s.characters16(), start, s.length(), (int*)matchOffsets).start);
 #endif
 
@@ -77,15 +219,12 @@ Heap::RegExp *RegExp::create(ExecutionEngine* engine, const QString& pattern, bo
     if (!cache)
         cache = engine->regExpCache = new RegExpCache;
 
-    QV4::WeakValue &cachedValue = (*cache)[key];
-    if (QV4::RegExp *result = cachedValue.as<RegExp>())
-        return result->d();
+    if (Heap::RegExp *result = cache->find(key))
+        return result;
 
     Scope scope(engine);
     Scoped<RegExp> result(scope, engine->memoryManager->alloc<RegExp>(engine, pattern, ignoreCase, multiline));
-
-    result->d()->cache = cache;
-    cachedValue.set(engine, result);
+    cache->insert(engine, key, result->d());
 
     return result->d();
 }
@@ -105,11 +244,8 @@ void Heap::RegExp::init(ExecutionEngine* engine, const QString &pattern, bool ig
     OwnPtr<JSC::Yarr::BytecodePattern> p = JSC::Yarr::byteCompile(yarrPattern, engine->bumperPointerAllocator);
     byteCode = p.take();
 #if ENABLE(YARR_JIT)
-    jitCode = new JSC::Yarr::YarrCodeBlock;
-    if (!yarrPattern.m_containsBackreferences && engine->iselFactory->jitCompileRegexps()) {
-        JSC::JSGlobalData dummy(engine->regExpAllocator);
-        JSC::Yarr::jitCompile(yarrPattern, JSC::Yarr::Char16, &dummy, *jitCode);
-    }
+    if (!yarrPattern.m_containsBackreferences && engine->iselFactory->jitCompileRegexps())
+        jitCode = SharedRegExpJitCode::get(RegExpCacheKey(this), yarrPattern);
 #endif
 }
 
@@ -120,7 +256,8 @@ void Heap::RegExp::destroy()
         cache->remove(key);
     }
 #if ENABLE(YARR_JIT)
-    delete jitCode;
+    if (jitCode)
+        jitCode->release();
 #endif
     delete byteCode;
     delete pattern;
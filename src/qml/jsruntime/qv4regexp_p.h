@@ -72,6 +72,9 @@ namespace QV4 {
 
 struct ExecutionEngine;
 struct RegExpCacheKey;
+#if ENABLE(YARR_JIT)
+struct SharedRegExpJitCode;
+#endif
 
 namespace Heap {
 
@@ -82,7 +85,7 @@ struct RegExp : Base {
     QString *pattern;
     JSC::Yarr::BytecodePattern *byteCode;
 #if ENABLE(YARR_JIT)
-    JSC::Yarr::YarrCodeBlock *jitCode;
+    SharedRegExpJitCode *jitCode;
 #endif
     RegExpCache *cache;
     int subPatternCount;
@@ -104,7 +107,7 @@ struct RegExp : public Managed
     QString pattern() const { return *d()->pattern; }
     JSC::Yarr::BytecodePattern *byteCode() { return d()->byteCode; }
 #if ENABLE(YARR_JIT)
-    JSC::Yarr::YarrCodeBlock *jitCode() const { return d()->jitCode; }
+    inline JSC::Yarr::YarrCodeBlock *jitCode() const;
 #endif
     RegExpCache *cache() const { return d()->cache; }
     int subPatternCount() const { return d()->subPatternCount; }
@@ -150,13 +153,75 @@ inline RegExpCacheKey::RegExpCacheKey(const RegExp::Data *re)
 inline uint qHash(const RegExpCacheKey& key, uint seed = 0) Q_DECL_NOTHROW
 { return qHash(key.pattern, seed); }
 
-class RegExpCache : public QHash<RegExpCacheKey, WeakValue>
+#if ENABLE(YARR_JIT)
+// JIT compiled code of a pattern. The code only depends on the pattern and its flags, so it
+// is shared between all engines of the process. The byte code can't be shared, as the
+// interpreter allocates its backtracking state from the engine that compiled it.
+struct SharedRegExpJitCode
+{
+    static SharedRegExpJitCode *get(const RegExpCacheKey &key, JSC::Yarr::YarrPattern &pattern);
+    void release();
+
+    static uint hits();
+    static uint misses();
+
+    JSC::Yarr::YarrCodeBlock codeBlock;
+
+private:
+    SharedRegExpJitCode(const RegExpCacheKey &key) : key(key) {}
+
+    RegExpCacheKey key;
+    int refCount = 1;
+};
+
+JSC::Yarr::YarrCodeBlock *RegExp::jitCode() const
+{
+    return &d()->jitCode->codeBlock;
+}
+#endif
+
+// Maps patterns to the RegExp objects compiled for them. The most recently used regexps
+// are additionally kept alive, so that frequently used patterns don't need to be
+// recompiled after every garbage collection. The size of that tier defaults to
+// DefaultStrongCapacity and can be changed with QV4_REGEXP_CACHE_SIZE.
+class RegExpCache
 {
 public:
+    enum { DefaultStrongCapacity = 32 };
+
+    RegExpCache();
     ~RegExpCache();
-};
 
+    Heap::RegExp *find(const RegExpCacheKey &key);
+    void insert(ExecutionEngine *engine, const RegExpCacheKey &key, Heap::RegExp *regExp);
+    void remove(const RegExpCacheKey &key);
+
+    void markObjects(ExecutionEngine *e);
 
+    int strongCapacity() const { return strongEntries.size(); }
+    void setStrongCapacity(int capacity);
+
+    uint hits() const { return hitCount; }
+    uint misses() const { return missCount; }
+
+private:
+    struct Entry {
+        WeakValue regExp;
+        int strongIndex = -1;
+    };
+    struct StrongEntry {
+        Heap::RegExp *regExp = nullptr;
+        quint64 lastUse = 0;
+    };
+
+    void touch(Entry &entry);
+
+    QHash<RegExpCacheKey, Entry> entries;
+    QVector<StrongEntry> strongEntries;
+    quint64 useCounter = 0;
+    uint hitCount = 0;
+    uint missCount = 0;
+};
 
 }
 
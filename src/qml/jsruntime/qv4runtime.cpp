@@ -219,6 +219,32 @@ void RuntimeCounters::count(const char *func, uint tag1, uint tag2)
 #endif // QV4_COUNT_RUNTIME_FUNCTIONS
 
 #ifndef V4_BOOTSTRAP
+// Integers below 2^53 are exact, so their digits can be written without going through dtoa
+static const double ExactIntegerLimit = 9007199254740992.0;
+
+static inline QChar *writeDecimalDigits(QChar *end, quint64 value)
+{
+    do {
+        *--end = QLatin1Char(char('0' + value % 10));
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+static inline QChar *writeLatin1(QChar *out, const QChar *digits, int count)
+{
+    for (int i = 0; i < count; ++i)
+        *out++ = digits[i];
+    return out;
+}
+
+static inline QChar *writeZeros(QChar *out, int count)
+{
+    for (int i = 0; i < count; ++i)
+        *out++ = QLatin1Char('0');
+    return out;
+}
+
 void RuntimeHelpers::numberToString(QString *result, double num, int radix)
 {
     Q_ASSERT(result);
@@ -232,36 +258,64 @@ void RuntimeHelpers::numberToString(QString *result, double num, int radix)
     }
 
     if (radix == 10) {
+        // 17 characters hold a sign and the 16 digits of any integer below 2^53. -0 prints as "0".
+        QChar buffer[32];
+        if (num > -ExactIntegerLimit && num < ExactIntegerLimit && num == std::floor(num)) {
+            QChar *end = buffer + 17;
+            QChar *begin = writeDecimalDigits(end, quint64(num < 0 ? -num : num));
+            if (num < 0)
+                *--begin = QLatin1Char('-');
+            *result = QString(begin, int(end - begin));
+            return;
+        }
+
         // We cannot use our usual locale->toString(...) here, because EcmaScript has special rules
         // about the longest permissible number, depending on if it's <0 or >0.
         const int ecma_shortest_low = -6;
         const int ecma_shortest_high = 21;
 
-        const QLatin1Char zero('0');
-        const QLatin1Char dot('.');
-
+        // qdtoa produces the shortest digit string that round-trips. Lay it out in one go
+        // instead of inserting into and prepending to the QString it returns.
         int decpt = 0;
         int sign = 0;
-        *result = qdtoa(num, &decpt, &sign);
+        const QString digits = qdtoa(num, &decpt, &sign);
+        const QChar *d = digits.constData();
+        const int ndigits = digits.length();
+        Q_ASSERT(ndigits <= 17);
+
+        QChar *out = buffer;
+        if (sign && num)
+            *out++ = QLatin1Char('-');
 
         if (decpt <= ecma_shortest_low || decpt > ecma_shortest_high) {
-            if (result->length() > 1)
-                result->insert(1, dot);
-            result->append(QLatin1Char('e'));
-            if (decpt > 0)
-                result->append(QLatin1Char('+'));
-            result->append(QString::number(decpt - 1));
+            *out++ = d[0];
+            if (ndigits > 1) {
+                *out++ = QLatin1Char('.');
+                out = writeLatin1(out, d + 1, ndigits - 1);
+            }
+            *out++ = QLatin1Char('e');
+            const int exponent = decpt - 1;
+            *out++ = QLatin1Char(exponent < 0 ? '-' : '+');
+            QChar exponentDigits[4];
+            QChar *exponentEnd = exponentDigits + 4;
+            QChar *exponentBegin = writeDecimalDigits(exponentEnd, quint64(qAbs(exponent)));
+            out = writeLatin1(out, exponentBegin, int(exponentEnd - exponentBegin));
         } else if (decpt <= 0) {
-            result->prepend(QLatin1String("0.") + QString(-decpt, zero));
-        } else if (decpt < result->length()) {
-            result->insert(decpt, dot);
+            *out++ = QLatin1Char('0');
+            *out++ = QLatin1Char('.');
+            out = writeZeros(out, -decpt);
+            out = writeLatin1(out, d, ndigits);
+        } else if (decpt < ndigits) {
+            out = writeLatin1(out, d, decpt);
+            *out++ = QLatin1Char('.');
+            out = writeLatin1(out, d + decpt, ndigits - decpt);
         } else {
-            result->append(QString(decpt - result->length(), zero));
+            out = writeLatin1(out, d, ndigits);
+            out = writeZeros(out, decpt - ndigits);
         }
 
-        if (sign && num)
-            result->prepend(QLatin1Char('-'));
-
+        Q_ASSERT(out - buffer <= 32);
+        *result = QString(buffer, int(out - buffer));
         return;
     }
 
@@ -369,6 +423,26 @@ QV4::ReturnedValue Runtime::method_in(ExecutionEngine *engine, const Value &left
 
 double RuntimeHelpers::stringToNumber(const QString &string)
 {
+    // Short strings of plain decimal digits, like the ones we produce for integers, don't
+    // need trimming or a trip through Latin-1 and strtod.
+    const int length = string.length();
+    if (length > 0 && length <= 9) {
+        const QChar *c = string.constData();
+        const bool negative = (c->unicode() == '-');
+        int i = negative ? 1 : 0;
+        if (i < length) {
+            int value = 0;
+            for (; i < length; ++i) {
+                const uint digit = c[i].unicode() - '0';
+                if (digit > 9)
+                    break;
+                value = value * 10 + int(digit);
+            }
+            if (i == length)
+                return negative ? -double(value) : double(value);
+        }
+    }
+
     const QStringRef s = QStringRef(&string).trimmed();
     if (s.startsWith(QLatin1String("0x")) || s.startsWith(QLatin1String("0X")))
         return s.toLong(0, 16);
@@ -388,8 +462,30 @@ double RuntimeHelpers::stringToNumber(const QString &string)
     return d;
 }
 
+static inline bool isCachedNumberString(double number, uint *key)
+{
+    if (!(number >= 0 && number < ExecutionEngine::NumberStringCacheLimit))
+        return false;
+    *key = uint(number);
+    return *key == number;
+}
+
 Heap::String *RuntimeHelpers::stringFromNumber(ExecutionEngine *engine, double number)
 {
+    uint key;
+    if (isCachedNumberString(number, &key)) {
+        const uint slot = key % ExecutionEngine::NumberStringCacheSize;
+        Value &cached = engine->numberStringCache[slot];
+        if (cached.isString() && engine->numberStringCacheKeys[slot] == key)
+            return static_cast<Heap::String *>(cached.heapObject());
+        QString qstr;
+        RuntimeHelpers::numberToString(&qstr, number, 10);
+        Heap::String *s = engine->newString(qstr);
+        cached = s;
+        engine->numberStringCacheKeys[slot] = key;
+        return s;
+    }
+
     QString qstr;
     RuntimeHelpers::numberToString(&qstr, number, 10);
     return engine->newString(qstr);
@@ -491,6 +587,17 @@ Heap::String *RuntimeHelpers::convertToString(ExecutionEngine *engine, const Val
 
 // This is slightly different from the method above, as
 // the + operator requires a slightly different conversion
+// Numbers that get concatenated with a string usually don't outlive the expression
+static Heap::String *temporaryStringFromNumber(ExecutionEngine *engine, double number)
+{
+    uint key;
+    if (isCachedNumberString(number, &key))
+        return RuntimeHelpers::stringFromNumber(engine, number);
+    QString qstr;
+    RuntimeHelpers::numberToString(&qstr, number, 10);
+    return engine->memoryManager->allocTemporaryString(qstr);
+}
+
 static Heap::String *convert_to_string_add(ExecutionEngine *engine, const Value &value)
 {
     switch (value.type()) {
@@ -514,9 +621,9 @@ static Heap::String *convert_to_string_add(ExecutionEngine *engine, const Value
             return RuntimeHelpers::convertToString(engine, prim);
         }
     case Value::Integer_Type:
-        return RuntimeHelpers::stringFromNumber(engine, value.int_32());
+        return temporaryStringFromNumber(engine, value.int_32());
     default: // double
-        return RuntimeHelpers::stringFromNumber(engine, value.doubleValue());
+        return temporaryStringFromNumber(engine, value.doubleValue());
     } // switch
 }
 
@@ -543,8 +650,7 @@ QV4::ReturnedValue RuntimeHelpers::addHelper(ExecutionEngine *engine, const Valu
             return sright->asReturnedValue();
         if (!sright->d()->length())
             return sleft->asReturnedValue();
-        MemoryManager *mm = engine->memoryManager;
-        return (mm->alloc<String>(mm, sleft->d(), sright->d()))->asReturnedValue();
+        return String::concat(engine, sleft->d(), sright->d())->asReturnedValue();
     }
     double x = RuntimeHelpers::toNumber(pleft);
     double y = RuntimeHelpers::toNumber(pright);
@@ -575,8 +681,7 @@ QV4::ReturnedValue Runtime::method_addString(ExecutionEngine *engine, const Valu
         return pright->asReturnedValue();
     if (!sright->d()->length())
         return pleft->asReturnedValue();
-    MemoryManager *mm = engine->memoryManager;
-    return (mm->alloc<String>(mm, sleft->d(), sright->d()))->asReturnedValue();
+    return String::concat(engine, sleft->d(), sright->d())->asReturnedValue();
 }
 
 void Runtime::method_setProperty(ExecutionEngine *engine, const Value &object, int nameIndex, const Value &value)
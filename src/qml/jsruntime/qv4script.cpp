@@ -45,6 +45,7 @@
 #include "qv4debugging_p.h"
 #include "qv4profiling_p.h"
 #include "qv4scopedvalue_p.h"
+#include "qv4tieredcompiler_p.h"
 
 #include <private/qqmljsengine_p.h>
 #include <private/qqmljslexer_p.h>
@@ -131,11 +132,27 @@ void Script::parse()
         if (v4->hasException)
             return;
 
+        // Start out in the interpreter if we can compile the source again for the JIT later on.
+        // The debugger needs code that it can step through, so leave it alone.
+        TieredCompiler *tieredCompiler = v4->debugger() ? 0 : v4->tieredCompiler;
+        EvalISelFactory *iselFactory = tieredCompiler ? tieredCompiler->interpreterFactory() : v4->iselFactory.data();
+
         QV4::Compiler::JSUnitGenerator jsGenerator(&module);
-        QScopedPointer<EvalInstructionSelection> isel(v4->iselFactory->create(QQmlEnginePrivate::get(v4), v4->executableAllocator, &module, &jsGenerator));
+        QScopedPointer<EvalInstructionSelection> isel(iselFactory->create(QQmlEnginePrivate::get(v4), v4->executableAllocator, &module, &jsGenerator));
         if (inheritContext)
             isel->setUseFastLookups(false);
         compilationUnit = isel->compile();
+        if (tieredCompiler) {
+            TieredCompilationSource source;
+            source.sourceCode = sourceCode;
+            source.sourceFile = sourceFile;
+            source.inheritedLocals = inheritedLocals;
+            source.line = line;
+            source.strictMode = strictMode;
+            source.parseAsBinding = parseAsBinding;
+            source.useFastLookups = !inheritContext;
+            tieredCompiler->attach(compilationUnit.data(), source);
+        }
         vmFunction = compilationUnit->linkToEngine(v4);
     }
 
@@ -186,7 +203,8 @@ Function *Script::function()
     return vmFunction;
 }
 
-QQmlRefPointer<QV4::CompiledData::CompilationUnit> Script::precompile(IR::Module *module, Compiler::JSUnitGenerator *unitGenerator, ExecutionEngine *engine, const QUrl &url, const QString &source, QList<QQmlError> *reportedErrors, QQmlJS::Directives *directivesCollector)
+QQmlRefPointer<QV4::CompiledData::CompilationUnit> Script::precompile(IR::Module *module, Compiler::JSUnitGenerator *unitGenerator, ExecutionEngine *engine, const QUrl &url, const QString &source, QList<QQmlError> *reportedErrors, QQmlJS::Directives *directivesCollector,
+                                                                     bool compileInBackground)
 {
     using namespace QQmlJS;
     using namespace QQmlJS::AST;
@@ -239,9 +257,24 @@ QQmlRefPointer<QV4::CompiledData::CompilationUnit> Script::precompile(IR::Module
         return 0;
     }
 
-    QScopedPointer<EvalInstructionSelection> isel(engine->iselFactory->create(QQmlEnginePrivate::get(engine), engine->executableAllocator, module, unitGenerator));
+    // Units that are compiled in the background run in the interpreter until the JIT is done.
+    TieredCompiler *tieredCompiler = (compileInBackground && !engine->debugger()) ? engine->tieredCompiler : 0;
+    EvalISelFactory *iselFactory = tieredCompiler ? tieredCompiler->interpreterFactory() : engine->iselFactory.data();
+
+    QScopedPointer<EvalInstructionSelection> isel(iselFactory->create(QQmlEnginePrivate::get(engine), engine->executableAllocator, module, unitGenerator));
     isel->setUseFastLookups(false);
-    return isel->compile(/*generate unit data*/false);
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> compilationUnit = isel->compile(/*generate unit data*/false);
+    if (tieredCompiler) {
+        TieredCompilationSource tieredSource;
+        tieredSource.sourceCode = source;
+        tieredSource.sourceFile = url.toString();
+        tieredSource.line = 1;
+        tieredSource.strictMode = false;
+        tieredSource.parseAsBinding = false;
+        tieredSource.useFastLookups = false;
+        tieredCompiler->attach(compilationUnit.data(), tieredSource, TieredCompiler::CompileNow);
+    }
+    return compilationUnit;
 }
 
 QV4::ReturnedValue Script::evaluate(ExecutionEngine *engine, const QString &script, QmlContext *qmlContext)
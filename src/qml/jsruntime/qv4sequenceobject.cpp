@@ -49,6 +49,7 @@
 #include "qv4objectiterator_p.h"
 #include <private/qqmlvaluetypewrapper_p.h>
 #include <private/qqmlmodelindexvaluetype_p.h>
+#include <private/qqmlnotifier_p.h>
 #include <QtCore/qabstractitemmodel.h>
 
 #include <algorithm>
@@ -208,6 +209,41 @@ template <> bool convertValueToElement(const Value &value)
     return value.toBoolean();
 }
 
+// Watches the NOTIFY signal of the property a sequence refers to, so that the sequence only
+// needs to read the property again after it changed.
+class QQmlSequenceEndpoint : public QQmlNotifierEndpoint
+{
+public:
+    QQmlSequenceEndpoint()
+        : QQmlNotifierEndpoint(QQmlNotifierEndpoint::QQmlSequenceEndpoint)
+        , containerIsValid(false)
+    {}
+
+    bool containerIsValid;
+};
+
+void QQmlSequenceEndpoint_callback(QQmlNotifierEndpoint *e, void **)
+{
+    static_cast<QQmlSequenceEndpoint *>(e)->containerIsValid = false;
+}
+
+// Returns an endpoint if the property can be watched, that is when it is constant or has a
+// NOTIFY signal, and we have a QML engine to connect to the signal with.
+static QQmlSequenceEndpoint *createSequenceEndpoint(QV4::ExecutionEngine *v4, QObject *object, int propertyIndex)
+{
+    QQmlEngine *engine = v4->qmlEngine();
+    if (!engine)
+        return nullptr;
+    const QMetaProperty property = object->metaObject()->property(propertyIndex);
+    if (property.isConstant())
+        return new QQmlSequenceEndpoint;
+    if (!property.hasNotifySignal())
+        return nullptr;
+    QQmlSequenceEndpoint *endpoint = new QQmlSequenceEndpoint;
+    endpoint->connect(object, QMetaObjectPrivate::signalIndex(property.notifySignal()), engine);
+    return endpoint;
+}
+
 namespace QV4 {
 
 template <typename Container> struct QQmlSequence;
@@ -219,12 +255,14 @@ struct QQmlSequence : Object {
     void init(const Container &container);
     void init(QObject *object, int propertyIndex);
     void destroy() {
+        delete endpoint;
         delete container;
         object.destroy();
         Object::destroy();
     }
 
     mutable Container *container;
+    QQmlSequenceEndpoint *endpoint;
     QQmlQPointer<QObject> object;
     int propertyIndex;
     bool isReference;
@@ -525,8 +563,13 @@ public:
     {
         Q_ASSERT(d()->object);
         Q_ASSERT(d()->isReference);
+        QQmlSequenceEndpoint *endpoint = d()->endpoint;
+        if (endpoint && endpoint->containerIsValid)
+            return;
         void *a[] = { d()->container, 0 };
         QMetaObject::metacall(d()->object, QMetaObject::ReadProperty, d()->propertyIndex, a);
+        if (endpoint)
+            endpoint->containerIsValid = true;
     }
 
     void storeReference()
@@ -537,6 +580,70 @@ public:
         QQmlPropertyData::WriteFlags flags = QQmlPropertyData::DontRemoveBinding;
         void *a[] = { d()->container, 0, &status, &flags };
         QMetaObject::metacall(d()->object, QMetaObject::WriteProperty, d()->propertyIndex, a);
+        // the setter may have adjusted or rejected the new value
+        if (d()->endpoint)
+            d()->endpoint->containerIsValid = false;
+    }
+
+    void forEach(Scope &scope, CallData *callData)
+    {
+        if (d()->isReference) {
+            if (!d()->object)
+                RETURN_UNDEFINED();
+            loadReference();
+        }
+
+        ScopedFunctionObject callback(scope, callData->argument(0));
+        if (!callback)
+            THROW_TYPE_ERROR();
+
+        ScopedCallData cData(scope, 3);
+        cData->thisObject = callData->argument(1);
+        cData->args[2] = *this;
+
+        const uint len = d()->container->count();
+        for (uint k = 0; k < len; ++k) {
+            // the callback may modify the sequence, but reading it again is cheap while the
+            // property didn't change
+            bool exists;
+            cData->args[0] = containerGetIndexed(k, &exists);
+            if (!exists)
+                continue;
+            cData->args[1] = Primitive::fromDouble(k);
+            callback->call(scope, cData);
+            CHECK_EXCEPTION();
+        }
+        RETURN_UNDEFINED();
+    }
+
+    void slice(Scope &scope, CallData *callData)
+    {
+        const double s = callData->argument(0).toInteger();
+        const bool hasEnd = callData->argc > 1 && !callData->args[1].isUndefined();
+        const double e = hasEnd ? callData->args[1].toInteger() : 0;
+        CHECK_EXCEPTION();
+
+        ScopedArrayObject result(scope, scope.engine->newArrayObject());
+        if (d()->isReference) {
+            if (!d()->object)
+                RETURN_RESULT(result);
+            loadReference();
+        }
+
+        const Container &container = *d()->container;
+        const double len = container.count();
+        const int start = int(s < 0 ? qMax(len + s, 0.) : qMin(s, len));
+        const int end = int(!hasEnd ? len : e < 0 ? qMax(len + e, 0.) : qMin(e, len));
+        if (end > start) {
+            result->arrayReserve(end - start);
+            ScopedValue v(scope);
+            for (int i = start; i < end; ++i) {
+                v = convertElementToValue(scope.engine, container.at(i));
+                result->arrayPut(i - start, v);
+            }
+            result->setArrayLengthUnchecked(end - start);
+        }
+        RETURN_RESULT(result);
     }
 
     static QV4::ReturnedValue getIndexed(const QV4::Managed *that, uint index, bool *hasProperty)
@@ -560,6 +667,7 @@ void Heap::QQmlSequence<Container>::init(const Container &container)
 {
     Object::init();
     this->container = new Container(container);
+    endpoint = nullptr;
     propertyIndex = -1;
     isReference = false;
     object.init();
@@ -578,6 +686,7 @@ void Heap::QQmlSequence<Container>::init(QObject *object, int propertyIndex)
     this->propertyIndex = propertyIndex;
     isReference = true;
     this->object.init(object);
+    endpoint = createSequenceEndpoint(internalClass->engine, object, propertyIndex);
     QV4::Scope scope(internalClass->engine);
     QV4::Scoped<QV4::QQmlSequence<Container> > o(scope, this);
     o->setArrayType(Heap::ArrayData::Custom);
@@ -619,10 +728,50 @@ void SequencePrototype::init()
 {
     FOREACH_QML_SEQUENCE_TYPE(REGISTER_QML_SEQUENCE_METATYPE)
     defineDefaultProperty(QStringLiteral("sort"), method_sort, 1);
+    defineDefaultProperty(QStringLiteral("forEach"), method_forEach, 1);
+    defineDefaultProperty(QStringLiteral("slice"), method_slice, 2);
     defineDefaultProperty(engine()->id_valueOf(), method_valueOf, 0);
 }
 #undef REGISTER_QML_SEQUENCE_METATYPE
 
+void SequencePrototype::method_forEach(const BuiltinFunction *b, Scope &scope, CallData *callData)
+{
+    QV4::ScopedObject o(scope, callData->thisObject);
+    if (!o || !o->isListType())
+        return ArrayPrototype::method_forEach(b, scope, callData);
+
+#define CALL_FOREACH(SequenceElementType, SequenceElementTypeName, SequenceType, DefaultValue) \
+        if (QQml##SequenceElementTypeName##List *s = o->as<QQml##SequenceElementTypeName##List>()) { \
+            s->forEach(scope, callData); \
+            return; \
+        } else
+
+        FOREACH_QML_SEQUENCE_TYPE(CALL_FOREACH)
+
+#undef CALL_FOREACH
+        {}
+    ArrayPrototype::method_forEach(b, scope, callData);
+}
+
+void SequencePrototype::method_slice(const BuiltinFunction *b, Scope &scope, CallData *callData)
+{
+    QV4::ScopedObject o(scope, callData->thisObject);
+    if (!o || !o->isListType())
+        return ArrayPrototype::method_slice(b, scope, callData);
+
+#define CALL_SLICE(SequenceElementType, SequenceElementTypeName, SequenceType, DefaultValue) \
+        if (QQml##SequenceElementTypeName##List *s = o->as<QQml##SequenceElementTypeName##List>()) { \
+            s->slice(scope, callData); \
+            return; \
+        } else
+
+        FOREACH_QML_SEQUENCE_TYPE(CALL_SLICE)
+
+#undef CALL_SLICE
+        {}
+    ArrayPrototype::method_slice(b, scope, callData);
+}
+
 void SequencePrototype::method_sort(const BuiltinFunction *b, Scope &scope, CallData *callData)
 {
     QV4::ScopedObject o(scope, callData->thisObject);
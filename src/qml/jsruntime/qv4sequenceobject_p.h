@@ -73,6 +73,8 @@ struct SequencePrototype : public QV4::Object
     }
 
     static void method_sort(const BuiltinFunction *, Scope &scope, CallData *callData);
+    static void method_forEach(const BuiltinFunction *, Scope &scope, CallData *callData);
+    static void method_slice(const BuiltinFunction *, Scope &scope, CallData *callData);
 
     static bool isSequenceType(int sequenceTypeId);
     static ReturnedValue newSequence(QV4::ExecutionEngine *engine, int sequenceTypeId, QObject *object, int propertyIndex, bool *succeeded);
@@ -42,6 +42,7 @@
 #include "qv4object_p.h"
 #include "qv4functionobject_p.h"
 #include "qv4scopedvalue_p.h"
+#include <QtCore/qatomic.h>
 #include <stdlib.h>
 
 #ifdef QT_QMAP_DEBUG
@@ -323,7 +324,7 @@ void SparseArray::deleteNode(SparseArrayNode *z)
     if (x)
         x->setColor(SparseArrayNode::Black);
     }
-    free(y);
+    releaseNode(y);
     --numEntries;
 }
 
@@ -334,33 +335,27 @@ void SparseArray::recalcMostLeftNode()
         mostLeftNode = mostLeftNode->left;
 }
 
-static inline int qMapAlignmentThreshold()
+SparseArrayNode *SparseArray::allocateNode()
 {
-    // malloc on 32-bit platforms should return pointers that are 8-byte
-    // aligned or more while on 64-bit platforms they should be 16-byte aligned
-    // or more
-    return 2 * sizeof(void*);
-}
-
-static inline void *qMapAllocate(int alloc, int alignment)
-{
-    return alignment > qMapAlignmentThreshold()
-        ? qMallocAligned(alloc, alignment)
-        : ::malloc(alloc);
-}
-
-static inline void qMapDeallocate(SparseArrayNode *node, int alignment)
-{
-    if (alignment > qMapAlignmentThreshold())
-        qFreeAligned(node);
-    else
-        ::free(node);
+    if (!freeNodes) {
+        const uint size = nextChunkSize;
+        NodeChunk *chunk = static_cast<NodeChunk *>(::malloc(sizeof(NodeChunk) + (size - 1) * sizeof(SparseArrayNode)));
+        Q_CHECK_PTR(chunk);
+        chunk->next = chunks;
+        chunks = chunk;
+        // hand out the nodes in address order
+        for (uint i = size; i > 0; --i)
+            releaseNode(chunk->nodes + i - 1);
+        nextChunkSize = qMin<uint>(2 * size, MaxChunkSize);
+    }
+    SparseArrayNode *node = freeNodes;
+    freeNodes = node->left;
+    return node;
 }
 
 SparseArrayNode *SparseArray::createNode(uint sl, SparseArrayNode *parent, bool left)
 {
-    SparseArrayNode *node = static_cast<SparseArrayNode *>(qMapAllocate(sizeof(SparseArrayNode), Q_ALIGNOF(SparseArrayNode)));
-    Q_CHECK_PTR(node);
+    SparseArrayNode *node = allocateNode();
 
     node->p = (quintptr)parent;
     node->left = 0;
@@ -383,17 +378,18 @@ SparseArrayNode *SparseArray::createNode(uint sl, SparseArrayNode *parent, bool
     return node;
 }
 
-void SparseArray::freeTree(SparseArrayNode *root, int alignment)
+uint SparseArray::nextVersion()
 {
-    if (root->left)
-        freeTree(root->left, alignment);
-    if (root->right)
-        freeTree(root->right, alignment);
-    qMapDeallocate(root, alignment);
+    static QBasicAtomicInteger<uint> lastVersion = Q_BASIC_ATOMIC_INITIALIZER(0);
+    return lastVersion.fetchAndAddRelaxed(1) + 1;
 }
 
 SparseArray::SparseArray()
     : numEntries(0)
+    , chunks(0)
+    , freeNodes(0)
+    , nextChunkSize(MinChunkSize)
+    , currentVersion(nextVersion())
 {
     header.p = 0;
     header.left = 0;
@@ -401,10 +397,26 @@ SparseArray::SparseArray()
     mostLeftNode = &header;
 }
 
+SparseArray::~SparseArray()
+{
+    while (chunks) {
+        NodeChunk *next = chunks->next;
+        ::free(chunks);
+        chunks = next;
+    }
+}
+
 SparseArray::SparseArray(const SparseArray &other)
+    : numEntries(0)
+    , chunks(0)
+    , freeNodes(0)
+    , nextChunkSize(MinChunkSize)
+    , currentVersion(nextVersion())
 {
     header.p = 0;
+    header.left = 0;
     header.right = 0;
+    mostLeftNode = &header;
     if (other.header.left) {
         header.left = other.header.left->copy(this);
         header.left->setParent(&header);
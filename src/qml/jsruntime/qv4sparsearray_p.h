@@ -144,18 +144,41 @@ inline SparseArrayNode *SparseArrayNode::upperBound(uint akey)
 struct Q_QML_EXPORT SparseArray
 {
     SparseArray();
-    ~SparseArray() {
-        if (root())
-            freeTree(header.left, Q_ALIGNOF(SparseArrayNode));
-    }
+    ~SparseArray();
 
     SparseArray(const SparseArray &other);
+
+    // Unique among all sparse arrays, and changes whenever a node is released. Iterators that
+    // hold on to a node can check it to know whether the node is still valid.
+    uint version() const { return currentVersion; }
+
 private:
     SparseArray &operator=(const SparseArray &other);
 
+    // Nodes are carved out of chunks that grow geometrically, instead of being
+    // allocated one by one. This keeps nodes that were inserted together close
+    // to each other in memory and avoids the per allocation overhead of malloc.
+    struct NodeChunk {
+        NodeChunk *next;
+        SparseArrayNode nodes[1];
+    };
+    enum { MinChunkSize = 8, MaxChunkSize = 1024 };
+
     int numEntries;
     SparseArrayNode header;
     SparseArrayNode *mostLeftNode;
+    NodeChunk *chunks;
+    SparseArrayNode *freeNodes;
+    uint nextChunkSize;
+    uint currentVersion;
+
+    static uint nextVersion();
+    SparseArrayNode *allocateNode();
+    void releaseNode(SparseArrayNode *node) {
+        node->left = freeNodes;
+        freeNodes = node;
+        currentVersion = nextVersion();
+    }
 
     void rotateLeft(SparseArrayNode *x);
     void rotateRight(SparseArrayNode *x);
@@ -169,7 +192,6 @@ private:
 
 public:
     SparseArrayNode *createNode(uint sl, SparseArrayNode *parent, bool left);
-    void freeTree(SparseArrayNode *root, int alignment);
 
     SparseArrayNode *findNode(uint akey) const;
 
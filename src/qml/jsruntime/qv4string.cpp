@@ -44,6 +44,8 @@
 #include "qv4runtime_p.h"
 #include "qv4objectproto_p.h"
 #include "qv4stringobject_p.h"
+#include "qv4scopedvalue_p.h"
+#include <private/qv4mm_p.h>
 #endif
 #include <QtCore/QHash>
 #include <QtCore/private/qnumeric_p.h>
@@ -88,6 +90,7 @@ void Heap::String::init(MemoryManager *mm, const QString &t)
     stringHash = UINT_MAX;
     largestSubLength = 0;
     len = text->size;
+    depth = 0;
 }
 
 void Heap::String::init(MemoryManager *mm, String *l, String *r)
@@ -109,9 +112,8 @@ void Heap::String::init(MemoryManager *mm, String *l, String *r)
     if (!r->largestSubLength && r->len > largestSubLength)
         largestSubLength = r->len;
 
-    // make sure we don't get excessive depth in our strings
-    if (len > 256 && len >= 2*largestSubLength)
-        simplifyString();
+    // Flattening is left to whoever needs the characters, String::concat() bounds the depth
+    depth = qMax(l->depth, r->depth) + 1;
 }
 
 void Heap::String::destroy() {
@@ -161,37 +163,176 @@ void Heap::String::simplifyString() const
     text->ref.ref();
     identifier = 0;
     largestSubLength = 0;
+    depth = 0;
     mm->changeUnmanagedHeapSizeUsage(qptrdiff(text->size) * (qptrdiff)sizeof(QChar));
 }
 
 void Heap::String::append(const String *data, QChar *ch)
 {
-    std::vector<const String *> worklist;
-    worklist.reserve(32);
-    worklist.push_back(data);
+    data->forEachLeaf([&ch](const String *leaf) {
+        memcpy(ch, leaf->text->data(), leaf->text->size * sizeof(QChar));
+        ch += leaf->text->size;
+    });
+}
+
+void Heap::String::createHashValue() const
+{
+    if (!largestSubLength) {
+        const QChar *ch = reinterpret_cast<const QChar *>(text->data());
+        const QChar *end = ch + text->size;
+        stringHash = QV4::String::calculateHashValue(ch, end, &subtype);
+        return;
+    }
+
+    // Array indices have at most 10 digits. Longer ropes hash like regular strings, which
+    // can be done leaf by leaf without flattening them.
+    if (len <= 10) {
+        QChar buffer[10];
+        append(this, buffer);
+        stringHash = QV4::String::calculateHashValue(buffer, buffer + len, &subtype);
+        return;
+    }
+
+    uint h = UINT_MAX;
+    forEachLeaf([&h](const String *leaf) {
+        const QChar *ch = reinterpret_cast<const QChar *>(leaf->text->data());
+        const QChar *end = ch + leaf->text->size;
+        while (ch < end) {
+            h = 31 * h + ch->unicode();
+            ++ch;
+        }
+    });
+    stringHash = h;
+    subtype = StringType_Regular;
+}
+
+namespace {
+// Hands out the leaves of a rope one by one, from left to right
+struct LeafReader
+{
+    LeafReader(const Heap::String *s)
+    {
+        worklist.reserve(s->depth + 1);
+        worklist.push_back(s);
+    }
+
+    bool next(const QChar **ch, int *size)
+    {
+        while (!worklist.empty()) {
+            const Heap::String *item = worklist.back();
+            worklist.pop_back();
+
+            if (item->largestSubLength) {
+                worklist.push_back(item->right);
+                worklist.push_back(item->left);
+            } else {
+                *ch = reinterpret_cast<const QChar *>(item->text->data());
+                *size = item->text->size;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<const Heap::String *> worklist;
+};
+
+struct RopePiece
+{
+    size_t firstLeaf;
+    size_t endLeaf;
+    uint length;
+};
+}
+
+bool Heap::String::ropeEquals(const String *other) const
+{
+    Q_ASSERT(len == other->len);
+
+    LeafReader a(this);
+    LeafReader b(other);
+    const QChar *chA = nullptr;
+    const QChar *chB = nullptr;
+    int sizeA = 0;
+    int sizeB = 0;
+    while (true) {
+        if (!sizeA && !a.next(&chA, &sizeA))
+            break;
+        if (!sizeB && !b.next(&chB, &sizeB))
+            break;
+        int n = qMin(sizeA, sizeB);
+        if (memcmp(chA, chB, n * sizeof(QChar)))
+            return false;
+        chA += n;
+        sizeA -= n;
+        chB += n;
+        sizeB -= n;
+    }
+    return true;
+}
 
-    while (!worklist.empty()) {
-        const String *item = worklist.back();
-        worklist.pop_back();
+// Builds left + right out of pieces that at least halve in length from left to right, so the
+// result is at most log2(length) deep. A piece is either a leaf of the two ropes, or a flat
+// copy of neighbouring leaves that were too short to stand on their own. Short leaves get
+// merged into longer ones as a string keeps growing, so appending in a loop copies each
+// character a logarithmic number of times in total, instead of once per append.
+static Heap::String *rebalancedConcat(ExecutionEngine *engine, Heap::String *left, Heap::String *right)
+{
+    MemoryManager *mm = engine->memoryManager;
+    Scope scope(engine);
+    // keep the leaves alive while the pieces get allocated
+    ScopedString l(scope, left);
+    ScopedString r(scope, right);
+
+    std::vector<const Heap::String *> leaves;
+    auto addLeaf = [&leaves](const Heap::String *leaf) {
+        if (leaf->len)
+            leaves.push_back(leaf);
+    };
+    left->forEachLeaf(addLeaf);
+    right->forEachLeaf(addLeaf);
+    Q_ASSERT(!leaves.empty());
+
+    std::vector<RopePiece> pieces;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        pieces.push_back({ i, i + 1, leaves.at(i)->len });
+        while (pieces.size() >= 2 && pieces.at(pieces.size() - 2).length < 2 * pieces.back().length) {
+            RopePiece last = pieces.back();
+            pieces.pop_back();
+            pieces.back().endLeaf = last.endLeaf;
+            pieces.back().length += last.length;
+        }
+    }
 
-        if (item->largestSubLength) {
-            worklist.push_back(item->right);
-            worklist.push_back(item->left);
-        } else {
-            memcpy(ch, item->text->data(), item->text->size * sizeof(QChar));
-            ch += item->text->size;
+    const int nPieces = int(pieces.size());
+    Value *flat = scope.alloc(nPieces);
+    for (int i = 0; i < nPieces; ++i) {
+        const RopePiece &p = pieces.at(i);
+        if (p.endLeaf - p.firstLeaf == 1) {
+            flat[i] = const_cast<Heap::String *>(leaves.at(p.firstLeaf));
+            continue;
+        }
+        QString text(int(p.length), Qt::Uninitialized);
+        QChar *ch = const_cast<QChar *>(text.constData());
+        for (size_t j = p.firstLeaf; j < p.endLeaf; ++j) {
+            const Heap::String *leaf = leaves.at(j);
+            memcpy(ch, leaf->text->data(), leaf->text->size * sizeof(QChar));
+            ch += leaf->text->size;
         }
+        flat[i] = mm->allocTemporaryString(text);
     }
+
+    ScopedString result(scope, flat[nPieces - 1]);
+    for (int i = nPieces - 2; i >= 0; --i)
+        result = mm->allocTemporaryString(flat[i].stringValue()->d(), result->d());
+    return result->d();
 }
 
-void Heap::String::createHashValue() const
+Heap::String *String::concat(ExecutionEngine *engine, Heap::String *left, Heap::String *right)
 {
-    if (largestSubLength)
-        simplifyString();
-    Q_ASSERT(!largestSubLength);
-    const QChar *ch = reinterpret_cast<const QChar *>(text->data());
-    const QChar *end = ch + text->size;
-    stringHash = QV4::String::calculateHashValue(ch, end, &subtype);
+    if (Q_LIKELY(qMax(left->depth, right->depth) < Heap::String::MaxRopeDepth))
+        return engine->memoryManager->allocTemporaryString(left, right);
+    return rebalancedConcat(engine, left, right);
 }
 
 uint String::getLength(const Managed *m)
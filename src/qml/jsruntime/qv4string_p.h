@@ -51,6 +51,7 @@
 //
 
 #include <QtCore/qstring.h>
+#include <vector>
 #include "qv4managed_p.h"
 #include <QtCore/private/qnumeric_p.h>
 
@@ -70,6 +71,9 @@ struct Q_QML_PRIVATE_EXPORT String : Base {
         StringType_ArrayIndex
     };
 
+    // Ropes get rebalanced by QV4::String::concat() before growing deeper than this
+    enum { MaxRopeDepth = 48 };
+
 #ifndef V4_BOOTSTRAP
     void init(MemoryManager *mm, const QString &text);
     void init(MemoryManager *mm, String *l, String *n);
@@ -88,7 +92,6 @@ struct Q_QML_PRIVATE_EXPORT String : Base {
     inline unsigned hashValue() const {
         if (subtype == StringType_Unknown)
             createHashValue();
-        Q_ASSERT(!largestSubLength);
 
         return stringHash;
     }
@@ -102,16 +105,21 @@ struct Q_QML_PRIVATE_EXPORT String : Base {
     inline bool isEqualTo(const String *other) const {
         if (this == other)
             return true;
+        if (len != other->len)
+            return false;
         if (hashValue() != other->hashValue())
             return false;
-        Q_ASSERT(!largestSubLength);
-        if (identifier && identifier == other->identifier)
-            return true;
         if (subtype == Heap::String::StringType_ArrayIndex && other->subtype == Heap::String::StringType_ArrayIndex)
             return true;
+        // comparing ropes doesn't flatten them, and identifier shares its storage with right
+        if (largestSubLength || other->largestSubLength)
+            return ropeEquals(other);
+        if (identifier && identifier == other->identifier)
+            return true;
 
         return toQString() == other->toQString();
     }
+    bool ropeEquals(const String *other) const;
 
     union {
         mutable QStringData *text;
@@ -125,13 +133,44 @@ struct Q_QML_PRIVATE_EXPORT String : Base {
     mutable uint stringHash;
     mutable uint largestSubLength;
     uint len;
+    mutable uint depth; // 0 for flat strings
     MemoryManager *mm;
+
+    template <typename F>
+    inline void forEachLeaf(F f) const;
 private:
     static void append(const String *data, QChar *ch);
 #endif
 };
 V4_ASSERT_IS_TRIVIAL(String)
 
+#ifndef V4_BOOTSTRAP
+template <typename F>
+inline void String::forEachLeaf(F f) const
+{
+    if (!largestSubLength) {
+        f(this);
+        return;
+    }
+
+    std::vector<const String *> worklist;
+    worklist.reserve(depth + 1);
+    worklist.push_back(this);
+
+    while (!worklist.empty()) {
+        const String *item = worklist.back();
+        worklist.pop_back();
+
+        if (item->largestSubLength) {
+            worklist.push_back(item->right);
+            worklist.push_back(item->left);
+        } else {
+            f(item);
+        }
+    }
+}
+#endif
+
 }
 
 struct Q_QML_PRIVATE_EXPORT String : public Managed {
@@ -167,7 +206,6 @@ struct Q_QML_PRIVATE_EXPORT String : public Managed {
     uint asArrayIndex() const {
         if (subtype() == Heap::String::StringType_Unknown)
             d()->createHashValue();
-        Q_ASSERT(!d()->largestSubLength);
         if (subtype() == Heap::String::StringType_ArrayIndex)
             return d()->stringHash;
         return UINT_MAX;
@@ -175,7 +213,7 @@ struct Q_QML_PRIVATE_EXPORT String : public Managed {
     uint toUInt(bool *ok) const;
 
     void makeIdentifier(ExecutionEngine *e) const {
-        if (d()->identifier)
+        if (!d()->largestSubLength && d()->identifier)
             return;
         makeIdentifierImpl(e);
     }
@@ -201,7 +239,9 @@ struct Q_QML_PRIVATE_EXPORT String : public Managed {
         return l->text->size && QChar::isUpper(l->text->data()[0]);
     }
 
-    Identifier *identifier() const { return d()->identifier; }
+    Identifier *identifier() const { return d()->largestSubLength ? nullptr : d()->identifier; }
+
+    static Heap::String *concat(ExecutionEngine *engine, Heap::String *left, Heap::String *right);
 
 protected:
     static void markObjects(Heap::Base *that, ExecutionEngine *e);
@@ -0,0 +1,271 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4tieredcompiler_p.h"
+
+#include <private/qqmljsengine_p.h>
+#include <private/qqmljslexer_p.h>
+#include <private/qqmljsparser_p.h>
+#include <private/qqmljsast_p.h>
+#include <private/qqmlengine_p.h>
+#include <qv4jsir_p.h>
+#include <qv4codegen_p.h>
+#include <qv4isel_p.h>
+
+#if QT_CONFIG(qml_interpreter)
+#include <qv4isel_moth_p.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+using namespace QV4;
+
+// Installed as the code of an interpreted function once its unit has been compiled by the JIT.
+// The caller has set up the context for the interpreted unit, so switch it over to the tables
+// of the optimized unit before running the generated code.
+static ReturnedValue optimizedFunctionEntry(ExecutionEngine *engine, const uchar *codeData)
+{
+    const Function *optimized = reinterpret_cast<const Function *>(codeData);
+    Heap::ExecutionContext *context = engine->current;
+    context->compilationUnit = optimized->compilationUnit;
+    context->lookups = optimized->compilationUnit->runtimeLookups;
+    context->constantTable = optimized->compilationUnit->constants;
+    return optimized->code(engine, optimized->codeData);
+}
+
+TieredCompilationJob::TieredCompilationJob(TieredCompiler *compiler, const TieredCompilationSource &source, uint threshold)
+    : compiler(compiler)
+    , source(source)
+    , threshold(threshold)
+    , state(Idle)
+{
+    setAutoDelete(false);
+    QMutexLocker locker(&compiler->m_jobsMutex);
+    compiler->m_jobs.insert(this);
+}
+
+TieredCompilationJob::~TieredCompilationJob()
+{
+    if (compiler)
+        compiler->cancel(this);
+}
+
+void TieredCompilationJob::run()
+{
+    using namespace QQmlJS;
+
+    QQmlRefPointer<CompiledData::CompilationUnit> unit;
+    {
+        IR::Module module(/*debugMode*/false);
+
+        QQmlJS::Engine ee;
+        Lexer lexer(&ee);
+        lexer.setCode(source.sourceCode, source.line, source.parseAsBinding);
+        Parser parser(&ee);
+
+        AST::Program *program = parser.parseProgram() ? AST::cast<AST::Program *>(parser.rootNode()) : 0;
+        if (program) {
+            Codegen cg(source.strictMode);
+            cg.generateFromProgram(source.sourceFile, source.sourceCode, program, &module,
+                                   Codegen::EvalCode, source.inheritedLocals);
+            if (cg.qmlErrors().isEmpty()) {
+                ExecutionEngine *engine = compiler->m_engine;
+                Compiler::JSUnitGenerator jsGenerator(&module);
+                QScopedPointer<EvalInstructionSelection> isel(engine->iselFactory->create(QQmlEnginePrivate::get(engine), engine->executableAllocator, &module, &jsGenerator));
+                isel->setUseFastLookups(source.useFastLookups);
+                unit = isel->compile();
+            }
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    optimizedUnit = unit;
+    if (unit)
+        compiler->m_compiledUnitCount.ref();
+    state.storeRelease(unit ? Finished : Failed);
+    done.wakeAll();
+}
+
+void TieredCompilationJob::waitForDone()
+{
+    QMutexLocker locker(&mutex);
+    while (state.loadAcquire() == Compiling)
+        done.wait(&mutex);
+}
+
+TieredCompiler *TieredCompiler::create(ExecutionEngine *engine)
+{
+    // Calls and loop iterations before a unit is handed to the JIT. 0 disables the interpreter
+    // tier, so that everything is compiled by the JIT right away.
+#if QT_CONFIG(qml_interpreter) && defined(V4_ENABLE_JIT)
+    bool ok = false;
+    int threshold = qEnvironmentVariableIntValue("QV4_JIT_CALL_THRESHOLD", &ok);
+    if (!ok)
+        threshold = 1000;
+    if (threshold <= 0)
+        return 0;
+    return new TieredCompiler(engine, uint(threshold));
+#else
+    Q_UNUSED(engine);
+    return 0;
+#endif
+}
+
+TieredCompiler::TieredCompiler(ExecutionEngine *engine, uint threshold)
+    : m_engine(engine)
+#if QT_CONFIG(qml_interpreter)
+    , m_interpreterFactory(new Moth::ISelFactory)
+#endif
+    , m_threshold(threshold)
+    , m_compiledUnitCount(0)
+    , m_installedUnitCount(0)
+{
+    // Units are small enough that one thread keeps up, and the JIT doesn't compete with the
+    // application for more than one core.
+    m_threadPool.setMaxThreadCount(1);
+}
+
+TieredCompiler::~TieredCompiler()
+{
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+    QMutexLocker locker(&m_jobsMutex);
+    for (TieredCompilationJob *job : qAsConst(m_jobs))
+        job->compiler = 0;
+}
+
+void TieredCompiler::attach(CompiledData::CompilationUnit *unit, const TieredCompilationSource &source,
+                            CompilationStart start)
+{
+    Q_ASSERT(!unit->tieredCompilation);
+    if (start == CompileWhenHot) {
+        unit->tieredCompilation = new TieredCompilationJob(this, source, m_threshold);
+        return;
+    }
+
+    // The unit was just loaded, so compile it right away. Its functions pick up the generated
+    // code on the first call after it is done.
+    TieredCompilationJob *job = new TieredCompilationJob(this, source, /*threshold*/1);
+    unit->tieredCompilation = job;
+    job->state.storeRelease(TieredCompilationJob::Compiling);
+    m_threadPool.start(job);
+}
+
+void TieredCompiler::cancel(TieredCompilationJob *job)
+{
+    {
+        QMutexLocker locker(&m_jobsMutex);
+        m_jobs.remove(job);
+    }
+    if (!m_threadPool.tryTake(job))
+        job->waitForDone();
+    job->compiler = 0;
+}
+
+void TieredCompiler::waitForIdle()
+{
+    m_threadPool.waitForDone();
+}
+
+void TieredCompiler::functionIsHot(Function *function)
+{
+    CompiledData::CompilationUnit *unit = function->compilationUnit;
+    TieredCompilationJob *job = unit->tieredCompilation;
+    Q_ASSERT(job);
+
+    switch (job->state.loadAcquire()) {
+    case TieredCompilationJob::Idle:
+        job->state.storeRelease(TieredCompilationJob::Compiling);
+        m_threadPool.start(job);
+        break;
+    case TieredCompilationJob::Finished:
+        install(unit, job);
+        break;
+    default:
+        break;
+    }
+}
+
+// The optimized function runs with the call context and arguments set up for the interpreted
+// one, so everything that decides their layout has to be the same.
+static bool isCompatible(const CompiledData::Function *interpreted, const CompiledData::Function *compiled)
+{
+    const quint8 layoutFlags = CompiledData::Function::IsStrict | CompiledData::Function::HasDirectEval
+            | CompiledData::Function::UsesArgumentsObject | CompiledData::Function::IsNamedExpression
+            | CompiledData::Function::HasCatchOrWith;
+    return interpreted->nFormals == compiled->nFormals
+            && interpreted->nLocals == compiled->nLocals
+            && interpreted->nInnerFunctions == compiled->nInnerFunctions
+            && (interpreted->flags & layoutFlags) == (compiled->flags & layoutFlags)
+            && interpreted->location.line == compiled->location.line
+            && interpreted->location.column == compiled->location.column;
+}
+
+void TieredCompiler::install(CompiledData::CompilationUnit *unit, TieredCompilationJob *job)
+{
+    CompiledData::CompilationUnit *optimized = job->optimizedUnit.data();
+    optimized->linkToEngine(m_engine);
+
+    // Both units come from the same source, so their functions should line up. Don't rely on it.
+    const int functionCount = unit->runtimeFunctions.size();
+    bool matches = (optimized->runtimeFunctions.size() == functionCount);
+    for (int i = 0; matches && i < functionCount; ++i) {
+        matches = isCompatible(unit->runtimeFunctions.at(i)->compiledFunction,
+                               optimized->runtimeFunctions.at(i)->compiledFunction);
+    }
+    if (!matches) {
+        job->optimizedUnit = nullptr;
+        job->state.storeRelease(TieredCompilationJob::Failed);
+        return;
+    }
+
+    // The global code of a script runs only once, so leave it alone.
+    for (int i = 0; i < functionCount; ++i) {
+        if (uint(i) == unit->data->indexOfRootFunction)
+            continue;
+        Function *function = unit->runtimeFunctions.at(i);
+        function->code = &optimizedFunctionEntry;
+        function->codeData = reinterpret_cast<const uchar *>(optimized->runtimeFunctions.at(i));
+    }
+
+    job->state.storeRelease(TieredCompilationJob::Installed);
+    ++m_installedUnitCount;
+}
+
+QT_END_NAMESPACE
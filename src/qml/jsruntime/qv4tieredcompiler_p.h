@@ -0,0 +1,186 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QV4TIEREDCOMPILER_P_H
+#define QV4TIEREDCOMPILER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <private/qv4global_p.h>
+#include <private/qv4compileddata_p.h>
+#include <private/qv4context_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4function_p.h>
+#include <private/qqmlrefcount_p.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qset.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qwaitcondition.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QV4 {
+
+class EvalISelFactory;
+class TieredCompiler;
+
+// Everything needed to compile the source of a unit again, the same way it was compiled
+// for the interpreter.
+struct TieredCompilationSource
+{
+    QString sourceCode;
+    QString sourceFile;
+    QStringList inheritedLocals;
+    int line;
+    bool strictMode;
+    bool parseAsBinding;
+    bool useFastLookups;
+};
+
+// Attached to a compilation unit that was compiled for the interpreter. Compiles the unit again
+// with the JIT on a worker thread once one of its functions gets hot.
+class TieredCompilationJob : public QRunnable
+{
+public:
+    enum State {
+        Idle,
+        Compiling,
+        Finished,
+        Installed,
+        Failed
+    };
+
+    TieredCompilationJob(TieredCompiler *compiler, const TieredCompilationSource &source, uint threshold);
+    ~TieredCompilationJob();
+
+    void run() Q_DECL_OVERRIDE;
+    void waitForDone();
+
+    TieredCompiler *compiler;
+    const TieredCompilationSource source;
+    // Executions of a function before the unit is compiled, or the compiled code is installed.
+    const uint threshold;
+    QAtomicInt state;
+    QQmlRefPointer<CompiledData::CompilationUnit> optimizedUnit;
+
+private:
+    QMutex mutex;
+    QWaitCondition done;
+};
+
+class Q_QML_PRIVATE_EXPORT TieredCompiler
+{
+public:
+    enum CompilationStart {
+        CompileWhenHot,
+        CompileNow
+    };
+
+    // Returns 0 if the engine should compile everything with the JIT right away.
+    static TieredCompiler *create(ExecutionEngine *engine);
+    ~TieredCompiler();
+
+    EvalISelFactory *interpreterFactory() const { return m_interpreterFactory.data(); }
+    // Can be called from the type loader thread.
+    void attach(CompiledData::CompilationUnit *unit, const TieredCompilationSource &source,
+                CompilationStart start = CompileWhenHot);
+    void cancel(TieredCompilationJob *job);
+
+    // Called by the interpreter for every call and backward jump of a function whose unit
+    // can be handed to the JIT later.
+    static inline void countExecution(ExecutionEngine *engine, Function *function);
+    static inline Function *profiledFunction(Heap::ExecutionContext *context, const uchar *code);
+
+    void waitForIdle();
+
+    uint threshold() const { return m_threshold; }
+    int compiledUnitCount() const { return m_compiledUnitCount.load(); }
+    int installedUnitCount() const { return m_installedUnitCount; }
+
+private:
+    TieredCompiler(ExecutionEngine *engine, uint threshold);
+    void functionIsHot(Function *function);
+    void install(CompiledData::CompilationUnit *unit, TieredCompilationJob *job);
+
+    friend class TieredCompilationJob;
+
+    ExecutionEngine *m_engine;
+    QScopedPointer<EvalISelFactory> m_interpreterFactory;
+    QThreadPool m_threadPool;
+    QMutex m_jobsMutex;
+    QSet<TieredCompilationJob *> m_jobs;
+    uint m_threshold;
+    QAtomicInt m_compiledUnitCount;
+    int m_installedUnitCount;
+};
+
+inline Function *TieredCompiler::profiledFunction(Heap::ExecutionContext *context, const uchar *code)
+{
+    if (!context->compilationUnit || !context->compilationUnit->tieredCompilation)
+        return 0;
+    if (context->type < Heap::ExecutionContext::Type_SimpleCallContext)
+        return 0;
+    // eval code runs in the context of its caller, so make sure we really execute the function
+    Function *function = static_cast<Heap::SimpleCallContext *>(context)->v4Function;
+    return function && function->codeData == code ? function : 0;
+}
+
+inline void TieredCompiler::countExecution(ExecutionEngine *engine, Function *function)
+{
+    if (Q_UNLIKELY(++function->executionCount >= function->compilationUnit->tieredCompilation->threshold))
+        engine->tieredCompiler->functionIsHot(function);
+}
+
+} // namespace QV4
+
+QT_END_NAMESPACE
+
+#endif // QV4TIEREDCOMPILER_P_H
@@ -406,7 +406,13 @@ bool TypedArray::putIndexed(Managed *m, uint index, const Value &value)
     if (byteOffset + bytesPerElement > (uint)a->d()->buffer->byteLength())
         goto reject;
 
-    a->d()->type->write(scope.engine, a->d()->buffer->data->data(), byteOffset, value);
+    {
+        // converting the value can run code that shares the buffer again, so do it before detaching
+        ScopedValue number(scope, value.isNumber() ? value : Primitive::fromDouble(value.toNumber()));
+        if (scope.engine->hasException || !a->d()->buffer->detach())
+            return false;
+        a->d()->type->write(scope.engine, a->d()->buffer->data->data(), byteOffset, number);
+    }
     return true;
 
 reject:
@@ -503,15 +509,18 @@ void TypedArrayPrototype::method_set(const BuiltinFunction *, Scope &scope, Call
             RETURN_RESULT(scope.engine->throwRangeError(QStringLiteral("TypedArray.set: out of range")));
 
         uint idx = 0;
-        char *b = buffer->d()->data->data() + a->d()->byteOffset + offset*elementSize;
+        uint byteOffset = a->d()->byteOffset + offset*elementSize;
         ScopedValue val(scope);
         while (idx < l) {
             val = o->getIndexed(idx);
-            a->d()->type->write(scope.engine, b, 0, val);
-            if (scope.engine->hasException)
+            // reading and converting the value can run code that shares the buffer again
+            if (!scope.engine->hasException && !val->isNumber())
+                val = Primitive::fromDouble(val->toNumber());
+            if (scope.engine->hasException || !buffer->d()->detach())
                 RETURN_UNDEFINED();
+            a->d()->type->write(scope.engine, buffer->d()->data->data(), byteOffset, val);
             ++idx;
-            b += elementSize;
+            byteOffset += elementSize;
         }
         RETURN_UNDEFINED();
     }
@@ -525,6 +534,8 @@ void TypedArrayPrototype::method_set(const BuiltinFunction *, Scope &scope, Call
     if (offset + l > a->length())
         RETURN_RESULT(scope.engine->throwRangeError(QStringLiteral("TypedArray.set: out of range")));
 
+    if (!buffer->d()->detach())
+        RETURN_UNDEFINED();
     char *dest = buffer->d()->data->data() + a->d()->byteOffset + offset*elementSize;
     const char *src = srcBuffer->d()->data->data() + srcTypedArray->d()->byteOffset;
     if (srcTypedArray->d()->type == a->d()->type) {
@@ -114,8 +114,12 @@ double Value::toNumberImpl() const
 #ifdef V4_BOOTSTRAP
         Q_UNIMPLEMENTED();
 #else
-        if (String *s = stringValue())
+        if (String *s = stringValue()) {
+            // array index strings already know their value once they have been hashed
+            if (s->subtype() == Heap::String::StringType_ArrayIndex)
+                return s->d()->stringHash;
             return RuntimeHelpers::stringToNumber(s->toQString());
+        }
     {
         Q_ASSERT(isObject());
         Scope scope(objectValue()->engine());
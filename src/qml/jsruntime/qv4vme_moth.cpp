@@ -51,6 +51,7 @@
 #include <private/qv4scopedvalue_p.h>
 #include <private/qv4lookup_p.h>
 #include <private/qv4string_p.h>
+#include <private/qv4tieredcompiler_p.h>
 #include <iostream>
 
 #include "qv4alloca_p.h"
@@ -392,6 +393,10 @@ QV4::ReturnedValue VME::run(ExecutionEngine *engine, const uchar *code
     QV4::ExecutionContext *context = engine->currentContext;
     engine->current->lineNumber = -1;
 
+    QV4::Function *profiledFunction = QV4::TieredCompiler::profiledFunction(context->d(), code);
+    if (profiledFunction)
+        QV4::TieredCompiler::countExecution(engine, profiledFunction);
+
 #ifdef DO_TRACE_INSTR
     qDebug("Starting VME with context=%p and code=%p", context, code);
 #endif // DO_TRACE_INSTR
@@ -800,21 +805,29 @@ QV4::ReturnedValue VME::run(ExecutionEngine *engine, const uchar *code
     MOTH_END_INSTR(ConstructGlobalLookup)
 
     MOTH_BEGIN_INSTR(Jump)
+        if (instr.offset < 0 && profiledFunction)
+            QV4::TieredCompiler::countExecution(engine, profiledFunction);
         code = ((const uchar *)&instr.offset) + instr.offset;
     MOTH_END_INSTR(Jump)
 
     MOTH_BEGIN_INSTR(JumpEq)
         bool cond = VALUEPTR(instr.condition)->toBoolean();
         TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
-        if (cond)
+        if (cond) {
+            if (instr.offset < 0 && profiledFunction)
+                QV4::TieredCompiler::countExecution(engine, profiledFunction);
             code = ((const uchar *)&instr.offset) + instr.offset;
+        }
     MOTH_END_INSTR(JumpEq)
 
     MOTH_BEGIN_INSTR(JumpNe)
         bool cond = VALUEPTR(instr.condition)->toBoolean();
         TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
-        if (!cond)
+        if (!cond) {
+            if (instr.offset < 0 && profiledFunction)
+                QV4::TieredCompiler::countExecution(engine, profiledFunction);
             code = ((const uchar *)&instr.offset) + instr.offset;
+        }
     MOTH_END_INSTR(JumpNe)
 
     MOTH_BEGIN_INSTR(UNot)
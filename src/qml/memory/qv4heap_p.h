@@ -98,6 +98,7 @@ struct Q_QML_EXPORT Base {
 
     inline ReturnedValue asReturnedValue() const;
     inline void mark(QV4::ExecutionEngine *engine);
+    void markInParallel();
 
     void setVtable(const VTable *v) { vt = v; }
     const VTable *vtable() const { return vt; }
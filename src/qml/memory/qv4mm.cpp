@@ -53,6 +53,11 @@
 #include <QElapsedTimer>
 #include <QMap>
 #include <QScopedValueRollback>
+#include <QMutex>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
 
 #include <iostream>
 #include <cstdlib>
@@ -60,6 +65,8 @@
 #include "qv4alloca_p.h"
 #include "qv4profiling_p.h"
 
+#include <atomic>
+
 //#define MM_STATS
 
 #if !defined(MM_STATS) && !defined(QT_NO_DEBUG)
@@ -98,8 +105,7 @@ QT_BEGIN_NAMESPACE
 namespace QV4 {
 
 enum {
-    MinSlotsGCLimit = QV4::Chunk::AvailableSlots*16,
-    GCOverallocation = 200 /* Max overallocation by the GC in % */
+    NurseryPromotionThreshold = 50 /* Usage in % from which on a nursery chunk moves to the old generation */
 };
 
 struct MemorySegment {
@@ -215,6 +221,20 @@ struct ChunkAllocator {
 
     Chunk *allocate(size_t size = 0);
     void free(Chunk *chunk, size_t size = 0);
+    // for pages inside an allocated chunk
+    void commit(void *start, size_t size) { segmentFor(start)->pageReservation.commit(start, size); }
+    void decommit(void *start, size_t size) { segmentFor(start)->pageReservation.decommit(start, size); }
+
+    MemorySegment *segmentFor(void *address)
+    {
+        Chunk *c = reinterpret_cast<Chunk *>(reinterpret_cast<quintptr>(address) & ~(quintptr(Chunk::ChunkSize) - 1));
+        for (auto &m : memorySegments) {
+            if (m.contains(c))
+                return &m;
+        }
+        Q_UNREACHABLE();
+        return nullptr;
+    }
 
     std::vector<MemorySegment> memorySegments;
 };
@@ -286,13 +306,34 @@ void Chunk::sweep()
             }
         }
         objectBitmap[i] = blackBitmap[i];
-        grayBitmap[i] = 0;
         extendsBitmap[i] = e;
         o += Chunk::Bits;
     }
     //    DEBUG << "swept chunk" << this << "freed" << slotsFreed << "slots.";
 }
 
+uint Chunk::nUsedSlotsAfterSweep() const
+{
+    // same bit trickery as in sweep(), without touching the objects
+    uint usedSlots = 0;
+    for (uint i = 0; i < Chunk::EntriesInBitmap; ++i) {
+        quintptr toFree = objectBitmap[i] ^ blackBitmap[i];
+        quintptr e = extendsBitmap[i];
+        while (toFree) {
+            uint index = qCountTrailingZeroBits(toFree);
+            quintptr bit = (static_cast<quintptr>(1) << index);
+            toFree ^= bit;
+
+            quintptr mask = (bit << 1) - 1;
+            quintptr result = (e | mask) + 1;
+            result |= mask;
+            e &= result;
+        }
+        usedSlots += qPopulationCount(blackBitmap[i] | e);
+    }
+    return usedSlots;
+}
+
 void Chunk::freeAll()
 {
     //    DEBUG << "sweeping chunk" << this << (*freeList);
@@ -337,6 +378,11 @@ void Chunk::resetBlackBits()
     memset(blackBitmap, 0, sizeof(blackBitmap));
 }
 
+void Chunk::resetGrayBits()
+{
+    memset(grayBitmap, 0, sizeof(grayBitmap));
+}
+
 #ifdef MM_STATS
 static uint nGrayItems = 0;
 #endif
@@ -494,6 +540,7 @@ HeapItem *BlockAllocator::allocate(size_t size, bool forceAllocation) {
 
     HeapItem *m;
 
+retry:
     if (slotsRequired < NumBins - 1) {
         m = freeBins[slotsRequired];
         if (m) {
@@ -563,8 +610,12 @@ HeapItem *BlockAllocator::allocate(size_t size, bool forceAllocation) {
     }
 
     if (!m) {
+        if (sweepNextChunk())
+            goto retry;
         if (!forceAllocation)
             return 0;
+        if (reuseSparseChunk())
+            goto retry;
         Chunk *newChunk = chunkAllocator->allocate();
         chunks.push_back(newChunk);
         nextFree = newChunk->first();
@@ -580,24 +631,195 @@ done:
     return m;
 }
 
-void BlockAllocator::sweep()
+void BlockAllocator::sweep(bool lazy)
 {
+    // anything left over from the previous collection
+    finishSweep();
+
     nextFree = 0;
     nFree = 0;
     memset(freeBins, 0, sizeof(freeBins));
 
 //    qDebug() << "BlockAlloc: sweep";
     usedSlotsAfterLastSweep = 0;
+    if (lazy) {
+        // Only the accounting is done here, the objects get destroyed and their slots
+        // sorted into the free bins by sweepNextChunk() once we need them.
+        for (auto c : chunks) {
+            c->resetGrayBits();
+            usedSlotsAfterLastSweep += c->nUsedSlotsAfterSweep();
+        }
+        sweepIndex = 0;
+        sweepEnd = chunks.size();
+        resetBlackBitsAfterSweep = false;
+        return;
+    }
+
     for (auto c : chunks) {
+        c->resetGrayBits();
         c->sweep();
-        c->sortIntoBins(freeBins, NumBins);
+        if (sparseChunks.empty() || !isSparse(c))
+            c->sortIntoBins(freeBins, NumBins);
 //        qDebug() << "used slots in chunk" << c << ":" << c->nUsedSlots();
         usedSlotsAfterLastSweep += c->nUsedSlots();
     }
 }
 
+bool BlockAllocator::sweepNextChunk()
+{
+    if (sweepIndex >= sweepEnd)
+        return false;
+
+    Chunk *c = chunks.at(sweepIndex);
+    ++sweepIndex;
+    // Gray bits set since the collection belong to live objects and must survive for
+    // the next incremental GC.
+    c->sweep();
+    if (resetBlackBitsAfterSweep)
+        c->resetBlackBits();
+    if (sparseChunks.empty() || !isSparse(c))
+        c->sortIntoBins(freeBins, NumBins);
+    return true;
+}
+
+// Bit n is set if the n-th page of the chunk contains no objects. The first page holds the
+// chunk header, and is never reported as free.
+static quint32 freePagesInChunk(const Chunk *c)
+{
+    const size_t pageSize = WTF::pageSize();
+    const uint nPages = Chunk::ChunkSize/pageSize;
+    const uint entriesPerPage = pageSize/(Chunk::SlotSize*Chunk::Bits);
+    if (nPages < 2 || nPages > 32 || !entriesPerPage)
+        return 0;
+
+    quint32 freePages = 0;
+    for (uint p = 1; p < nPages; ++p) {
+        quintptr used = 0;
+        for (uint i = p*entriesPerPage; i < (p + 1)*entriesPerPage; ++i)
+            used |= c->objectBitmap[i] | c->extendsBitmap[i];
+        if (!used)
+            freePages |= quint32(1) << p;
+    }
+    return freePages;
+}
+
+static void recommitPages(ChunkAllocator *chunkAllocator, const BlockAllocator::SparseChunk &s)
+{
+    const size_t pageSize = WTF::pageSize();
+    quint32 pages = s.decommittedPages;
+    while (pages) {
+        const uint p = qCountTrailingZeroBits(pages);
+        pages &= pages - 1;
+        chunkAllocator->commit(reinterpret_cast<char *>(s.chunk) + p*pageSize, pageSize);
+    }
+}
+
+static bool sparseChunkLessThan(const BlockAllocator::SparseChunk &s, const Chunk *c)
+{
+    return s.chunk < c;
+}
+
+bool BlockAllocator::isSparse(Chunk *c) const
+{
+    auto it = std::lower_bound(sparseChunks.begin(), sparseChunks.end(), c, sparseChunkLessThan);
+    return it != sparseChunks.end() && it->chunk == c;
+}
+
+size_t BlockAllocator::decommittedMem() const
+{
+    size_t pages = 0;
+    for (const SparseChunk &s : sparseChunks)
+        pages += qPopulationCount(s.decommittedPages);
+    return pages*WTF::pageSize();
+}
+
+size_t BlockAllocator::sparseChunksFreeMem() const
+{
+    size_t mem = 0;
+    for (const SparseChunk &s : sparseChunks)
+        mem += s.chunk->nFreeSlots()*Chunk::SlotSize - qPopulationCount(s.decommittedPages)*WTF::pageSize();
+    return mem;
+}
+
+size_t BlockAllocator::releaseFreeMemory()
+{
+    finishSweep();
+
+    const size_t pageSize = WTF::pageSize();
+    const size_t memBefore = allocatedMem();
+    std::vector<Chunk *> remainingChunks;
+    remainingChunks.reserve(chunks.size());
+    std::vector<SparseChunk> newSparseChunks;
+
+    for (Chunk *c : chunks) {
+        SparseChunk s = { c, 0 };
+        auto it = std::lower_bound(sparseChunks.begin(), sparseChunks.end(), c, sparseChunkLessThan);
+        if (it != sparseChunks.end() && it->chunk == c)
+            s = *it;
+
+        const uint usedSlots = c->nUsedSlots();
+        if (!usedSlots) {
+            recommitPages(chunkAllocator, s);
+            chunkAllocator->free(c);
+            continue;
+        }
+        remainingChunks.push_back(c);
+
+        if (usedSlots*100 >= Chunk::AvailableSlots*SparseChunkThreshold) {
+            recommitPages(chunkAllocator, s);
+            continue;
+        }
+
+        quint32 toDecommit = freePagesInChunk(c) & ~s.decommittedPages;
+        s.decommittedPages |= toDecommit;
+        while (toDecommit) {
+            const uint p = qCountTrailingZeroBits(toDecommit);
+            toDecommit &= toDecommit - 1;
+            chunkAllocator->decommit(reinterpret_cast<char *>(c) + p*pageSize, pageSize);
+        }
+        newSparseChunks.push_back(s);
+    }
+
+    std::sort(newSparseChunks.begin(), newSparseChunks.end(),
+              [](const SparseChunk &a, const SparseChunk &b) { return a.chunk < b.chunk; });
+    chunks.swap(remainingChunks);
+    sparseChunks.swap(newSparseChunks);
+
+    // rebuild the free bins without the sparse chunks
+    nextFree = 0;
+    nFree = 0;
+    memset(freeBins, 0, sizeof(freeBins));
+    for (Chunk *c : chunks) {
+        if (!isSparse(c))
+            c->sortIntoBins(freeBins, NumBins);
+    }
+
+    return memBefore - allocatedMem();
+}
+
+bool BlockAllocator::reuseSparseChunk()
+{
+    if (sparseChunks.empty())
+        return false;
+    Q_ASSERT(!hasPendingSweep());
+
+    // take the fullest one, and leave the others a chance to run empty
+    auto it = std::max_element(sparseChunks.begin(), sparseChunks.end(),
+                               [](const SparseChunk &a, const SparseChunk &b) {
+        return a.chunk->nUsedSlots() < b.chunk->nUsedSlots();
+    });
+    SparseChunk s = *it;
+    sparseChunks.erase(it);
+    recommitPages(chunkAllocator, s);
+    s.chunk->sortIntoBins(freeBins, NumBins);
+    return true;
+}
+
 void BlockAllocator::freeAll()
 {
+    for (const SparseChunk &s : sparseChunks)
+        recommitPages(chunkAllocator, s);
+    sparseChunks.clear();
     for (auto c : chunks) {
         c->freeAll();
         chunkAllocator->free(c);
@@ -606,12 +828,18 @@ void BlockAllocator::freeAll()
 
 void BlockAllocator::resetBlackBits()
 {
-    for (auto c : chunks)
-        c->resetBlackBits();
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        // chunks that still need sweeping use their black bits to find the live objects
+        if (!isPendingSweep(i))
+            chunks.at(i)->resetBlackBits();
+    }
+    if (hasPendingSweep())
+        resetBlackBitsAfterSweep = true;
 }
 
 void BlockAllocator::collectGrayItems(ExecutionEngine *engine)
 {
+    Q_ASSERT(!hasPendingSweep());
     for (auto c : chunks)
         c->collectGrayItems(engine);
 
@@ -686,14 +914,18 @@ void HugeItemAllocator::resetBlackBits()
 
 void HugeItemAllocator::collectGrayItems(ExecutionEngine *engine)
 {
-    for (auto c : chunks)
+    for (auto c : chunks) {
+        const size_t index = c.chunk->first() - c.chunk->realBase();
         // Correct for a Steele type barrier
-        if (Chunk::testBit(c.chunk->blackBitmap, c.chunk->first() - c.chunk->realBase()) &&
-            Chunk::testBit(c.chunk->grayBitmap, c.chunk->first() - c.chunk->realBase())) {
+        if (Chunk::testBit(c.chunk->blackBitmap, index) &&
+            Chunk::testBit(c.chunk->grayBitmap, index)) {
             HeapItem *i = c.chunk->first();
             Heap::Base *b = *i;
-            b->mark(engine);
+            // the item is already black, so mark() would not push it again
+            engine->pushForGC(b);
         }
+        Chunk::clearBit(c.chunk->grayBitmap, index);
+    }
 }
 
 void HugeItemAllocator::freeAll()
@@ -703,19 +935,107 @@ void HugeItemAllocator::freeAll()
     }
 }
 
+HeapItem *TemporaryArena::allocate(size_t size)
+{
+    Q_ASSERT(size % Chunk::SlotSize == 0);
+    Q_ASSERT(size <= Chunk::DataSize);
+    const size_t slotsRequired = size >> Chunk::SlotSizeShift;
+    if (Q_UNLIKELY(size_t(end - nextFree) < slotsRequired)) {
+        if (nextFree)
+            ++currentChunk;
+        if (currentChunk == chunks.size())
+            chunks.push_back(chunkAllocator->allocate());
+        Chunk *c = chunks.at(currentChunk);
+        nextFree = c->first();
+        end = c->realBase() + Chunk::NumSlots;
+    }
+    HeapItem *m = nextFree;
+    nextFree += slotsRequired;
+    memset(m, 0, size);
+    Chunk *c = m->chunk();
+    Chunk::setBit(c->objectBitmap, m - c->realBase());
+    items.push_back(*m);
+    return m;
+}
+
+void TemporaryArena::release(const Position &position)
+{
+    for (size_t i = position.nItems; i < items.size(); ++i) {
+        Heap::Base *b = items.at(i);
+        if (b->vtable()->destroy) {
+            b->vtable()->destroy(b);
+            b->_checkIsDestroyed();
+        }
+        HeapItem *h = reinterpret_cast<HeapItem *>(b);
+        Chunk *c = h->chunk();
+        Chunk::clearBit(c->objectBitmap, h - c->realBase());
+        Chunk::clearBit(c->blackBitmap, h - c->realBase());
+    }
+    items.resize(position.nItems);
+    currentChunk = position.chunk;
+    nextFree = position.nextFree;
+    end = nextFree ? chunks.at(currentChunk)->realBase() + Chunk::NumSlots : 0;
+}
+
+bool TemporaryArena::contains(const Heap::Base *b) const
+{
+    if (items.empty())
+        return false;
+    const Chunk *chunk = reinterpret_cast<const HeapItem *>(b)->chunk();
+    for (size_t i = 0; i <= currentChunk; ++i) {
+        if (chunks.at(i) == chunk)
+            return true;
+    }
+    return false;
+}
+
+void TemporaryArena::resetBlackBits()
+{
+    for (size_t i = 0; i < chunks.size() && i <= currentChunk; ++i)
+        chunks.at(i)->resetBlackBits();
+}
+
+void TemporaryArena::freeAll()
+{
+    release(Position());
+    for (auto c : chunks)
+        chunkAllocator->free(c);
+    chunks.clear();
+}
+
 
 MemoryManager::MemoryManager(ExecutionEngine *engine)
     : engine(engine)
     , chunkAllocator(new ChunkAllocator)
     , stackAllocator(chunkAllocator)
     , blockAllocator(chunkAllocator)
+    , nursery(chunkAllocator)
     , hugeItemAllocator(chunkAllocator)
+    , temporaryArena(chunkAllocator)
     , m_persistentValues(new PersistentValueStorage(engine))
     , m_weakValues(new PersistentValueStorage(engine))
     , unmanagedHeapSizeGCLimit(MIN_UNMANAGED_HEAPSIZE_GC_LIMIT)
     , aggressiveGC(!qEnvironmentVariableIsEmpty("QV4_MM_AGGRESSIVE_GC"))
     , gcStats(!qEnvironmentVariableIsEmpty(QV4_MM_STATS))
 {
+    bool ok = false;
+#if WRITEBARRIER(steele)
+    const int sliceBudget = qEnvironmentVariableIntValue(QV4_MM_INCREMENTAL_GC_SLICE, &ok);
+    if (ok && sliceBudget > 0)
+        incrementalSliceBudget = sliceBudget;
+    const int nurseryKB = qEnvironmentVariableIntValue(QV4_MM_NURSERY_SIZE, &ok);
+    if (ok && nurseryKB > 0)
+        setNurserySize(size_t(nurseryKB)*1024);
+#endif
+    const int fragmentationLimit = qEnvironmentVariableIntValue(QV4_MM_FRAGMENTATION_LIMIT, &ok);
+    if (ok && fragmentationLimit > 0)
+        setFragmentationLimit(fragmentationLimit/qreal(100));
+    const int maxHeapKB = qEnvironmentVariableIntValue(QV4_MM_MAX_HEAP_SIZE, &ok);
+    if (ok && maxHeapKB > 0)
+        pacingPolicy.maxHeapSize = size_t(maxHeapKB)*1024;
+    const int markThreads = qEnvironmentVariableIntValue(QV4_MM_MARK_THREADS, &ok);
+    if (ok)
+        setMarkingThreadCount(markThreads);
 #ifdef V4_USE_VALGRIND
     VALGRIND_CREATE_MEMPOOL(this, 0, true);
 #endif
@@ -736,33 +1056,37 @@ Heap::Base *MemoryManager::allocString(std::size_t unmanagedSize)
 
     bool didGCRun = false;
     if (aggressiveGC) {
-        runGC();
+        runGC(/*forceFullCollection*/ false, GCReasonAggressive);
+        didGCRun = true;
+    } else if (Q_UNLIKELY(gcState == GCMarking)
+               && ++allocationsSinceLastSlice >= IncrementalMarkAllocationInterval) {
+        triggerGC(gcReason);
         didGCRun = true;
     }
 
     unmanagedHeapSize += unmanagedSize;
     if (unmanagedHeapSize > unmanagedHeapSizeGCLimit) {
         if (!didGCRun)
-            runGC();
-
-        if (3*unmanagedHeapSizeGCLimit <= 4*unmanagedHeapSize)
-            // more than 75% full, raise limit
-            unmanagedHeapSizeGCLimit = std::max(unmanagedHeapSizeGCLimit, unmanagedHeapSize) * 2;
-        else if (unmanagedHeapSize * 4 <= unmanagedHeapSizeGCLimit)
-            // less than 25% full, lower limit
-            unmanagedHeapSizeGCLimit = qMax(MIN_UNMANAGED_HEAPSIZE_GC_LIMIT, unmanagedHeapSizeGCLimit/2);
+            triggerGC(GCReasonUnmanagedMemory);
+
+        // only adapt the limit once a cycle has actually freed something
+        if (gcState == GCIdle) {
+            if (3*unmanagedHeapSizeGCLimit <= 4*unmanagedHeapSize)
+                // more than 75% full, raise limit
+                unmanagedHeapSizeGCLimit = std::max(unmanagedHeapSizeGCLimit, unmanagedHeapSize) * 2;
+            else if (unmanagedHeapSize * 4 <= unmanagedHeapSizeGCLimit)
+                // less than 25% full, lower limit
+                unmanagedHeapSizeGCLimit = qMax(MIN_UNMANAGED_HEAPSIZE_GC_LIMIT, unmanagedHeapSizeGCLimit/2);
+        }
         didGCRun = true;
     }
 
-    HeapItem *m = blockAllocator.allocate(stringSize);
-    if (!m) {
-        if (!didGCRun && shouldRunGC())
-            runGC();
-        m = blockAllocator.allocate(stringSize, true);
-    }
+    HeapItem *m = allocateSlots(stringSize, didGCRun);
 
 //    qDebug() << "allocated string" << m;
     memset(m, 0, stringSize);
+    if (Q_UNLIKELY(gcState == GCMarking))
+        allocatedDuringMarking(m);
     return *m;
 }
 
@@ -775,7 +1099,11 @@ Heap::Base *MemoryManager::allocData(std::size_t size)
 
     bool didRunGC = false;
     if (aggressiveGC) {
-        runGC();
+        runGC(/*forceFullCollection*/ false, GCReasonAggressive);
+        didRunGC = true;
+    } else if (Q_UNLIKELY(gcState == GCMarking)
+               && ++allocationsSinceLastSlice >= IncrementalMarkAllocationInterval) {
+        triggerGC(gcReason);
         didRunGC = true;
     }
 #ifdef DETAILED_MM_STATS
@@ -788,21 +1116,138 @@ Heap::Base *MemoryManager::allocData(std::size_t size)
 //    qDebug() << "unmanagedHeapSize:" << unmanagedHeapSize << "limit:" << unmanagedHeapSizeGCLimit << "unmanagedSize:" << unmanagedSize;
 
     if (size > Chunk::DataSize) {
+        if (!didRunGC && heapLimitReached(size))
+            triggerGC(GCReasonHeapLimit);
         HeapItem *h = hugeItemAllocator.allocate(size);
 //        qDebug() << "allocating huge item" << h;
+        if (Q_UNLIKELY(gcState == GCMarking))
+            allocatedDuringMarking(h);
         return *h;
     }
 
+    HeapItem *m = allocateSlots(size, didRunGC);
+
+    memset(m, 0, size);
+    if (Q_UNLIKELY(gcState == GCMarking))
+        allocatedDuringMarking(m);
+//    qDebug() << "allocating data" << m;
+    return *m;
+}
+
+HeapItem *MemoryManager::allocateSlots(std::size_t size, bool didRunGC)
+{
+    if (useNursery()) {
+        HeapItem *m = nursery.allocate(size);
+        if (m)
+            return m;
+        if (nursery.chunks.size() < nurseryChunkLimit)
+            return nursery.allocate(size, true);
+
+        // the nursery is full, time for a minor collection
+        if (!didRunGC)
+            triggerGC(GCReasonNurseryFull);
+        didRunGC = true;
+        if (useNursery())
+            return nursery.allocate(size, true);
+    }
+
+    oldGenerationAllocatedSinceSweep = true;
     HeapItem *m = blockAllocator.allocate(size);
     if (!m) {
-        if (!didRunGC && shouldRunGC())
-            runGC();
+        if (!didRunGC) {
+            if (heapLimitReached(Chunk::ChunkSize))
+                triggerGC(GCReasonHeapLimit);
+            else if (shouldRunGC())
+                triggerGC(GCReasonHeapGrowth);
+        }
         m = blockAllocator.allocate(size, true);
     }
+    return m;
+}
 
-    memset(m, 0, size);
-//    qDebug() << "allocating data" << m;
-    return *m;
+MemoryManager::TemporaryScope::TemporaryScope(MemoryManager *mm)
+    : mm(mm)
+{
+    // Scopes that ended during incremental marking leave their items behind
+    if (!mm->temporaryScopeDepth && mm->gcState == GCIdle)
+        mm->temporaryArena.release(TemporaryArena::Position());
+    position = mm->temporaryArena.position();
+    ++mm->temporaryScopeDepth;
+}
+
+MemoryManager::TemporaryScope::~TemporaryScope()
+{
+    Q_ASSERT(mm->temporaryScopeDepth);
+    --mm->temporaryScopeDepth;
+    // The mark stack may still point into the arena until the collection is done
+    if (mm->gcState == GCIdle)
+        mm->temporaryArena.release(position);
+}
+
+MemoryManager::TemporaryAllocations::TemporaryAllocations(MemoryManager *mm, Function *function,
+                                                          Heap::ExecutionContext *outer)
+    : mm(mm)
+    , function(mm->temporaryFunction)
+    , outer(mm->temporaryOuter)
+    , callDepth(mm->temporaryCallDepth)
+{
+    Q_ASSERT(!function || mm->temporaryScopeDepth);
+    mm->temporaryFunction = function;
+    mm->temporaryOuter = outer;
+    mm->temporaryCallDepth = mm->engine->callDepth;
+}
+
+MemoryManager::TemporaryAllocations::~TemporaryAllocations()
+{
+    mm->temporaryFunction = function;
+    mm->temporaryOuter = outer;
+    mm->temporaryCallDepth = callDepth;
+}
+
+bool MemoryManager::allocatesTemporaries() const
+{
+    if (Q_LIKELY(!temporaryFunction))
+        return false;
+    // Only the code of the function itself is known not to leak its strings. Getters or
+    // bindings that run in between have contexts of their own, or a higher call depth.
+    const Heap::ExecutionContext *ctx = engine->current;
+    if (engine->callDepth != temporaryCallDepth || ctx->outer != temporaryOuter)
+        return false;
+    if (ctx->type != Heap::ExecutionContext::Type_SimpleCallContext
+            && ctx->type != Heap::ExecutionContext::Type_CallContext)
+        return false;
+    return static_cast<const Heap::SimpleCallContext *>(ctx)->v4Function == temporaryFunction;
+}
+
+Heap::String *MemoryManager::allocTemporaryString(const QString &text)
+{
+    if (!allocatesTemporaries())
+        return engine->newString(text);
+
+    unmanagedHeapSize += text.length()*sizeof(QChar);
+    Heap::String *s = reinterpret_cast<Heap::String *>(temporaryArena.allocate(align(sizeof(Heap::String))));
+    s->setVtable(String::staticVTable());
+    s->init(this, text);
+    return s;
+}
+
+Heap::String *MemoryManager::allocTemporaryString(Heap::String *left, Heap::String *right)
+{
+    if (!allocatesTemporaries())
+        return alloc<String>(this, left, right);
+
+    Heap::String *s = reinterpret_cast<Heap::String *>(temporaryArena.allocate(align(sizeof(Heap::String))));
+    s->setVtable(String::staticVTable());
+    s->init(this, left, right);
+    return s;
+}
+
+ReturnedValue MemoryManager::escapeTemporary(const Value &value)
+{
+    const String *s = value.stringValue();
+    if (Q_LIKELY(!s) || !temporaryArena.contains(s->d()))
+        return value.asReturnedValue();
+    return engine->newString(s->toQString())->asReturnedValue();
 }
 
 Heap::Object *MemoryManager::allocObjectWithMemberData(std::size_t size, uint nMembers)
@@ -817,7 +1262,10 @@ Heap::Object *MemoryManager::allocObjectWithMemberData(std::size_t size, uint nM
         Heap::MemberData *m;
         if (totalSize > Chunk::DataSize) {
             o = static_cast<Heap::Object *>(allocData(size));
-            m = hugeItemAllocator.allocate(memberSize)->as<Heap::MemberData>();
+            HeapItem *mh = hugeItemAllocator.allocate(memberSize);
+            if (Q_UNLIKELY(gcState == GCMarking))
+                allocatedDuringMarking(mh);
+            m = mh->as<Heap::MemberData>();
         } else {
             HeapItem *mh = reinterpret_cast<HeapItem *>(allocData(totalSize));
             Heap::Base *b = *mh;
@@ -828,6 +1276,8 @@ Heap::Object *MemoryManager::allocObjectWithMemberData(std::size_t size, uint nM
             size_t index = mh - c->realBase();
             Chunk::setBit(c->objectBitmap, index);
             Chunk::clearBit(c->extendsBitmap, index);
+            if (Q_UNLIKELY(gcState == GCMarking))
+                allocatedDuringMarking(mh);
         }
         o->memberData.set(engine, m);
         m->setVtable(MemberData::staticVTable());
@@ -842,63 +1292,277 @@ Heap::Object *MemoryManager::allocObjectWithMemberData(std::size_t size, uint nM
 
 static uint markStackSize = 0;
 
+static inline void markChildren(ExecutionEngine *engine, Heap::Base *h)
+{
+    Q_ASSERT(h); // at this point we should only have Heap::Base objects in this area on the stack. If not, weird things might happen.
+    if (h->vtable()->markObjects)
+        h->vtable()->markObjects(h, engine);
+    if (quint64 m = h->vtable()->markTable) {
+//        qDebug() << "using mark table:" << hex << m << "for" << h;
+        void **mem = reinterpret_cast<void **>(h);
+        while (m) {
+            MarkFlags mark = static_cast<MarkFlags>(m & 3);
+            switch (mark) {
+            case Mark_NoMark:
+                break;
+            case Mark_Value:
+//                qDebug() << "marking value at " << mem;
+                reinterpret_cast<Value *>(mem)->mark(engine);
+                break;
+            case Mark_Pointer: {
+//                qDebug() << "marking pointer at " << mem;
+                Heap::Base *p = *reinterpret_cast<Heap::Base **>(mem);
+                if (p)
+                    p->mark(engine);
+                break;
+            }
+            case Mark_ValueArray: {
+                Q_ASSERT(m == Mark_ValueArray);
+//                qDebug() << "marking Value Array at offset" << hex << (mem - reinterpret_cast<void **>(h));
+                ValueArray<0> *a = reinterpret_cast<ValueArray<0> *>(mem);
+                Value *v = a->values;
+                const Value *end = v + a->alloc;
+                while (v < end) {
+                    v->mark(engine);
+                    ++v;
+                }
+                break;
+            }
+            }
+
+            m >>= 2;
+            ++mem;
+        }
+    }
+}
+
 void MemoryManager::drainMarkStack(Value *markBase)
 {
     while (engine->jsStackTop > markBase) {
         Heap::Base *h = engine->popForGC();
         ++markStackSize;
-        Q_ASSERT(h); // at this point we should only have Heap::Base objects in this area on the stack. If not, weird things might happen.
-        if (h->vtable()->markObjects)
-            h->vtable()->markObjects(h, engine);
-        if (quint64 m = h->vtable()->markTable) {
-//            qDebug() << "using mark table:" << hex << m << "for" << h;
-            void **mem = reinterpret_cast<void **>(h);
-            while (m) {
-                MarkFlags mark = static_cast<MarkFlags>(m & 3);
-                switch (mark) {
-                case Mark_NoMark:
-                    break;
-                case Mark_Value:
-//                    qDebug() << "marking value at " << mem;
-                    reinterpret_cast<Value *>(mem)->mark(engine);
-                    break;
-                case Mark_Pointer: {
-//                    qDebug() << "marking pointer at " << mem;
-                    Heap::Base *p = *reinterpret_cast<Heap::Base **>(mem);
-                    if (p)
-                        p->mark(engine);
-                    break;
-                }
-                case Mark_ValueArray: {
-                    Q_ASSERT(m == Mark_ValueArray);
-//                    qDebug() << "marking Value Array at offset" << hex << (mem - reinterpret_cast<void **>(h));
-                    ValueArray<0> *a = reinterpret_cast<ValueArray<0> *>(mem);
-                    Value *v = a->values;
-                    const Value *end = v + a->alloc;
-                    while (v < end) {
-                        v->mark(engine);
-                        ++v;
-                    }
-                    break;
-                }
-                }
+        markChildren(engine, h);
+    }
+}
 
-                m >>= 2;
-                ++mem;
-            }
+bool MemoryManager::drainMarkStack(Value *markBase, const QElapsedTimer &timer, qint64 budget)
+{
+    uint n = 0;
+    while (engine->jsStackTop > markBase) {
+        if (!(++n % IncrementalMarkTimeCheckInterval) && timer.nsecsElapsed() > budget)
+            return false;
+        Heap::Base *h = engine->popForGC();
+        ++markStackSize;
+        markChildren(engine, h);
+    }
+    return true;
+}
+
+#if !defined(QT_NO_THREAD) && defined(Q_COMPILER_THREAD_LOCAL)
+#define V4_PARALLEL_MARKING
+#endif
+
+#ifdef V4_PARALLEL_MARKING
+namespace {
+
+struct MarkWorker
+{
+    std::vector<Heap::Base *> stack;
+    // the part of the work other threads may steal, guarded by sharedLock
+    QMutex sharedLock;
+    std::vector<Heap::Base *> shared;
+    QAtomicInt sharedSize;
+    uint markedObjects = 0;
+};
+
+static thread_local MarkWorker *currentMarkWorker = nullptr;
+
+class ParallelMarker
+{
+public:
+    enum { PublishThreshold = 64 };
+
+    ParallelMarker(ExecutionEngine *engine, int nWorkers)
+        : engine(engine)
+        , workers(new MarkWorker[nWorkers])
+        , nWorkers(nWorkers)
+    {}
+
+    void seed(int index, Heap::Base *h) { workers[index].stack.push_back(h); }
+    void run(int index);
+    uint markedObjects() const;
+
+private:
+    void publish(MarkWorker *w);
+    bool steal(MarkWorker *thief, MarkWorker *victim);
+    bool findWork(MarkWorker *w);
+
+    ExecutionEngine *engine;
+    QScopedArrayPointer<MarkWorker> workers;
+    const int nWorkers;
+    QAtomicInt idleWorkers;
+};
+
+class MarkTask : public QRunnable
+{
+public:
+    MarkTask(ParallelMarker *marker, int index) : marker(marker), index(index) {}
+    void run() override { marker->run(index); }
+
+private:
+    ParallelMarker *marker;
+    int index;
+};
+
+void ParallelMarker::run(int index)
+{
+    MarkWorker *w = workers.data() + index;
+    currentMarkWorker = w;
+    do {
+        while (!w->stack.empty()) {
+            Heap::Base *h = w->stack.back();
+            w->stack.pop_back();
+            ++w->markedObjects;
+            markChildren(engine, h);
+            if (w->stack.size() > PublishThreshold && !w->sharedSize.load())
+                publish(w);
+        }
+    } while (steal(w, w) || findWork(w));
+    currentMarkWorker = nullptr;
+}
+
+uint ParallelMarker::markedObjects() const
+{
+    uint n = 0;
+    for (int i = 0; i < nWorkers; ++i)
+        n += workers[i].markedObjects;
+    return n;
+}
+
+void ParallelMarker::publish(MarkWorker *w)
+{
+    // The bottom of the stack is closest to the roots, and thus most likely to lead to
+    // large parts of the heap.
+    QMutexLocker locker(&w->sharedLock);
+    const auto end = w->stack.begin() + w->stack.size()/2;
+    w->shared.insert(w->shared.end(), w->stack.begin(), end);
+    w->stack.erase(w->stack.begin(), end);
+    w->sharedSize.store(int(w->shared.size()));
+}
+
+bool ParallelMarker::steal(MarkWorker *thief, MarkWorker *victim)
+{
+    QMutexLocker locker(&victim->sharedLock);
+    if (victim->shared.empty())
+        return false;
+    const size_t n = (victim->shared.size() + 1)/2;
+    thief->stack.insert(thief->stack.end(), victim->shared.end() - n, victim->shared.end());
+    victim->shared.resize(victim->shared.size() - n);
+    victim->sharedSize.store(int(victim->shared.size()));
+    return true;
+}
+
+bool ParallelMarker::findWork(MarkWorker *w)
+{
+    // Only busy workers publish work, and they empty their own shared part before going
+    // idle. Once all workers are idle, the heap is fully traced.
+    idleWorkers.ref();
+    const int index = int(w - workers.data());
+    forever {
+        for (int i = 1; i < nWorkers; ++i) {
+            MarkWorker *victim = workers.data() + (index + i) % nWorkers;
+            if (!victim->sharedSize.load())
+                continue;
+            idleWorkers.deref();
+            if (steal(w, victim))
+                return true;
+            idleWorkers.ref();
         }
+        if (idleWorkers.load() == nWorkers)
+            return false;
+        QThread::yieldCurrentThread();
     }
 }
 
+} // namespace
+#endif
+
+void Heap::Base::markInParallel()
+{
+#ifdef V4_PARALLEL_MARKING
+    const HeapItem *h = reinterpret_cast<const HeapItem *>(this);
+    Chunk *c = h->chunk();
+    size_t index = h - c->realBase();
+    Q_ASSERT(!Chunk::testBit(c->extendsBitmap, index));
+    std::atomic<quintptr> *bitmap = reinterpret_cast<std::atomic<quintptr> *>(c->blackBitmap + Chunk::bitmapIndex(index));
+    quintptr bit = Chunk::bitForIndex(index);
+    // the object's contents were published when the marking threads got started
+    if (bitmap->load(std::memory_order_relaxed) & bit)
+        return;
+    if (bitmap->fetch_or(bit, std::memory_order_relaxed) & bit)
+        return;
+    Q_ASSERT(currentMarkWorker);
+    currentMarkWorker->stack.push_back(this);
+#else
+    Q_UNREACHABLE();
+#endif
+}
+
+void MemoryManager::setMarkingThreadCount(int count)
+{
+#ifdef V4_PARALLEL_MARKING
+    markThreadCount = qMax(1, count);
+#else
+    Q_UNUSED(count);
+#endif
+}
+
+#ifdef V4_PARALLEL_MARKING
+void MemoryManager::drainMarkStackInParallel(Value *markBase)
+{
+    ParallelMarker marker(engine, markThreadCount);
+    int n = 0;
+    for (Value *v = markBase; v < engine->jsStackTop; ++v)
+        marker.seed(n++ % markThreadCount, v->m());
+    for (Heap::Base *h : savedMarkStack)
+        marker.seed(n++ % markThreadCount, h);
+    engine->jsStackTop = markBase;
+    savedMarkStack.clear();
+
+    if (!markThreadPool)
+        markThreadPool = new QThreadPool;
+    markThreadPool->setMaxThreadCount(markThreadCount - 1);
+
+    // The engine thread takes part in marking, and the mutator is stopped until all
+    // threads are done. Marking only reads QObjects and the heap, except for the
+    // black bits, which are set atomically.
+    engine->isGCMarkingInParallel = true;
+    for (int i = 1; i < markThreadCount; ++i)
+        markThreadPool->start(new MarkTask(&marker, i));
+    marker.run(0);
+    markThreadPool->waitForDone();
+    engine->isGCMarkingInParallel = false;
+
+    markStackSize += marker.markedObjects();
+    currentCycleStats.markingThreads = markThreadCount;
+}
+#endif
+
 void MemoryManager::mark()
 {
+    // dead objects must be gone before we start marking again
+    blockAllocator.finishSweep();
+
     Value *markBase = engine->jsStackTop;
 
-    markStackSize = 0;
+    // keep counting the objects marked in earlier slices of an incremental cycle
+    if (gcState != GCMarking)
+        markStackSize = 0;
 
-    if (nextGCIsIncremental) {
+    if (nextGCIsIncremental || gcState == GCMarking) {
         // need to collect all gray items and push them onto the mark stack
         blockAllocator.collectGrayItems(engine);
+        nursery.collectGrayItems(engine);
         hugeItemAllocator.collectGrayItems(engine);
     }
 
@@ -947,14 +1611,150 @@ void MemoryManager::mark()
             drainMarkStack(markBase);
     }
 
+#ifdef V4_PARALLEL_MARKING
+    if (markThreadCount > 1) {
+        drainMarkStackInParallel(markBase);
+        return;
+    }
+#endif
+
     drainMarkStack(markBase);
+
+    // finish the work left over from incremental marking slices
+    while (!savedMarkStack.empty()) {
+        engine->pushForGC(savedMarkStack.back());
+        savedMarkStack.pop_back();
+        drainMarkStack(markBase);
+    }
 }
 
-void MemoryManager::sweep(bool lastSweep)
+void MemoryManager::triggerGC(GCReason reason)
 {
-    if (lastSweep && nextGCIsIncremental) {
+    if (gcBlocked)
+        return;
+
+    if (gcState == GCIdle) {
+        if (incrementalSliceBudget) {
+            gcReason = reason;
+            startIncrementalMarking();
+        } else {
+            runGC(/*forceFullCollection*/ false, reason);
+        }
+        return;
+    }
+
+    // Finish the cycle once all reachable objects have been traced, or if the mutator
+    // allocates faster than we mark and the heap keeps growing.
+    const size_t targetSlots = pacingPolicy.targetHeapSize/Chunk::SlotSize;
+    if (savedMarkStack.empty()
+            || totalSlots() > pacingPolicy.growthFactor*totalSlotsAtCycleStart + targetSlots
+            || heapLimitReached()) {
+        finishIncrementalMarking();
+        return;
+    }
+
+    QScopedValueRollback<bool> gcBlocker(gcBlocked, true);
+    QElapsedTimer t;
+    t.start();
+    runIncrementalMarkingSlice(engine->jsStackTop, t);
+    recordPause(t.nsecsElapsed()/1000);
+    allocationsSinceLastSlice = 0;
+}
+
+void MemoryManager::startIncrementalMarking()
+{
+    Q_ASSERT(gcState == GCIdle);
+    Q_ASSERT(savedMarkStack.empty());
+
+    QScopedValueRollback<bool> gcBlocker(gcBlocked, true);
+    QElapsedTimer t;
+    t.start();
+
+    blockAllocator.finishSweep();
+    gcState = GCMarking;
+    cycleTimer.start();
+    currentCycleStats = GCCycleStats();
+    allocationsSinceLastSlice = 0;
+    totalSlotsAtCycleStart = totalSlots();
+    markStackSize = 0;
+
+    Value *markBase = engine->jsStackTop;
+    if (nextGCIsIncremental) {
+        blockAllocator.collectGrayItems(engine);
+        nursery.collectGrayItems(engine);
+        hugeItemAllocator.collectGrayItems(engine);
+    }
+    // The roots are scanned again in the final pause, as neither the JS stack nor the
+    // persistent values are covered by the write barrier.
+    engine->markObjects(nextGCIsIncremental);
+    collectFromJSStack();
+    m_persistentValues->mark(engine);
+
+    runIncrementalMarkingSlice(markBase, t);
+    recordPause(t.nsecsElapsed()/1000);
+}
+
+bool MemoryManager::runIncrementalMarkingSlice(Value *markBase, const QElapsedTimer &timer)
+{
+    const qint64 budget = incrementalSliceBudget*1000;
+    while (drainMarkStack(markBase, timer, budget)) {
+        if (savedMarkStack.empty())
+            return true;
+        engine->pushForGC(savedMarkStack.back());
+        savedMarkStack.pop_back();
+    }
+
+    // Out of time. The mutator is going to reuse the JS stack, so park the remaining
+    // work until the next slice.
+    for (Value *v = markBase; v < engine->jsStackTop; ++v)
+        savedMarkStack.push_back(v->m());
+    engine->jsStackTop = markBase;
+    return false;
+}
+
+void MemoryManager::finishIncrementalMarking()
+{
+    Q_ASSERT(gcState == GCMarking);
+
+    QScopedValueRollback<bool> gcBlocker(gcBlocked, true);
+    QElapsedTimer t;
+    t.start();
+
+    const size_t usedBefore = gcStats ? getUsedMem() : 0;
+    mark();
+    qint64 markTime = t.nsecsElapsed()/1000;
+    sweep(/*lastSweep*/false, /*lazy*/!aggressiveGC);
+    recordPause(t.nsecsElapsed()/1000);
+
+    gcState = GCIdle;
+    lastCycleStats = currentCycleStats;
+    reportGC(cycleTimer.nsecsElapsed());
+
+    if (gcStats) {
+        const size_t usedAfter = getUsedMem();
+        qDebug() << "========== GC (incremental marking) ==========";
+        qDebug() << "Incremental:" << nextGCIsIncremental;
+        qDebug() << "Marking done in" << lastCycleStats.nSlices << "pauses," << markStackSize << "objects marked";
+        qDebug() << "Final mark pause" << markTime << "us.";
+        qDebug() << "Longest pause" << lastCycleStats.longestPause << "us.";
+        qDebug() << "Total pause time" << lastCycleStats.totalPause << "us.";
+        qDebug() << "Used memory before sweep:" << usedBefore;
+        qDebug() << "Used memory after sweep :" << usedAfter;
+        const InternalClassStatistics classStats = engine->internalClassStatistics();
+        qDebug() << "Internal classes:" << classStats.classCount << "using" << classStats.memoryUsage
+                 << "bytes," << classStats.transitionCount << "transitions";
+        qDebug() << "======== End GC ========";
+    }
+
+    prepareNextGC();
+}
+
+void MemoryManager::sweep(bool lastSweep, bool lazy)
+{
+    if (lastSweep && (nextGCIsIncremental || gcState == GCMarking)) {
         // ensure we properly clean up on destruction even if the GC is in incremental mode
         blockAllocator.resetBlackBits();
+        nursery.resetBlackBits();
         hugeItemAllocator.resetBlackBits();
     }
 
@@ -1003,18 +1803,101 @@ void MemoryManager::sweep(bool lastSweep)
         }
     }
 
-    blockAllocator.sweep();
+    // The nursery is small, and swept right away so that its chunks can be promoted.
+    nursery.sweep();
+    promoteNurseryChunks();
+
+    // In a minor collection, all objects of the old generation are still marked, unless
+    // it got new objects because the nursery was disabled or not in use.
+    currentCycleStats.minorCollection = nextGCIsIncremental && !lastSweep && !oldGenerationAllocatedSinceSweep;
+    if (!currentCycleStats.minorCollection) {
+        blockAllocator.sweep(lazy && !lastSweep);
+        oldGenerationAllocatedSinceSweep = false;
+    }
     hugeItemAllocator.sweep();
+
+    // Temporaries are only referenced from the JS stack, and need to be traced again by the
+    // next collection. The ones of scopes that ended while marking can be freed now.
+    temporaryArena.resetBlackBits();
+    if (!temporaryScopeDepth)
+        temporaryArena.release(TemporaryArena::Position());
+}
+
+void MemoryManager::promoteNurseryChunks()
+{
+    // Survivors keep their mark bits and thus are part of the old generation already. Chunks
+    // they fill up are handed over to the block allocator, and replaced by fresh ones.
+    size_t kept = 0;
+    size_t usedSlots = 0;
+    const size_t nChunks = nursery.chunks.size();
+    for (size_t i = 0; i < nChunks; ++i) {
+        Chunk *c = nursery.chunks.at(i);
+        const uint used = c->nUsedSlots();
+        if (used*100 > Chunk::AvailableSlots*NurseryPromotionThreshold) {
+            blockAllocator.chunks.push_back(c);
+            c->sortIntoBins(blockAllocator.freeBins, BlockAllocator::NumBins);
+            blockAllocator.usedSlotsAfterLastSweep += used;
+            ++currentCycleStats.promotedChunks;
+        } else {
+            nursery.chunks[kept++] = c;
+            usedSlots += used;
+        }
+    }
+    if (kept == nChunks)
+        return;
+
+    nursery.chunks.resize(kept);
+    nursery.nextFree = 0;
+    nursery.nFree = 0;
+    memset(nursery.freeBins, 0, sizeof(nursery.freeBins));
+    for (auto c : nursery.chunks)
+        c->sortIntoBins(nursery.freeBins, BlockAllocator::NumBins);
+    nursery.usedSlotsAfterLastSweep = usedSlots;
 }
 
 bool MemoryManager::shouldRunGC() const
 {
-    size_t total = blockAllocator.totalSlots();
-    if (total > MinSlotsGCLimit && usedSlotsAfterLastFullSweep * GCOverallocation < total * 100)
+    size_t total = totalSlots();
+    if (total > pacingPolicy.targetHeapSize/Chunk::SlotSize
+            && usedSlotsAfterLastFullSweep*pacingPolicy.growthFactor < total)
         return true;
     return false;
 }
 
+size_t MemoryManager::releaseFreeMemory()
+{
+    // the chunks are in use by the running cycle
+    if (gcState == GCMarking)
+        return 0;
+    return blockAllocator.releaseFreeMemory();
+}
+
+qreal MemoryManager::fragmentationRatio() const
+{
+    const size_t allocated = blockAllocator.allocatedMem() + nursery.allocatedMem();
+    if (!allocated)
+        return 0;
+    return 1 - qreal(getUsedMem())/allocated;
+}
+
+void MemoryManager::setGCPacingPolicy(const GCPacingPolicy &policy)
+{
+    pacingPolicy = policy;
+    // growing the heap less than that would collect on every new chunk
+    pacingPolicy.growthFactor = qMax(qreal(1.1), policy.growthFactor);
+}
+
+size_t MemoryManager::heapSize() const
+{
+    return totalSlots()*Chunk::SlotSize + getLargeItemsMem();
+}
+
+void MemoryManager::reportGC(qint64 nsecs)
+{
+    ++nCollections;
+    Q_V4_PROFILE_GC(engine, gcReason, nsecs, getUsedMem() + getLargeItemsMem(), heapSize());
+}
+
 size_t dumpBins(BlockAllocator *b, bool printOutput = true)
 {
     size_t totalSlotMem = 0;
@@ -1036,16 +1919,25 @@ size_t dumpBins(BlockAllocator *b, bool printOutput = true)
     return totalSlotMem*Chunk::SlotSize;
 }
 
-void MemoryManager::runGC(bool forceFullCollection)
+void MemoryManager::runGC(bool forceFullCollection, GCReason reason)
 {
     if (gcBlocked) {
 //        qDebug() << "Not running GC.";
         return;
     }
 
+    if (gcState == GCMarking) {
+        // complete the running cycle first
+        const bool wasFullCollection = !nextGCIsIncremental;
+        finishIncrementalMarking();
+        if (!forceFullCollection || wasFullCollection)
+            return;
+    }
+
     if (forceFullCollection) {
         // do a full GC
         blockAllocator.resetBlackBits();
+        nursery.resetBlackBits();
         hugeItemAllocator.resetBlackBits();
         nextGCIsIncremental = false;
     }
@@ -1053,10 +1945,19 @@ void MemoryManager::runGC(bool forceFullCollection)
     QScopedValueRollback<bool> gcBlocker(gcBlocked, true);
 //    qDebug() << "runGC";
 
+    QElapsedTimer pauseTimer;
+    pauseTimer.start();
+    currentCycleStats = GCCycleStats();
+    gcReason = reason;
+
+    // Explicit full collections destroy unreachable objects right away, others leave that
+    // to the allocator.
+    const bool lazySweep = !forceFullCollection && !aggressiveGC;
+
     if (!gcStats) {
 //        uint oldUsed = allocator.usedMem();
         mark();
-        sweep();
+        sweep(/*lastSweep*/false, lazySweep);
 //        DEBUG << "RUN GC: allocated:" << allocator.allocatedMem() << "used before" << oldUsed << "used now" << allocator.usedMem();
     } else {
         bool triggeredByUnmanagedHeap = (unmanagedHeapSize > unmanagedHeapSizeGCLimit);
@@ -1073,6 +1974,8 @@ void MemoryManager::runGC(bool forceFullCollection)
 #endif
         qDebug() << "Incremental:" << nextGCIsIncremental;
         qDebug() << "Allocated" << totalMem << "bytes in" << blockAllocator.chunks.size() << "chunks";
+        if (!nursery.chunks.empty())
+            qDebug() << "Nursery:" << nursery.chunks.size() << "chunks";
         qDebug() << "Fragmented memory before GC" << (totalMem - usedBefore);
         dumpBins(&blockAllocator);
 
@@ -1085,7 +1988,7 @@ void MemoryManager::runGC(bool forceFullCollection)
         mark();
         qint64 markTime = t.nsecsElapsed()/1000;
         t.restart();
-        sweep();
+        sweep(/*lastSweep*/false, lazySweep);
         const size_t usedAfter = getUsedMem();
         const size_t largeItemsAfter = getLargeItemsMem();
         qint64 sweepTime = t.nsecsElapsed()/1000;
@@ -1096,18 +1999,25 @@ void MemoryManager::runGC(bool forceFullCollection)
             qDebug() << "   new unmanaged heap:" << unmanagedHeapSize;
             qDebug() << "   unmanaged heap limit:" << unmanagedHeapSizeGCLimit;
         }
-        size_t memInBins = dumpBins(&blockAllocator);
+        size_t memInBins = dumpBins(&blockAllocator) + dumpBins(&nursery, false);
+        if (blockAllocator.hasPendingSweep())
+            qDebug() << "Chunks left for lazy sweeping:" << (blockAllocator.sweepEnd - blockAllocator.sweepIndex);
 #ifdef MM_STATS
         if (nextGCIsIncremental)
             qDebug() << "  number of gray items:" << nGrayItems;
 #endif
+        if (currentCycleStats.minorCollection)
+            qDebug() << "Minor collection, promoted" << currentCycleStats.promotedChunks << "nursery chunks";
         qDebug() << "Marked object in" << markTime << "us.";
         qDebug() << "   " << markStackSize << "objects marked";
         qDebug() << "Sweeped object in" << sweepTime << "us.";
         qDebug() << "Used memory before GC:" << usedBefore;
         qDebug() << "Used memory after GC :" << usedAfter;
         qDebug() << "Freed up bytes       :" << (usedBefore - usedAfter);
-        size_t lost = blockAllocator.allocatedMem() - memInBins - usedAfter;
+        qDebug() << "Fragmentation ratio  :" << fragmentationRatio();
+        // free slots of chunks that still need sweeping are not in the bins yet
+        size_t lost = blockAllocator.hasPendingSweep() ? 0 : blockAllocator.allocatedMem() + nursery.allocatedMem()
+                - memInBins - blockAllocator.sparseChunksFreeMem() - usedAfter;
         if (lost)
             qDebug() << "!!!!!!!!!!!!!!!!!!!!! LOST MEM:" << lost << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!";
         if (largeItemsBefore || largeItemsAfter) {
@@ -1118,13 +2028,40 @@ void MemoryManager::runGC(bool forceFullCollection)
         qDebug() << "======== End GC ========";
     }
 
+    const qint64 pause = pauseTimer.nsecsElapsed();
+    recordPause(pause/1000);
+    lastCycleStats = currentCycleStats;
+    reportGC(pause);
+
+    prepareNextGC();
+}
+
+void MemoryManager::prepareNextGC()
+{
     if (aggressiveGC) {
         // ensure we don't 'loose' any memory
-        Q_ASSERT(blockAllocator.allocatedMem() == getUsedMem() + dumpBins(&blockAllocator, false));
+        Q_ASSERT(blockAllocator.allocatedMem() + nursery.allocatedMem()
+                 == getUsedMem() + dumpBins(&blockAllocator, false) + dumpBins(&nursery, false)
+                    + blockAllocator.sparseChunksFreeMem());
     }
 
-    if (!nextGCIsIncremental)
-        usedSlotsAfterLastFullSweep = blockAllocator.usedSlotsAfterLastSweep;
+    const size_t usedSlotsAfterSweep = blockAllocator.usedSlotsAfterLastSweep + nursery.usedSlotsAfterLastSweep;
+    if (!nextGCIsIncremental) {
+        usedSlotsAfterLastFullSweep = usedSlotsAfterSweep;
+        // Collecting again whenever the heap grows beyond the limit would hardly free anything
+        // while the live data alone takes up most of it. Let the heap grow in proportion to
+        // the live data first, the same way the growth factor paces collections below the limit.
+        const size_t liveSize = usedSlotsAfterSweep*Chunk::SlotSize + getLargeItemsMem();
+        if (liveSize * 4 > pacingPolicy.maxHeapSize * 3)
+            heapLimitTrigger = size_t(liveSize*pacingPolicy.growthFactor);
+        else
+            heapLimitTrigger = 0;
+        if (fragmentationLimitRatio > 0 && fragmentationRatio() > fragmentationLimitRatio) {
+            lastCycleStats.releasedMemory = releaseFreeMemory();
+            if (gcStats)
+                qDebug() << "Released" << lastCycleStats.releasedMemory << "bytes of fragmented memory";
+        }
+    }
 
 #if WRITEBARRIER(steele)
     static int count = 0;
@@ -1132,8 +2069,8 @@ void MemoryManager::runGC(bool forceFullCollection)
     if (aggressiveGC) {
         nextGCIsIncremental = (count % 256);
     } else {
-        size_t total = blockAllocator.totalSlots();
-        size_t usedSlots = blockAllocator.usedSlotsAfterLastSweep;
+        size_t total = totalSlots();
+        size_t usedSlots = usedSlotsAfterSweep;
         if (!nextGCIsIncremental) {
             // always try an incremental GC after a full one, unless there is anyway lots of memory pressure
             nextGCIsIncremental = usedSlots * 4 < total * 3;
@@ -1151,18 +2088,19 @@ void MemoryManager::runGC(bool forceFullCollection)
     if (!nextGCIsIncremental) {
         // do a full GC
         blockAllocator.resetBlackBits();
+        nursery.resetBlackBits();
         hugeItemAllocator.resetBlackBits();
     }
 }
 
 size_t MemoryManager::getUsedMem() const
 {
-    return blockAllocator.usedMem();
+    return blockAllocator.usedMem() + nursery.usedMem();
 }
 
 size_t MemoryManager::getAllocatedMem() const
 {
-    return blockAllocator.allocatedMem() + hugeItemAllocator.usedMem();
+    return blockAllocator.allocatedMem() + nursery.allocatedMem() + hugeItemAllocator.usedMem();
 }
 
 size_t MemoryManager::getLargeItemsMem() const
@@ -1174,12 +2112,16 @@ MemoryManager::~MemoryManager()
 {
     delete m_persistentValues;
 
+    savedMarkStack.clear();
     sweep(/*lastSweep*/true);
     blockAllocator.freeAll();
+    nursery.freeAll();
     hugeItemAllocator.freeAll();
+    temporaryArena.freeAll();
     stackAllocator.freeAll();
 
     delete m_weakValues;
+    delete markThreadPool;
 #ifdef V4_USE_VALGRIND
     VALGRIND_DESTROY_MEMPOOL(this);
 #endif
@@ -57,17 +57,25 @@
 #include <private/qv4object_p.h>
 #include <private/qv4mmdefs_p.h>
 #include <QVector>
+#include <QElapsedTimer>
 
 //#define DETAILED_MM_STATS
 
 #define QV4_MM_MAXBLOCK_SHIFT "QV4_MM_MAXBLOCK_SHIFT"
 #define QV4_MM_MAX_CHUNK_SIZE "QV4_MM_MAX_CHUNK_SIZE"
 #define QV4_MM_STATS "QV4_MM_STATS"
+#define QV4_MM_INCREMENTAL_GC_SLICE "QV4_MM_INCREMENTAL_GC_SLICE"
+#define QV4_MM_NURSERY_SIZE "QV4_MM_NURSERY_SIZE"
+#define QV4_MM_MARK_THREADS "QV4_MM_MARK_THREADS"
+#define QV4_MM_MAX_HEAP_SIZE "QV4_MM_MAX_HEAP_SIZE"
+#define QV4_MM_FRAGMENTATION_LIMIT "QV4_MM_FRAGMENTATION_LIMIT"
 
 #define MM_DEBUG 0
 
 QT_BEGIN_NAMESPACE
 
+class QThreadPool;
+
 namespace QV4 {
 
 struct ChunkAllocator;
@@ -144,27 +152,56 @@ struct BlockAllocator {
     }
 
     size_t allocatedMem() const {
-        return chunks.size()*Chunk::DataSize;
+        return chunks.size()*Chunk::DataSize - decommittedMem();
     }
     size_t usedMem() const {
         uint used = 0;
-        for (auto c : chunks)
-            used += c->nUsedSlots()*Chunk::SlotSize;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            Chunk *c = chunks.at(i);
+            used += (isPendingSweep(i) ? c->nUsedSlotsAfterSweep() : c->nUsedSlots())*Chunk::SlotSize;
+        }
         return used;
     }
 
-    void sweep();
+    // With lazy sweeping, the chunks are only swept when the allocator runs out of free
+    // slots, or before the next collection starts marking.
+    void sweep(bool lazy = false);
+    bool hasPendingSweep() const { return sweepIndex < sweepEnd; }
+    bool isPendingSweep(size_t chunkIndex) const { return chunkIndex >= sweepIndex && chunkIndex < sweepEnd; }
+    bool sweepNextChunk();
+    void finishSweep() { while (sweepNextChunk()) {} }
     void freeAll();
     void resetBlackBits();
     void collectGrayItems(ExecutionEngine *engine);
 
+    // Objects are never moved, as C++ code and JIT compiled functions hold on to raw heap
+    // pointers. Chunks that are used less than SparseChunkThreshold percent instead get no
+    // new objects, so that they can run empty and be given back to the OS. Their free pages
+    // are decommitted in the meantime.
+    enum { SparseChunkThreshold = 25 };
+    struct SparseChunk {
+        Chunk *chunk;
+        quint32 decommittedPages;
+    };
+    size_t releaseFreeMemory();
+    bool reuseSparseChunk();
+    bool isSparse(Chunk *c) const;
+    size_t decommittedMem() const;
+    size_t sparseChunksFreeMem() const;
+
     // bump allocations
     HeapItem *nextFree = 0;
     size_t nFree = 0;
     size_t usedSlotsAfterLastSweep = 0;
+    // chunks[sweepIndex] to chunks[sweepEnd - 1] still need to be swept
+    size_t sweepIndex = 0;
+    size_t sweepEnd = 0;
+    bool resetBlackBitsAfterSweep = false;
     HeapItem *freeBins[NumBins];
     ChunkAllocator *chunkAllocator;
     std::vector<Chunk *> chunks;
+    // sorted by address
+    std::vector<SparseChunk> sparseChunks;
 #if MM_DEBUG
     uint allocations[NumBins];
 #endif
@@ -197,6 +234,42 @@ struct HugeItemAllocator {
     std::vector<HugeChunk> chunks;
 };
 
+// Bump allocator for strings that cannot outlive the binding evaluation that created them,
+// see MemoryManager::TemporaryScope. Its items are never swept, but destroyed all at once
+// when the scope that allocated them ends.
+struct TemporaryArena {
+    TemporaryArena(ChunkAllocator *chunkAllocator)
+        : chunkAllocator(chunkAllocator)
+    {}
+
+    struct Position {
+        size_t chunk;
+        HeapItem *nextFree;
+        size_t nItems;
+    };
+
+    HeapItem *allocate(size_t size);
+    Position position() const { return { currentChunk, nextFree, items.size() }; }
+    void release(const Position &position);
+    bool contains(const Heap::Base *b) const;
+    void resetBlackBits();
+    void freeAll();
+
+    size_t usedMem() const {
+        if (!nextFree)
+            return 0;
+        return currentChunk*Chunk::DataSize + (nextFree - chunks.at(currentChunk)->first())*Chunk::SlotSize;
+    }
+
+    ChunkAllocator *chunkAllocator;
+    std::vector<Chunk *> chunks;
+    // in allocation order, so that they can be destroyed
+    std::vector<Heap::Base *> items;
+    size_t currentChunk = 0;
+    HeapItem *nextFree = 0;
+    HeapItem *end = 0;
+};
+
 
 class Q_QML_EXPORT MemoryManager
 {
@@ -422,7 +495,101 @@ public:
         return t->d();
     }
 
-    void runGC(bool forceFullCollection = false);
+    // Strings computed by a binding evaluation that doesn't let its temps escape (see
+    // QV4::Function::tempsDontEscape()) are bump allocated in an arena instead of on the GC
+    // heap. The arena is reset when the TemporaryScope around the evaluation and the write
+    // of its result ends.
+    class TemporaryScope
+    {
+    public:
+        TemporaryScope(MemoryManager *mm);
+        ~TemporaryScope();
+
+    private:
+        MemoryManager *mm;
+        TemporaryArena::Position position;
+    };
+
+    // Lets the strings created by the code of \a function, called with \a outer as scope,
+    // go to the arena of the innermost TemporaryScope. Passing a null function disables
+    // temporary allocations for nested evaluations.
+    class TemporaryAllocations
+    {
+    public:
+        TemporaryAllocations(MemoryManager *mm, Function *function, Heap::ExecutionContext *outer);
+        ~TemporaryAllocations();
+
+    private:
+        MemoryManager *mm;
+        Function *function;
+        Heap::ExecutionContext *outer;
+        qint32 callDepth;
+    };
+
+    // These fall back to the GC heap outside of TemporaryAllocations
+    Heap::String *allocTemporaryString(const QString &text);
+    Heap::String *allocTemporaryString(Heap::String *left, Heap::String *right);
+    // Copies a temporary string to the GC heap before it is handed to code that could keep it
+    ReturnedValue escapeTemporary(const Value &value);
+    size_t temporaryMem() const { return temporaryArena.usedMem(); }
+
+    void runGC(bool forceFullCollection = false, GCReason reason = GCReasonExplicit);
+
+    void setGCPacingPolicy(const GCPacingPolicy &policy);
+    const GCPacingPolicy &gcPacingPolicy() const { return pacingPolicy; }
+    size_t heapSize() const;
+
+    // Gives the memory of empty chunks back to the OS, and stops allocating from sparsely
+    // used ones, see BlockAllocator::SparseChunkThreshold. Returns the number of bytes released.
+    size_t releaseFreeMemory();
+    // Share of the memory in heap chunks that is free, between 0 and 1
+    qreal fragmentationRatio() const;
+    // Free memory gets released after full collections that leave the heap fragmented
+    // by more than this ratio. 0 disables it.
+    void setFragmentationLimit(qreal ratio) { fragmentationLimitRatio = qBound(qreal(0), ratio, qreal(1)); }
+    qreal fragmentationLimit() const { return fragmentationLimitRatio; }
+
+    // Time budget in microseconds for one slice of incremental marking. 0 disables
+    // incremental marking, and every collection is done in a single pause.
+    void setIncrementalMarkingSliceBudget(qint64 usecs)
+    {
+#if WRITEBARRIER(steele)
+        incrementalSliceBudget = qMax(qint64(0), usecs);
+#else
+        Q_UNUSED(usecs); // interleaving marking with the mutator requires the write barrier
+#endif
+    }
+    qint64 incrementalMarkingSliceBudget() const { return incrementalSliceBudget; }
+    bool isIncrementalMarkingInProgress() const { return gcState == GCMarking; }
+
+    // Size in bytes of the nursery young objects get allocated in between two minor
+    // collections. 0 disables the nursery.
+    void setNurserySize(size_t size)
+    {
+#if WRITEBARRIER(steele)
+        nurseryChunkLimit = (size + Chunk::ChunkSize - 1)/Chunk::ChunkSize;
+#else
+        Q_UNUSED(size); // minor collections rely on the write barrier
+#endif
+    }
+    size_t nurserySize() const { return nurseryChunkLimit*Chunk::ChunkSize; }
+
+    // Number of threads, including the engine thread, that share the work of tracing the
+    // heap in the marking pause. 1 does all marking on the engine thread.
+    void setMarkingThreadCount(int count);
+    int markingThreadCount() const { return markThreadCount; }
+
+    struct GCCycleStats {
+        uint nSlices = 0;
+        qint64 longestPause = 0; // in microseconds
+        qint64 totalPause = 0; // in microseconds
+        bool minorCollection = false;
+        uint promotedChunks = 0;
+        uint markingThreads = 1;
+        size_t releasedMemory = 0;
+    };
+    const GCCycleStats &lastGCCycleStats() const { return lastCycleStats; }
+    uint collectionCount() const { return nCollections; }
 
     void dumpStats() const;
 
@@ -446,17 +613,65 @@ protected:
 #endif // DETAILED_MM_STATS
 
 private:
+    enum GCState {
+        GCIdle,
+        GCMarking
+    };
+
+    enum {
+        IncrementalMarkAllocationInterval = 512,
+        IncrementalMarkTimeCheckInterval = 64
+    };
+
     void collectFromJSStack() const;
     void mark();
-    void sweep(bool lastSweep = false);
+    void sweep(bool lastSweep = false, bool lazy = false);
     bool shouldRunGC() const;
+    bool heapLimitReached(std::size_t extraSize = 0) const
+    {
+        return pacingPolicy.maxHeapSize
+                && heapSize() + extraSize > qMax(pacingPolicy.maxHeapSize, heapLimitTrigger);
+    }
+    void reportGC(qint64 nsecs);
+    void prepareNextGC();
+    size_t totalSlots() const { return blockAllocator.totalSlots() + nursery.totalSlots(); }
+
+    // Young objects only go to the nursery while old objects keep their mark bits
+    bool useNursery() const { return nurseryChunkLimit && nextGCIsIncremental; }
+    HeapItem *allocateSlots(std::size_t size, bool didRunGC);
+    bool allocatesTemporaries() const;
+    void promoteNurseryChunks();
+
+    void triggerGC(GCReason reason);
+    void startIncrementalMarking();
+    bool runIncrementalMarkingSlice(Value *markBase, const QElapsedTimer &timer);
+    void finishIncrementalMarking();
+    bool drainMarkStack(Value *markBase, const QElapsedTimer &timer, qint64 budget);
+    void drainMarkStackInParallel(Value *markBase);
+    void allocatedDuringMarking(HeapItem *item)
+    {
+        // New objects have to survive the running cycle, and are rescanned in the final pause,
+        // as their initialization doesn't go through the write barrier.
+        Chunk *c = item->chunk();
+        size_t index = item - c->realBase();
+        Chunk::setBit(c->blackBitmap, index);
+        Chunk::setBit(c->grayBitmap, index);
+    }
+    void recordPause(qint64 usecs)
+    {
+        ++currentCycleStats.nSlices;
+        currentCycleStats.totalPause += usecs;
+        currentCycleStats.longestPause = qMax(currentCycleStats.longestPause, usecs);
+    }
 
 public:
     QV4::ExecutionEngine *engine;
     ChunkAllocator *chunkAllocator;
     StackAllocator<Heap::CallContext> stackAllocator;
     BlockAllocator blockAllocator;
+    BlockAllocator nursery;
     HugeItemAllocator hugeItemAllocator;
+    TemporaryArena temporaryArena;
     PersistentValueStorage *m_persistentValues;
     PersistentValueStorage *m_weakValues;
     QVector<Value *> m_pendingFreedObjectWrapperValue;
@@ -469,6 +684,32 @@ public:
     bool aggressiveGC = false;
     bool gcStats = false;
     bool nextGCIsIncremental = false;
+
+private:
+    GCState gcState = GCIdle;
+    qint64 incrementalSliceBudget = 0;
+    size_t nurseryChunkLimit = 0;
+    // the old generation got new objects that a minor collection has to sweep
+    bool oldGenerationAllocatedSinceSweep = false;
+    uint allocationsSinceLastSlice = 0;
+    size_t totalSlotsAtCycleStart = 0;
+    std::vector<Heap::Base *> savedMarkStack;
+    int markThreadCount = 1;
+    QThreadPool *markThreadPool = nullptr;
+    GCCycleStats currentCycleStats;
+    GCCycleStats lastCycleStats;
+    GCPacingPolicy pacingPolicy;
+    // The heap size at which the heap limit collects, if the live data after the last full
+    // collection takes up most of the maximum heap size of the pacing policy
+    size_t heapLimitTrigger = 0;
+    uint nCollections = 0;
+    qreal fragmentationLimitRatio = 0;
+    GCReason gcReason = GCReasonExplicit;
+    QElapsedTimer cycleTimer;
+    uint temporaryScopeDepth = 0;
+    Function *temporaryFunction = nullptr;
+    Heap::ExecutionContext *temporaryOuter = nullptr;
+    qint32 temporaryCallDepth = 0;
 };
 
 }
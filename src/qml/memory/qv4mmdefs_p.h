@@ -181,9 +181,13 @@ struct Chunk {
         return usedSlots;
     }
 
+    // number of slots that will still be in use once the chunk has been swept
+    uint nUsedSlotsAfterSweep() const;
+
     void sweep();
     void freeAll();
     void resetBlackBits();
+    void resetGrayBits();
     void collectGrayItems(ExecutionEngine *engine);
 
     void sortIntoBins(HeapItem **bins, uint nBins);
@@ -275,6 +279,26 @@ struct EngineBase {
     quint16 unused = 0;
 };
 
+// Why the memory manager started a collection
+enum GCReason {
+    GCReasonExplicit,           // gc(), QJSEngine::collectGarbage() or a forced collection
+    GCReasonHeapGrowth,         // the heap grew beyond what the pacing policy allows
+    GCReasonHeapLimit,          // the heap reached the maximum heap size of the pacing policy
+    GCReasonUnmanagedMemory,    // too much memory outside the heap is held by managed objects
+    GCReasonNurseryFull,        // minor collection of the nursery
+    GCReasonAggressive          // QV4_MM_AGGRESSIVE_GC
+};
+
+// Decides when growing the heap triggers a collection
+struct GCPacingPolicy {
+    // no collections are triggered by heap growth while the heap is smaller than this
+    size_t targetHeapSize = 16*Chunk::AvailableSlots*Chunk::SlotSize;
+    // the heap can grow to this multiple of the memory in use after the last full collection
+    qreal growthFactor = 2.0;
+    // soft limit: growing the heap beyond this always collects first. 0 means no limit.
+    size_t maxHeapSize = 0;
+};
+
 // Some helper classes and macros to automate the generation of our
 // tables used for marking objects
 
@@ -51,6 +51,7 @@
 #include <private/qqmlvaluetypewrapper_p.h>
 #include <private/qv4qobjectwrapper_p.h>
 #include <private/qv4variantobject_p.h>
+#include <private/qv4mm_p.h>
 
 #include <QVariant>
 #include <QtCore/qdebug.h>
@@ -158,6 +159,8 @@ void QQmlBinding::update(QQmlPropertyData::WriteFlags flags)
     DeleteWatcher watcher(this);
 
     QQmlEnginePrivate *ep = QQmlEnginePrivate::get(context()->engine);
+    // Declared before the scope, so that the result is gone when the temporaries get freed
+    QV4::MemoryManager::TemporaryScope temporaries(ep->v4engine()->memoryManager);
     QV4::Scope scope(ep->v4engine());
 
     if (canUseAccessor())
@@ -203,7 +206,7 @@ protected:
         bool isUndefined = false;
 
         QV4::ScopedCallData callData(scope);
-        QQmlJavaScriptExpression::evaluate(callData, &isUndefined, scope);
+        QQmlJavaScriptExpression::evaluate(callData, &isUndefined, scope, convertsResult());
 
         bool error = false;
         if (!watcher.wasDeleted() && isAddedToObject() && !hasError())
@@ -229,6 +232,8 @@ protected:
     }
 
     virtual bool write(const QV4::Value &result, bool isUndefined, QQmlPropertyData::WriteFlags flags) = 0;
+    // Whether write() only stores a copy of the result, converted to the property's type
+    virtual bool convertsResult() const = 0;
 };
 
 template<int StaticPropType>
@@ -288,6 +293,20 @@ protected:
         return slowWrite(*pd, vpd, result, isUndefined, flags);
     }
 
+    bool convertsResult() const Q_DECL_OVERRIDE Q_DECL_FINAL
+    {
+        if (StaticPropType != QMetaType::UnknownType)
+            return true;
+
+        QQmlPropertyData *pd;
+        QQmlPropertyData vpd;
+        getPropertyData(&pd, &vpd);
+        Q_ASSERT(pd);
+        // var and QJSValue properties keep the JS value itself
+        const int type = vpd.isValid() ? vpd.propType() : pd->propType();
+        return !pd->isVarProperty() && type != qMetaTypeId<QJSValue>();
+    }
+
     template <typename T>
     Q_ALWAYS_INLINE bool doStore(T value, const QQmlPropertyData *pd, QQmlPropertyData::WriteFlags flags) const
     {
@@ -540,6 +559,8 @@ public:
     {}
 
 protected:
+    bool convertsResult() const Q_DECL_OVERRIDE Q_DECL_FINAL { return true; }
+
     Q_ALWAYS_INLINE bool write(const QV4::Value &result, bool isUndefined,
                                QQmlPropertyData::WriteFlags flags) Q_DECL_OVERRIDE Q_DECL_FINAL
     {
@@ -49,6 +49,7 @@
 #include <private/qqmlglobal_p.h>
 #include <private/qv4qobjectwrapper_p.h>
 #include <private/qqmlbuiltinfunctions_p.h>
+#include <private/qv4mm_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -181,7 +182,7 @@ void QQmlJavaScriptExpression::refresh()
 
 
 
-void QQmlJavaScriptExpression::evaluate(QV4::CallData *callData, bool *isUndefined, QV4::Scope &scope)
+void QQmlJavaScriptExpression::evaluate(QV4::CallData *callData, bool *isUndefined, QV4::Scope &scope, bool allowTemporaries)
 {
     Q_ASSERT(m_context && m_context->engine);
 
@@ -218,10 +219,17 @@ void QQmlJavaScriptExpression::evaluate(QV4::CallData *callData, bool *isUndefin
     }
 
     QV4::ExecutionContext *outer = static_cast<QV4::ExecutionContext *>(m_qmlScope.valueRef());
-    if (v4Function->canUseSimpleFunction()) {
-        outer->simpleCall(scope, callData, v4Function);
-    } else {
-        outer->call(scope, callData, v4Function);
+    {
+        // Always set up, so that expressions evaluated from within this one don't use its arena
+        allowTemporaries = allowTemporaries && v4Function->tempsDontEscape() && !v4->debugger();
+        QV4::MemoryManager::TemporaryAllocations temporaries(v4->memoryManager,
+                                                             allowTemporaries ? v4Function : nullptr,
+                                                             outer->d());
+        if (v4Function->canUseSimpleFunction()) {
+            outer->simpleCall(scope, callData, v4Function);
+        } else {
+            outer->call(scope, callData, v4Function);
+        }
     }
 
     if (scope.hasException()) {
@@ -103,7 +103,10 @@ public:
     virtual QString expressionIdentifier() const = 0;
     virtual void expressionChanged() = 0;
 
-    void evaluate(QV4::CallData *callData, bool *isUndefined, QV4::Scope &scope);
+    // allowTemporaries lets the strings computed by the expression live in the arena of the
+    // surrounding QV4::MemoryManager::TemporaryScope, which then has to outlive any use of
+    // the result.
+    void evaluate(QV4::CallData *callData, bool *isUndefined, QV4::Scope &scope, bool allowTemporaries = false);
 
     inline bool notifyOnValueChanged() const;
 
@@ -276,6 +276,8 @@ QQmlPropertyCache::~QQmlPropertyCache()
         args = next;
     }
 
+    qDeleteAll(methodCallPlans);
+
     // We must clear this prior to releasing the parent incase it is a
     // linked hash
     stringCache.clear();
@@ -759,6 +761,8 @@ void QQmlPropertyCache::invalidate(const QMetaObject *metaObject)
 
     _hasPropertyOverrides = false;
     argumentsCache = 0;
+    qDeleteAll(methodCallPlans);
+    methodCallPlans.clear();
 
     int pc = metaObject->propertyCount();
     int mc = metaObject->methodCount();
@@ -931,6 +935,13 @@ QQmlPropertyCacheMethodArguments *QQmlPropertyCache::createArgumentsObject(int a
     return args;
 }
 
+void QQmlPropertyCache::setMethodCallPlan(int coreIndex, QQmlMethodCallPlan *plan)
+{
+    QQmlMethodCallPlan *&entry = methodCallPlans[coreIndex];
+    delete entry;
+    entry = plan;
+}
+
 QString QQmlPropertyCache::signalParameterStringForJS(QV4::ExecutionEngine *engine, const QList<QByteArray> &parameterNameList, QString *errorString)
 {
     bool unnamedParameter = false;
@@ -60,6 +60,7 @@
 #include <private/qhashedstring_p.h>
 #include <QtCore/qvarlengtharray.h>
 #include <QtCore/qvector.h>
+#include <QtCore/qhash.h>
 
 #include <private/qv4value_p.h>
 
@@ -349,6 +350,48 @@ private:
     bool notFullyResolved() const { return _flags.notFullyResolved; }
 };
 
+// How a method is called from JavaScript. The return and parameter types are resolved on the
+// first call. Overloaded methods also remember the overload picked for the last few argument
+// signatures, see QV4::QObjectMethod.
+struct QQmlMethodCallPlan
+{
+    enum { OverloadCacheSize = 4, MaxDirectArguments = 6 };
+
+    int returnType = QMetaType::UnknownType;
+    QVector<int> parameterTypes;
+    // All types are void, int, double, bool, QString or QObject*, and can be passed without
+    // going through QVariant
+    bool direct = false;
+
+    struct Overload {
+        int argc;
+        quint32 signature;
+        QQmlPropertyData method;
+    };
+    Overload overloads[OverloadCacheSize];
+    int overloadCount = 0;
+    int nextOverload = 0;
+
+    const QQmlPropertyData *overload(int argc, quint32 signature) const
+    {
+        for (int i = 0; i < overloadCount; ++i) {
+            if (overloads[i].argc == argc && overloads[i].signature == signature)
+                return &overloads[i].method;
+        }
+        return nullptr;
+    }
+
+    void addOverload(int argc, quint32 signature, const QQmlPropertyData &method)
+    {
+        Overload &o = overloads[nextOverload];
+        o.argc = argc;
+        o.signature = signature;
+        o.method = method;
+        nextOverload = (nextOverload + 1) % OverloadCacheSize;
+        overloadCount = qMin(overloadCount + 1, int(OverloadCacheSize));
+    }
+};
+
 class QQmlPropertyCacheMethodArguments;
 class Q_QML_PRIVATE_EXPORT QQmlPropertyCache : public QQmlRefCount, public QQmlCleanup
 {
@@ -424,6 +467,9 @@ public:
     static int originalClone(QObject *, int index);
 
     QList<QByteArray> signalParameterNames(int index) const;
+
+    QQmlMethodCallPlan *methodCallPlan(int coreIndex) const { return methodCallPlans.value(coreIndex); }
+    void setMethodCallPlan(int coreIndex, QQmlMethodCallPlan *plan);
     static QString signalParameterStringForJS(QV4::ExecutionEngine *engine, const QList<QByteArray> &parameterNameList, QString *errorString = 0);
 
     const char *className() const;
@@ -515,6 +561,7 @@ private:
     QByteArray _dynamicStringData;
     QString _defaultPropertyName;
     QQmlPropertyCacheMethodArguments *argumentsCache;
+    QHash<int, QQmlMethodCallPlan *> methodCallPlans;
     int _jsFactoryMethodIndex;
     QByteArray _checksum;
 };
@@ -2903,8 +2903,17 @@ void QQmlScriptBlob::dataReceived(const Data &data)
 
     QmlIR::ScriptDirectivesCollector collector(&irUnit.jsParserEngine, &irUnit.jsGenerator);
 
+    // Code that ends up in the disk cache has to come from the JIT. Everything else can start
+    // in the interpreter while the JIT compiles it in the background. That includes resources:
+    // QQmlFile treats them as local files, but they are meant to be compiled ahead of time,
+    // so the ones that aren't are not worth a cache file.
+    const bool isResource = url().scheme() == QLatin1String("qrc");
+    const bool compileInBackground = isResource || (disableDiskCache() && !forceDiskCache())
+            || !QQmlFile::isLocalFile(url());
+
     QList<QQmlError> errors;
-    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = QV4::Script::precompile(&irUnit.jsModule, &irUnit.jsGenerator, v4, finalUrl(), source, &errors, &collector);
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = QV4::Script::precompile(&irUnit.jsModule, &irUnit.jsGenerator, v4, finalUrl(), source, &errors, &collector,
+                                                                                       compileInBackground);
     // No need to addref on unit, it's initial refcount is 1
     source.clear();
     if (!errors.isEmpty()) {
@@ -2926,7 +2935,7 @@ void QQmlScriptBlob::dataReceived(const Data &data)
     // The js unit owns the data and will free the qml unit.
     unit->data = unitData;
 
-    if (!disableDiskCache() || forceDiskCache()) {
+    if (!compileInBackground) {
         QString errorString;
         if (!unit->saveToDisk(url(), &errorString)) {
             qCDebug(DBG_DISK_CACHE()) << "Error saving cached version of" << unit->url().toString() << "to disk:" << errorString;
@@ -61,6 +61,9 @@
 #include <QtCore/qstack.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qbuffer.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsharedpointer.h>
 
 #include <private/qv4objectproto_p.h>
 #include <private/qv4scopedvalue_p.h>
@@ -988,6 +991,46 @@ void Document::method_xmlEncoding(const QV4::BuiltinFunction *, QV4::Scope &scop
     scope.result = scope.engine->newString(static_cast<DocumentImpl *>(r->d()->d)->encoding);
 }
 
+// The body of a JSON response, and the result of decoding and parsing it on a worker thread
+class QQmlJsonResponse : public QObject
+{
+    Q_OBJECT
+public:
+    QByteArray body;
+#if QT_CONFIG(textcodec)
+    QTextCodec *codec = nullptr;
+#endif
+    QV4::JsonTree tree;
+    QJsonParseError error;
+
+signals:
+    void parsed();
+};
+
+class QQmlJsonResponseParser : public QRunnable
+{
+public:
+    QQmlJsonResponseParser(const QSharedPointer<QQmlJsonResponse> &response)
+        : response(response) {}
+
+    void run() override
+    {
+        QString text;
+#if QT_CONFIG(textcodec)
+        if (response->codec)
+            text = response->codec->toUnicode(response->body);
+        else
+#endif
+            text = QString::fromUtf8(response->body);
+        response->body.clear();
+        response->tree = QV4::JsonTree::parse(text, &response->error);
+        emit response->parsed();
+    }
+
+private:
+    QSharedPointer<QQmlJsonResponse> response;
+};
+
 class QQmlXMLHttpRequest : public QObject
 {
     Q_OBJECT
@@ -1030,9 +1073,12 @@ private slots:
     void readyRead();
     void error(QNetworkReply::NetworkError);
     void finished();
+    void jsonParsed();
 
 private:
     void requestFromUrl(const QUrl &url);
+    bool parseJsonInBackground();
+    void finishResponse();
 
     State m_state;
     bool m_errorFlag;
@@ -1075,6 +1121,7 @@ private:
 
     QString m_responseType;
     QV4::PersistentValue m_parsedDocument;
+    QSharedPointer<QQmlJsonResponse> m_jsonResponse;
 };
 
 QQmlXMLHttpRequest::QQmlXMLHttpRequest(QNetworkAccessManager *manager)
@@ -1121,6 +1168,7 @@ ReturnedValue QQmlXMLHttpRequest::open(Object *thisObject, QQmlContextData *cont
     m_sendFlag = false;
     m_errorFlag = false;
     m_responseEntityBody = QByteArray();
+    m_jsonResponse.reset();
     m_method = method;
     m_url = url;
     m_request.setAttribute(QNetworkRequest::SynchronousRequestAttribute, loadType == SynchronousLoad);
@@ -1282,6 +1330,7 @@ ReturnedValue QQmlXMLHttpRequest::abort(Object *thisObject, QQmlContextData *con
 {
     destroyNetwork();
     m_responseEntityBody = QByteArray();
+    m_jsonResponse.reset();
     m_errorFlag = true;
     m_request = QNetworkRequest();
 
@@ -1419,6 +1468,16 @@ void QQmlXMLHttpRequest::finished()
         m_state = Loading;
         dispatchCallback();
     }
+
+    // Done is only reported once the JSON response is parsed
+    if (parseJsonInBackground())
+        return;
+
+    finishResponse();
+}
+
+void QQmlXMLHttpRequest::finishResponse()
+{
     m_state = Done;
 
     dispatchCallback();
@@ -1427,6 +1486,39 @@ void QQmlXMLHttpRequest::finished()
     m_qmlContext.setContextData(0);
 }
 
+bool QQmlXMLHttpRequest::parseJsonInBackground()
+{
+    // synchronous requests have to be complete when send() returns
+    if (m_request.attribute(QNetworkRequest::SynchronousRequestAttribute).toBool()
+            || m_responseType.compare(QLatin1String("json"), Qt::CaseInsensitive) != 0
+            || m_responseEntityBody.isEmpty())
+        return false;
+
+    // The response object is deleted on its own thread, even if the worker holds the last
+    // reference to it
+    m_jsonResponse = QSharedPointer<QQmlJsonResponse>(new QQmlJsonResponse, &QObject::deleteLater);
+    m_jsonResponse->body = m_responseEntityBody;
+#if QT_CONFIG(textcodec)
+    // only the codec is looked up here, the text is decoded on the worker thread
+    if (!m_textCodec)
+        m_textCodec = findTextCodec();
+    m_jsonResponse->codec = m_textCodec;
+#endif
+    QObject::connect(m_jsonResponse.data(), SIGNAL(parsed()),
+                     this, SLOT(jsonParsed()), Qt::QueuedConnection);
+    QThreadPool::globalInstance()->start(new QQmlJsonResponseParser(m_jsonResponse));
+    return true;
+}
+
+void QQmlXMLHttpRequest::jsonParsed()
+{
+    // the request may have been aborted or reopened in the meantime
+    if (!m_jsonResponse || sender() != m_jsonResponse.data())
+        return;
+
+    finishResponse();
+}
+
 
 void QQmlXMLHttpRequest::readEncoding()
 {
@@ -1469,6 +1561,20 @@ void QQmlXMLHttpRequest::setResponseType(const QString &responseType)
 
 QV4::ReturnedValue QQmlXMLHttpRequest::jsonResponseBody(QV4::ExecutionEngine* engine)
 {
+    if (m_parsedDocument.isEmpty() && m_jsonResponse && m_state == Done) {
+        // parsed on a worker thread, only the JS objects are left to create
+        QSharedPointer<QQmlJsonResponse> response;
+        response.swap(m_jsonResponse);
+        if (response->error.error != QJsonParseError::NoError)
+            return engine->throwSyntaxError(QStringLiteral("JSON.parse: Parse error"));
+
+        Scope scope(engine);
+        ScopedValue jsonObject(scope, response->tree.toValue(engine));
+        if (scope.hasException())
+            return Encode::undefined();
+        m_parsedDocument.set(scope.engine, jsonObject);
+    }
+
     if (m_parsedDocument.isEmpty()) {
         Scope scope(engine);
 
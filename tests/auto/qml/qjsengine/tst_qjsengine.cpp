@@ -63,11 +63,14 @@ private slots:
     void newArray();
     void newArray_HooliganTask218092();
     void newArray_HooliganTask233836();
+    void newArrayBuffer();
+    void typedArrayWriteSharesBuffer();
     void newVariant();
     void newVariant_valueOfToString();
     void newVariant_valueOfEnum();
     void newRegExp();
     void jsRegExp();
+    void regExpsSharedBetweenEngines();
     void newDate();
     void jsParseDate();
     void newQObject();
@@ -109,6 +112,10 @@ private slots:
     void with_constant();
     void stringObjects();
     void jsStringPrototypeReplaceBugs();
+    void concatenatedStrings();
+    void jsonParseAndStringify_data();
+    void jsonParseAndStringify();
+    void jsonStringifyFormatting();
     void getterSetterThisObject_global();
     void getterSetterThisObject_plain();
     void getterSetterThisObject_prototypeChain();
@@ -186,6 +193,14 @@ private slots:
     void engineForObject();
     void intConversion_QTBUG43309();
     void toFixed();
+    void numberToString_data();
+    void numberToString();
+    void untypedNumberOperations_data();
+    void untypedNumberOperations();
+    void functionInlining_data();
+    void functionInlining();
+    void loopOptimizations_data();
+    void loopOptimizations();
 
     void argumentEvaluationOrder();
 
@@ -436,6 +451,66 @@ void tst_QJSEngine::newArray_HooliganTask233836()
     }
 }
 
+void tst_QJSEngine::newArrayBuffer()
+{
+    QJSEngine eng;
+    QSharedPointer<QByteArray> bytes(new QByteArray("\x01\x02\x03\x04", 4));
+    QWeakPointer<QByteArray> watcher = bytes;
+
+    QJSValue buffer = eng.newArrayBuffer(bytes->constData(), bytes->size(), bytes);
+    bytes.reset();
+    QVERIFY(buffer.isObject());
+    QCOMPARE(buffer.property("byteLength").toInt(), 4);
+    QVERIFY(buffer.prototype().strictlyEquals(eng.evaluate("ArrayBuffer.prototype")));
+    QCOMPARE(buffer.toVariant().toByteArray(), QByteArray("\x01\x02\x03\x04", 4));
+
+    QJSValue sum = eng.evaluate("(function(buffer) {\n"
+                                "    var bytes = new Uint8Array(buffer);\n"
+                                "    var result = 0;\n"
+                                "    for (var i = 0; i < bytes.length; ++i)\n"
+                                "        result += bytes[i];\n"
+                                "    return result;\n"
+                                "})");
+    QCOMPARE(sum.call(QJSValueList() << buffer).toInt(), 10);
+    QVERIFY(!watcher.isNull());
+
+    // writing copies the data and releases the owner
+    eng.evaluate("(function(buffer) { new Uint8Array(buffer)[0] = 10; })").call(QJSValueList() << buffer);
+    QCOMPARE(sum.call(QJSValueList() << buffer).toInt(), 19);
+    QVERIFY(watcher.isNull());
+}
+
+class ByteArrayKeeper : public QObject
+{
+    Q_OBJECT
+public:
+    QByteArray kept;
+
+public slots:
+    void keep(const QByteArray &bytes) { kept = bytes; }
+};
+
+void tst_QJSEngine::typedArrayWriteSharesBuffer()
+{
+    ByteArrayKeeper keeper;
+    QJSEngine eng;
+    eng.globalObject().setProperty("keeper", eng.newQObject(&keeper));
+    QQmlEngine::setObjectOwnership(&keeper, QQmlEngine::CppOwnership);
+
+    // valueOf() shares the buffer with a QByteArray while the value is being converted
+    QJSValue result = eng.evaluate("var buffer = new ArrayBuffer(4);\n"
+                                   "var bytes = new Uint8Array(buffer);\n"
+                                   "bytes[0] = { valueOf: function() { keeper.keep(buffer); return 7; } };\n"
+                                   "bytes[0]");
+    QCOMPARE(result.toInt(), 7);
+    QCOMPARE(keeper.kept, QByteArray(4, '\0'));
+
+    result = eng.evaluate("bytes.set([{ valueOf: function() { keeper.keep(buffer); return 9; } }], 1);\n"
+                          "bytes[1]");
+    QCOMPARE(result.toInt(), 9);
+    QCOMPARE(keeper.kept, QByteArray("\x07\0\0\0", 4));
+}
+
 void tst_QJSEngine::newVariant()
 {
     QJSEngine eng;
@@ -556,6 +631,37 @@ void tst_QJSEngine::jsRegExp()
     QCOMPARE(r11.toString(), QString::fromLatin1("/{1.*}/g"));
 }
 
+void tst_QJSEngine::regExpsSharedBetweenEngines()
+{
+    const QString script = QStringLiteral(
+            "(function(s) {\n"
+            "    var result = s.replace(new RegExp('(\\\\w+)@(\\\\w+)', 'g'), '$2 at $1');\n"
+            "    for (var i = 0; i < 100; ++i) {\n"
+            "        if (!new RegExp('^x' + i + '$').test('x' + i))\n"
+            "            return 'mismatch for ' + i;\n"
+            "    }\n"
+            "    return result;\n"
+            "})");
+    const QJSValueList args = QJSValueList() << QStringLiteral("joe@host, ann@box");
+    const QString expected = QStringLiteral("host at joe, box at ann");
+
+    QScopedPointer<QJSEngine> first(new QJSEngine);
+    QJSEngine second;
+    QJSValue firstFunction = first->evaluate(script);
+    QJSValue secondFunction = second.evaluate(script);
+
+    QCOMPARE(firstFunction.call(args).toString(), expected);
+    QCOMPARE(secondFunction.call(args).toString(), expected);
+    first->collectGarbage();
+    QCOMPARE(firstFunction.call(args).toString(), expected);
+
+    // the second engine keeps using compiled code it shared with the first one
+    firstFunction = QJSValue();
+    first.reset();
+    second.collectGarbage();
+    QCOMPARE(secondFunction.call(args).toString(), expected);
+}
+
 void tst_QJSEngine::newDate()
 {
     QJSEngine eng;
@@ -2436,6 +2542,88 @@ void tst_QJSEngine::jsStringPrototypeReplaceBugs()
     }
 }
 
+void tst_QJSEngine::concatenatedStrings()
+{
+    QJSEngine eng;
+    // deep enough to get rebalanced a couple of times
+    {
+        QJSValue ret = eng.evaluate("var s = ''; for (var i = 0; i < 1000; ++i) s += i % 10; s");
+        QVERIFY(ret.isString());
+        QString expected;
+        for (int i = 0; i < 1000; ++i)
+            expected += QString::number(i % 10);
+        QCOMPARE(ret.toString(), expected);
+    }
+    {
+        QJSValue ret = eng.evaluate("var s = ''; for (var i = 0; i < 1000; ++i) s = (i % 10) + s; s");
+        QString expected;
+        for (int i = 0; i < 1000; ++i)
+            expected.prepend(QString::number(i % 10));
+        QCOMPARE(ret.toString(), expected);
+    }
+    // equality and hashing without flattening
+    QCOMPARE(eng.evaluate("var a = '', b = ''; for (var i = 0; i < 100; ++i) { a += 'ab'; b = b + 'a' + 'b'; } a === b").toBool(), true);
+    QCOMPARE(eng.evaluate("var c = a + 'x', d = b + 'y'; c === d").toBool(), false);
+    QCOMPARE(eng.evaluate("var o = {}; o[a] = 42; o[b]").toInt(), 42);
+    QCOMPARE(eng.evaluate("var p = { foobar: 1 }; var k = 'foo'; p[k + 'bar']").toInt(), 1);
+    // array indices
+    QCOMPARE(eng.evaluate("var arr = []; arr['1' + '2'] = 5; arr.length").toInt(), 13);
+    QCOMPARE(eng.evaluate("var big = []; big['4294967' + '295'] = 1; big.length").toInt(), 0);
+}
+
+void tst_QJSEngine::jsonParseAndStringify_data()
+{
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("output");
+
+    QTest::newRow("object") << "{\"a\":1,\"b\":\"two\"}" << "{\"a\":1,\"b\":\"two\"}";
+    QTest::newRow("duplicate keys") << "{\"a\":1,\"b\":2,\"a\":3}" << "{\"a\":3,\"b\":2}";
+    QTest::newRow("index keys") << "{\"a\":true,\"1\":\"x\"}" << "{\"1\":\"x\",\"a\":true}";
+    QTest::newRow("escaped key") << "{\"\\u0061b\":1}" << "{\"ab\":1}";
+    QTest::newRow("repeated shapes") << "[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4},{\"y\":5,\"x\":6},{\"x\":7}]"
+                                     << "[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4},{\"y\":5,\"x\":6},{\"x\":7}]";
+    QTest::newRow("nested shapes") << "[{\"a\":{\"b\":1}},{\"a\":{\"b\":2,\"c\":3}}]"
+                                   << "[{\"a\":{\"b\":1}},{\"a\":{\"b\":2,\"c\":3}}]";
+    QTest::newRow("whitespace") << " \n\t [ 1 ,\r\n        2 ,                 { \"a\" :\t3 } ]    " << "[1,2,{\"a\":3}]";
+    QTest::newRow("escapes") << "\"abcdefghijklmno\\\"pqrstuvwxyz\\\\0123456789\\u0041\\n\\t\\/\""
+                             << "\"abcdefghijklmno\\\"pqrstuvwxyz\\\\0123456789A\\n\\t/\"";
+    QTest::newRow("control characters") << "\"\\u0001 and \\u001f\"" << "\"\\u0001 and \\u001f\"";
+    QTest::newRow("non-latin") << QString::fromUtf8("\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80 long enough for a vector\"")
+                               << QString::fromUtf8("\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80 long enough for a vector\"");
+    QTest::newRow("numbers") << "[-0,7,123456789,1234567890,-33554432,33554431,1.5e3,-2.25]"
+                             << "[0,7,123456789,1234567890,-33554432,33554431,1500,-2.25]";
+    QTest::newRow("literals") << "[true,false,null]" << "[true,false,null]";
+}
+
+void tst_QJSEngine::jsonParseAndStringify()
+{
+    QFETCH(QString, input);
+    QFETCH(QString, output);
+
+    QJSEngine eng;
+    QJSValue roundTrip = eng.evaluate("(function(text) { return JSON.stringify(JSON.parse(text)); })");
+    QJSValue result = roundTrip.call(QJSValueList() << input);
+    QVERIFY(!result.isError());
+    QCOMPARE(result.toString(), output);
+}
+
+void tst_QJSEngine::jsonStringifyFormatting()
+{
+    QJSEngine eng;
+    QCOMPARE(eng.evaluate("JSON.stringify({ a: [1, {}], b: {}, c: [] }, null, 2)").toString(),
+             QString::fromLatin1("{\n  \"a\": [\n    1,\n    {}\n  ],\n  \"b\": {},\n  \"c\": []\n}"));
+    QCOMPARE(eng.evaluate("JSON.stringify({ a: undefined, b: function() {}, c: 1 })").toString(),
+             QString::fromLatin1("{\"c\":1}"));
+    QCOMPARE(eng.evaluate("JSON.stringify({ a: undefined, b: 2 }, null, '--')").toString(),
+             QString::fromLatin1("{\n--\"b\": 2\n}"));
+    QCOMPARE(eng.evaluate("JSON.stringify([undefined, function() {}, 1])").toString(),
+             QString::fromLatin1("[null,null,1]"));
+    QCOMPARE(eng.evaluate("JSON.stringify([1, [2]], function(key, value) { return key === '0' ? 'zero' : value; })").toString(),
+             QString::fromLatin1("[\"zero\",[\"zero\"]]"));
+    QVERIFY(eng.evaluate("JSON.stringify(undefined)").isUndefined());
+    QVERIFY(eng.evaluate("var cyclic = {}; cyclic.self = cyclic; JSON.stringify(cyclic)").isError());
+}
+
 void tst_QJSEngine::getterSetterThisObject_global()
 {
     {
@@ -3995,6 +4183,265 @@ void tst_QJSEngine::toFixed()
     QCOMPARE(result.toString(), QStringLiteral("12.1"));
 }
 
+void tst_QJSEngine::numberToString_data()
+{
+    QTest::addColumn<QString>("expression");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("zero") << QStringLiteral("String(0)") << QStringLiteral("0");
+    QTest::newRow("negative zero") << QStringLiteral("String(-0)") << QStringLiteral("0");
+    QTest::newRow("small integer") << QStringLiteral("String(42)") << QStringLiteral("42");
+    QTest::newRow("cached integer twice") << QStringLiteral("String(300) + String(44) + String(300)") << QStringLiteral("30044300");
+    QTest::newRow("colliding cache slots") << QStringLiteral("'' + 1 + 257 + 1") << QStringLiteral("12571");
+    QTest::newRow("negative integer") << QStringLiteral("String(-123456)") << QStringLiteral("-123456");
+    QTest::newRow("max safe integer") << QStringLiteral("String(9007199254740991)") << QStringLiteral("9007199254740991");
+    QTest::newRow("2^53") << QStringLiteral("String(9007199254740992)") << QStringLiteral("9007199254740992");
+    QTest::newRow("1e20") << QStringLiteral("String(1e20)") << QStringLiteral("100000000000000000000");
+    QTest::newRow("1e21") << QStringLiteral("String(1e21)") << QStringLiteral("1e+21");
+    QTest::newRow("fraction") << QStringLiteral("String(0.1 + 0.2)") << QStringLiteral("0.30000000000000004");
+    QTest::newRow("negative fraction") << QStringLiteral("String(-1.5)") << QStringLiteral("-1.5");
+    QTest::newRow("small fraction") << QStringLiteral("String(0.000001)") << QStringLiteral("0.000001");
+    QTest::newRow("tiny fraction") << QStringLiteral("String(1e-7)") << QStringLiteral("1e-7");
+    QTest::newRow("tiny mantissa") << QStringLiteral("String(-1.25e-7)") << QStringLiteral("-1.25e-7");
+    QTest::newRow("min value") << QStringLiteral("String(Number.MIN_VALUE)") << QStringLiteral("5e-324");
+    QTest::newRow("max value") << QStringLiteral("String(Number.MAX_VALUE)") << QStringLiteral("1.7976931348623157e+308");
+    QTest::newRow("concatenation") << QStringLiteral("'x' + 7 + 2.5") << QStringLiteral("x72.5");
+    QTest::newRow("toFixed integer") << QStringLiteral("(-5).toFixed(3)") << QStringLiteral("-5.000");
+    QTest::newRow("toFixed negative zero") << QStringLiteral("(-0).toFixed(2)") << QStringLiteral("0.00");
+    QTest::newRow("toFixed fraction") << QStringLiteral("(1.005).toFixed(2)") << QStringLiteral("1.00");
+    QTest::newRow("parse integer") << QStringLiteral("String(Number('123') + 1)") << QStringLiteral("124");
+    QTest::newRow("parse negative") << QStringLiteral("String(Number('-0') === 0 && 1 / Number('-0'))") << QStringLiteral("-Infinity");
+    QTest::newRow("parse array index") << QStringLiteral("var o = {}; o['17'] = 1; var k = Object.keys(o)[0]; String(k * 2)") << QStringLiteral("34");
+    QTest::newRow("parse lone minus") << QStringLiteral("String(Number('-'))") << QStringLiteral("NaN");
+    QTest::newRow("parse padded") << QStringLiteral("String(Number(' 12 '))") << QStringLiteral("12");
+}
+
+void tst_QJSEngine::numberToString()
+{
+    QFETCH(QString, expression);
+    QFETCH(QString, expected);
+
+    QJSEngine engine;
+    QJSValue result = engine.evaluate(expression);
+    QVERIFY(result.isString());
+    QCOMPARE(result.toString(), expected);
+}
+
+void tst_QJSEngine::untypedNumberOperations_data()
+{
+    QTest::addColumn<QString>("values");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("integers") << QStringLiteral("[0, 1, 2]")
+            << QStringLiteral("true,false,0,-Infinity,n false,true,-1,-1,p false,true,-2,-0.5,p");
+    QTest::newRow("doubles") << QStringLiteral("[0.5, 1.5, NaN]")
+            << QStringLiteral("true,false,-0.5,-2,p false,true,-1.5,-0.6666666666666666,p false,false,NaN,NaN,n");
+    QTest::newRow("strings") << QStringLiteral("['0', '10', 'a']")
+            << QStringLiteral("true,false,0,-Infinity,n false,true,-10,-0.1,p false,false,NaN,NaN,n");
+    QTest::newRow("primitives") << QStringLiteral("[null, undefined, true]")
+            << QStringLiteral("true,false,0,-Infinity,n false,false,NaN,NaN,n false,true,-1,-1,p");
+    QTest::newRow("object") << QStringLiteral("[{ valueOf: function() { return 3; } }]")
+            << QStringLiteral("false,true,-3,-0.3333333333333333,p");
+}
+
+void tst_QJSEngine::untypedNumberOperations()
+{
+    QFETCH(QString, values);
+    QFETCH(QString, expected);
+
+    // The element type is unknown at compile time, so the JIT guesses numbers and has to fall
+    // back to the generic operations for everything else.
+    qputenv("QV4_JIT_CALL_THRESHOLD", "0");
+    QJSEngine engine;
+    qunsetenv("QV4_JIT_CALL_THRESHOLD");
+    QJSValue result = engine.evaluate(QStringLiteral(
+            "(function(values) {\n"
+            "    var out = [];\n"
+            "    for (var i = 0; i < values.length; ++i) {\n"
+            "        var v = values[i];\n"
+            "        out.push([v < 1, v >= 1, -v, 1 / -v, v > 0 ? 'p' : 'n'].join());\n"
+            "    }\n"
+            "    return out.join(' ');\n"
+            "})(%1)").arg(values));
+    QCOMPARE(result.toString(), expected);
+}
+
+void tst_QJSEngine::functionInlining_data()
+{
+    QTest::addColumn<QString>("code");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("clamp") << QStringLiteral(
+            "function clamp(x, lo, hi) { return x < lo ? lo : x > hi ? hi : x; }\n"
+            "var r = [];\n"
+            "for (var i = -2; i < 4; ++i)\n"
+            "    r.push(clamp(i, 0, 2));\n"
+            "return r.join();") << QStringLiteral("0,0,0,1,2,2");
+    QTest::newRow("missing arguments") << QStringLiteral(
+            "function f(a, b) { return typeof b; }\n"
+            "return f(1);") << QStringLiteral("undefined");
+    QTest::newRow("extra arguments") << QStringLiteral(
+            "var n = 0;\n"
+            "function f(a) { return a; }\n"
+            "return f(1, ++n, ++n) + n;") << QStringLiteral("3");
+    QTest::newRow("early return") << QStringLiteral(
+            "function sign(x) { if (x < 0) return -1; if (x > 0) return 1; return 0; }\n"
+            "return [sign(-5), sign(0), sign(3)].join();") << QStringLiteral("-1,0,1");
+    QTest::newRow("locals in helper") << QStringLiteral(
+            "function sum(n) { var s = 0; for (var i = 1; i <= n; ++i) s += i; return s; }\n"
+            "var i = 100;\n"
+            "return sum(10) + i;") << QStringLiteral("155");
+    QTest::newRow("no return value") << QStringLiteral(
+            "var log = [];\n"
+            "function note(x) { log.push(x); }\n"
+            "note(1);\n"
+            "var r = note(2);\n"
+            "return log.join() + ':' + r;") << QStringLiteral("1,2:undefined");
+    QTest::newRow("outer variables") << QStringLiteral(
+            "var total = 0;\n"
+            "function add(x) { total += x; }\n"
+            "add(2);\n"
+            "add(3);\n"
+            "return total;") << QStringLiteral("5");
+    QTest::newRow("reassigned helper") << QStringLiteral(
+            "function f(x) { return x + 1; }\n"
+            "var a = f(1);\n"
+            "f = function(x) { return x * 10; };\n"
+            "return a + ',' + f(1);") << QStringLiteral("2,10");
+    QTest::newRow("exception in helper") << QStringLiteral(
+            "function check(x) { if (x < 0) throw 'negative'; return x; }\n"
+            "try {\n"
+            "    check(1);\n"
+            "    check(-1);\n"
+            "    return 'no exception';\n"
+            "} catch (e) {\n"
+            "    return e;\n"
+            "}") << QStringLiteral("negative");
+    QTest::newRow("called from nested function") << QStringLiteral(
+            "function twice(x) { return 2 * x; }\n"
+            "function apply(a) { return twice(a) + 1; }\n"
+            "return [apply(1), apply(2)].join();") << QStringLiteral("3,5");
+    QTest::newRow("recursive helper") << QStringLiteral(
+            "function fact(n) { return n <= 1 ? 1 : n * fact(n - 1); }\n"
+            "return fact(10);") << QStringLiteral("3628800");
+    QTest::newRow("global hidden in caller") << QStringLiteral(
+            "function half(x) { return Math.floor(x / 2); }\n"
+            "function g(Math) { return half(Math) + arguments.length; }\n"
+            "return g(7);") << QStringLiteral("4");
+}
+
+void tst_QJSEngine::functionInlining()
+{
+    QFETCH(QString, code);
+    QFETCH(QString, expected);
+
+    // Helpers declared in the function are inlined, and have to behave as if they were called.
+    // The JIT optimizes the inlined code further, so use it right away instead of the interpreter.
+    qputenv("QV4_JIT_CALL_THRESHOLD", "0");
+    QJSEngine engine;
+    qunsetenv("QV4_JIT_CALL_THRESHOLD");
+    QJSValue result = engine.evaluate(QStringLiteral("(function() {\n%1\n})()").arg(code));
+    QVERIFY2(!result.isError(), qPrintable(result.toString()));
+    QCOMPARE(result.toString(), expected);
+}
+
+void tst_QJSEngine::loopOptimizations_data()
+{
+    QTest::addColumn<QString>("code");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("int32 counter") << QStringLiteral(
+            "var s = 0;\n"
+            "for (var i = 0; i < 1000; ++i)\n"
+            "    s += i;\n"
+            "return s + ',' + i;") << QStringLiteral("499500,1000");
+    QTest::newRow("negative start") << QStringLiteral(
+            "var s = 0;\n"
+            "for (var i = -3; i < 2; i++)\n"
+            "    s += i;\n"
+            "return s + ',' + i;") << QStringLiteral("-5,2");
+    QTest::newRow("counter up to INT_MAX") << QStringLiteral(
+            "var n = 2147483647;\n"
+            "var s = 0;\n"
+            "for (var i = 2147483644; i < n; ++i)\n"
+            "    s += i;\n"
+            "return s + ',' + i;") << QStringLiteral("6442450935,2147483647");
+    QTest::newRow("counter past INT_MAX") << QStringLiteral(
+            "var n = 2147483649;\n"
+            "for (var i = 2147483646; i < n; ++i) {}\n"
+            "return i;") << QStringLiteral("2147483649");
+    QTest::newRow("double bound") << QStringLiteral(
+            "for (var i = 0; i < 2.5; ++i) {}\n"
+            "return i;") << QStringLiteral("3");
+    QTest::newRow("counter changed in body") << QStringLiteral(
+            "for (var i = 0; i < 10; ++i) {\n"
+            "    if (i == 2)\n"
+            "        i += 0.5;\n"
+            "}\n"
+            "return i;") << QStringLiteral("10.5");
+    QTest::newRow("invariant arithmetic") << QStringLiteral(
+            "function f(x, y) {\n"
+            "    var a = x | 0, b = y * 1.5, r = 0;\n"
+            "    for (var i = 0; i < 4; ++i)\n"
+            "        r += a * b + 1;\n"
+            "    return r;\n"
+            "}\n"
+            "return f(2, 3);") << QStringLiteral("40");
+    QTest::newRow("loop not entered") << QStringLiteral(
+            "function f(x, y) {\n"
+            "    var a = x | 0, b = y | 0, r = 0;\n"
+            "    for (var i = 0; i < b; ++i)\n"
+            "        r += a / b;\n"
+            "    return r;\n"
+            "}\n"
+            "return f(1, 0);") << QStringLiteral("0");
+    QTest::newRow("property changed in loop") << QStringLiteral(
+            "var o = { f: 1 };\n"
+            "var s = 0;\n"
+            "for (var i = 0; i < 3; ++i) {\n"
+            "    s += o.f * 2;\n"
+            "    o.f++;\n"
+            "}\n"
+            "return s;") << QStringLiteral("12");
+    QTest::newRow("getter in loop") << QStringLiteral(
+            "var n = 0;\n"
+            "var o = { get v() { return ++n; } };\n"
+            "var s = 0;\n"
+            "for (var i = 0; i < 3; ++i)\n"
+            "    s += o.v;\n"
+            "return s;") << QStringLiteral("6");
+    QTest::newRow("array shrinks in loop") << QStringLiteral(
+            "var a = [1, 2, 3, 4];\n"
+            "var s = 0;\n"
+            "for (var i = 0; i < a.length; ++i) {\n"
+            "    s += a[i];\n"
+            "    if (i == 1)\n"
+            "        a.pop();\n"
+            "}\n"
+            "return s;") << QStringLiteral("6");
+}
+
+void tst_QJSEngine::loopOptimizations()
+{
+    QFETCH(QString, code);
+    QFETCH(QString, expected);
+
+    // Loop counters are narrowed to int32 and invariant code is moved out of loops, neither of
+    // which may change the outcome. Both tiers do this, so run the code in the interpreter and
+    // with everything JIT compiled right away.
+    const char *thresholds[] = { "1000000", "0" };
+    for (const char *threshold : thresholds) {
+        qputenv("QV4_JIT_CALL_THRESHOLD", threshold);
+        QJSEngine engine;
+        qunsetenv("QV4_JIT_CALL_THRESHOLD");
+        QJSValue result = engine.evaluate(QStringLiteral("(function() {\n%1\n})()").arg(code));
+        const QString tier = QLatin1String(*threshold == '0' ? "JIT" : "interpreter");
+        QVERIFY2(!result.isError(), qPrintable(tier + QLatin1String(": ") + result.toString()));
+        QVERIFY2(result.toString() == expected,
+                 qPrintable(tier + QLatin1String(": ") + result.toString() + QLatin1String(" != ") + expected));
+    }
+}
+
 void tst_QJSEngine::argumentEvaluationOrder()
 {
     QJSEngine engine;
@@ -0,0 +1,31 @@
+import Qt.test 1.0
+
+MySequenceConversionObject {
+    id: msco
+
+    property var list
+
+    function grab() {
+        list = msco.intListProperty;
+    }
+
+    function sum() {
+        var result = 0;
+        for (var i = 0; i < list.length; ++i)
+            result += list[i];
+        return result;
+    }
+
+    function write(index, value) {
+        list[index] = value;
+    }
+
+    function bulk() {
+        var weighted = 0;
+        list.forEach(function(value, index, sequence) {
+            if (sequence === list)
+                weighted += value * index;
+        });
+        return weighted + ":" + list.slice(1, -1).join(",") + ":" + list.slice(-2).length;
+    }
+}
@@ -196,6 +196,7 @@ private slots:
     void sequenceConversionThreads();
     void sequenceConversionBindings();
     void sequenceConversionCopy();
+    void sequenceConversionCached();
     void assignSequenceTypes();
     void sequenceSort_data();
     void sequenceSort();
@@ -262,6 +263,7 @@ private slots:
     void nonNotifyable();
     void deleteWhileBindingRunning();
     void callQtInvokables();
+    void callQtInvokablesRepeatedly();
     void resolveClashingProperties();
     void invokableObjectArg();
     void invokableObjectRet();
@@ -2993,6 +2995,82 @@ void tst_qqmlecmascript::callQtInvokables()
     QVERIFY(callback.isCallable());
 }
 
+// Repeated calls go through the cached call plans and overloads of the property cache
+void tst_qqmlecmascript::callQtInvokablesRepeatedly()
+{
+    MyInvokableObject o;
+
+    QQmlEngine qmlengine;
+    QQmlEnginePrivate *ep = QQmlEnginePrivate::get(&qmlengine);
+
+    QV8Engine *engine = ep->v8engine();
+    QV4::Scope scope(QV8Engine::getV4(engine));
+
+    QV4::ScopedValue object(scope, QV4::QObjectWrapper::wrap(QV8Engine::getV4(engine), &o));
+    QQmlEngine::setObjectOwnership(&o, QQmlEngine::CppOwnership);
+
+    for (int i = 0; i < 3; ++i) {
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_overload(10)", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 16);
+        QCOMPARE(o.actuals(), QVariantList() << 10);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_overload(\"Hello\")", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 18);
+        QCOMPARE(o.actuals(), QVariantList() << QString("Hello"));
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_overload(10, 11)", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 17);
+        QCOMPARE(o.actuals(), QVariantList() << 10 << 11);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_overload(null)", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 27);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_overload({foo:123})", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 25);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_int(10.7)", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 8);
+        QCOMPARE(o.actuals(), QVariantList() << 10);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_real(\"19.5\")", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 10);
+        QCOMPARE(o.actuals(), QVariantList() << 19.5);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_QString(undefined)", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 11);
+        QCOMPARE(o.actuals(), QVariantList() << QString());
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_QObject(object)", QV4::Primitive::undefinedValue()));
+        QCOMPARE(o.invoked(), 13);
+        QCOMPARE(o.actuals(), QVariantList() << qVariantFromValue(static_cast<QObject *>(&o)));
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_NoArgs_int()", QV4::Primitive::fromInt32(6)));
+        QCOMPARE(o.invoked(), 1);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_NoArgs_real()", QV4::Primitive::fromDouble(19.75)));
+        QCOMPARE(o.invoked(), 2);
+
+        o.reset();
+        QVERIFY(EVALUATE_VALUE("object.method_NoArgs_QObject() === object", QV4::Primitive::fromBoolean(true)));
+        QCOMPARE(o.invoked(), 4);
+
+        o.reset();
+        QVERIFY(EVALUATE_ERROR("object.method_intint(10)"));
+        QCOMPARE(o.invoked(), -1);
+    }
+}
+
 void tst_qqmlecmascript::resolveClashingProperties()
 {
     ClashingNames *o = new ClashingNames();
@@ -5668,6 +5746,33 @@ void tst_qqmlecmascript::sequenceConversionCopy()
     delete object;
 }
 
+void tst_qqmlecmascript::sequenceConversionCached()
+{
+    QQmlComponent component(&engine, testFileUrl("sequenceConversion.cached.qml"));
+    QScopedPointer<MySequenceConversionObject> object(qobject_cast<MySequenceConversionObject *>(component.create()));
+    QVERIFY(object);
+
+    auto call = [&](const char *method) {
+        QVariant result;
+        QMetaObject::invokeMethod(object.data(), method, Q_RETURN_ARG(QVariant, result));
+        return result;
+    };
+
+    object->setIntListProperty(QList<int>() << 1 << 2 << 3);
+    call("grab");
+    QCOMPARE(call("sum").toInt(), 6);
+
+    // changes from C++ are picked up through the NOTIFY signal
+    object->setIntListProperty(QList<int>() << 1 << 2 << 3 << 4);
+    QCOMPARE(call("sum").toInt(), 10);
+
+    QMetaObject::invokeMethod(object.data(), "write", Q_ARG(QVariant, 0), Q_ARG(QVariant, 10));
+    QCOMPARE(object->intListProperty(), (QList<int>() << 10 << 2 << 3 << 4));
+    QCOMPARE(call("sum").toInt(), 19);
+
+    QCOMPARE(call("bulk").toString(), QStringLiteral("20:2,3:2"));
+}
+
 void tst_qqmlecmascript::assignSequenceTypes()
 {
     // test binding array to sequence type property
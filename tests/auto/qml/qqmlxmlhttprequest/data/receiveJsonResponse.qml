@@ -0,0 +1,27 @@
+import QtQuick 2.0
+
+QtObject {
+    property string url
+    property string expected
+    property bool result: false
+
+    Component.onCompleted: {
+        var request = new XMLHttpRequest();
+        request.open("GET", url, true);
+        request.responseType = "json";
+
+        request.onreadystatechange = function() {
+            if (request.readyState == XMLHttpRequest.DONE) {
+                var jsonData;
+                try {
+                    jsonData = JSON.stringify(request.response);
+                } catch (e) {
+                    jsonData = e.name;
+                }
+                result = (expected == jsonData);
+            }
+        }
+
+        request.send(null);
+    }
+}
@@ -85,6 +85,8 @@ private slots:
     void getAllResponseHeaders_args();
     void getBinaryData();
     void getJsonData();
+    void getJsonResponse_data();
+    void getJsonResponse();
     void status();
     void status_data();
     void statusText();
@@ -887,6 +889,42 @@ void tst_qqmlxmlhttprequest::getJsonData()
     QTRY_VERIFY(object->property("result").toBool());
 }
 
+void tst_qqmlxmlhttprequest::getJsonResponse_data()
+{
+    QTest::addColumn<QString>("body");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("ordered keys") << QStringLiteral("json_ordered.data")
+        << QString::fromUtf8("{\"z\":1,\"a\":[true,false,null,-1500,\"\xc3\xa9\\n\"],\"m\":{\"2\":\"x\",\"b\":{}}}");
+    QTest::newRow("records") << QStringLiteral("json_records.data")
+        << QStringLiteral("[{\"a\":1,\"b\":2},{\"a\":3,\"b\":4},{\"b\":5,\"a\":6},{\"a\":8}]");
+    QTest::newRow("utf-16") << QStringLiteral("json_utf16.data")
+        << QString::fromUtf8("{\"2\":[\"two\"],\"k\":\"\xc3\xa9\"}");
+    QTest::newRow("invalid") << QStringLiteral("json_invalid.data") << QStringLiteral("SyntaxError");
+}
+
+// JSON responses are parsed on a worker thread before the request is done
+void tst_qqmlxmlhttprequest::getJsonResponse()
+{
+    QFETCH(QString, body);
+    QFETCH(QString, expected);
+
+    TestHTTPServer server;
+    QVERIFY2(server.listen(), qPrintable(server.errorString()));
+    QVERIFY(server.wait(testFileUrl("receive_json_data.expect"),
+                        testFileUrl("receive_binary_data.reply"),
+                        testFileUrl(body)));
+
+    QQmlComponent component(&engine, testFileUrl("receiveJsonResponse.qml"));
+    QScopedPointer<QObject> object(component.beginCreate(engine.rootContext()));
+    QVERIFY(!object.isNull());
+    object->setProperty("url", server.urlString("/json.data"));
+    object->setProperty("expected", expected);
+    component.completeCreate();
+
+    QTRY_VERIFY(object->property("result").toBool());
+}
+
 void tst_qqmlxmlhttprequest::status()
 {
     QFETCH(QUrl, replyUrl);
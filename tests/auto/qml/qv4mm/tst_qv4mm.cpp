@@ -28,7 +28,35 @@
 
 #include <qtest.h>
 #include <QQmlEngine>
+#include <QQmlComponent>
+#include <QQmlContext>
 #include <private/qv4mm_p.h>
+#include <private/qv8engine_p.h>
+#include <private/qjsengine_p.h>
+
+class TemporaryStringProbe : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString text READ text NOTIFY textChanged)
+    Q_PROPERTY(int arena READ arena CONSTANT)
+public:
+    TemporaryStringProbe(QV4::MemoryManager *mm) : mm(mm) {}
+
+    QString text() const { return m_text; }
+    void setText(const QString &text) { m_text = text; emit textChanged(); }
+
+    // records how much of the arena the binding evaluating this has used so far
+    int arena() { largestArena = qMax(largestArena, mm->temporaryMem()); return 0; }
+
+    size_t largestArena = 0;
+
+signals:
+    void textChanged();
+
+private:
+    QV4::MemoryManager *mm;
+    QString m_text;
+};
 
 class tst_qv4mm : public QObject
 {
@@ -37,6 +65,14 @@ class tst_qv4mm : public QObject
 private slots:
     void gcStats();
     void tweaks();
+    void incrementalMarking();
+    void lazySweep();
+    void nursery();
+    void parallelMarking();
+    void pacingPolicy();
+    void releaseFreeMemory();
+    void temporaryStrings();
+    void jsonParseDuringGC();
 };
 
 void tst_qv4mm::gcStats()
@@ -53,6 +89,275 @@ void tst_qv4mm::tweaks()
     QQmlEngine engine;
 }
 
+void tst_qv4mm::incrementalMarking()
+{
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+    mm->setIncrementalMarkingSliceBudget(1);
+    QCOMPARE(mm->incrementalMarkingSliceBudget(), qint64(1));
+
+    // Keep mutating a large object graph while collections are running in the
+    // background, and check that no reachable object got lost on the way.
+    const uint collectionsBefore = mm->collectionCount();
+    QJSValue result = engine.evaluate(
+                "var list = null;\n"
+                "for (var i = 0; i < 100000; ++i) {\n"
+                "    list = { next: list, index: i, text: 'item' + i, data: [i, i + 1] };\n"
+                "    if (i % 3 == 0) list.next = { next: list.next, index: -1, text: '', data: [] };\n"
+                "}\n"
+                "var ok = true;\n"
+                "for (var j = 99999, it = list; it; it = it.next) {\n"
+                "    if (it.index < 0) continue;\n"
+                "    if (it.index !== j || it.text !== 'item' + j || it.data[1] !== j + 1) ok = false;\n"
+                "    --j;\n"
+                "}\n"
+                "ok && j === -1;\n");
+    QVERIFY(!result.isError());
+    QVERIFY(result.toBool());
+
+    // the allocations started cycles, which were marked in slices between them
+    QVERIFY(mm->collectionCount() > collectionsBefore);
+    QVERIFY(mm->lastGCCycleStats().nSlices > 1);
+    QVERIFY(mm->lastGCCycleStats().longestPause <= mm->lastGCCycleStats().totalPause);
+
+    engine.collectGarbage();
+    QVERIFY(!mm->isIncrementalMarkingInProgress());
+}
+
+void tst_qv4mm::lazySweep()
+{
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+
+    QJSValue result = engine.evaluate(
+                "var keep = [];\n"
+                "for (var i = 0; i < 100000; ++i) {\n"
+                "    var o = { index: i, text: 'item' + i };\n"
+                "    if (i % 10 == 0) keep.push(o);\n"
+                "}\n"
+                "keep.length;\n");
+    QCOMPARE(result.toInt(), 10000);
+
+    // a collection that isn't forced leaves the sweeping to the allocator
+    mm->runGC();
+    QVERIFY(mm->blockAllocator.hasPendingSweep());
+    const size_t usedSlots = mm->blockAllocator.usedSlotsAfterLastSweep;
+
+    mm->blockAllocator.finishSweep();
+    QVERIFY(!mm->blockAllocator.hasPendingSweep());
+    size_t usedSlotsAfterSweep = 0;
+    for (QV4::Chunk *c : mm->blockAllocator.chunks)
+        usedSlotsAfterSweep += c->nUsedSlots();
+    QCOMPARE(usedSlotsAfterSweep, usedSlots);
+
+    result = engine.evaluate("var sum = 0; for (var i = 0; i < keep.length; ++i) sum += keep[i].index; sum;");
+    QCOMPARE(result.toNumber(), 499950000.);
+}
+
+void tst_qv4mm::nursery()
+{
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+    mm->setNurserySize(256*1024);
+    QCOMPARE(mm->nurserySize(), size_t(256*1024));
+
+    engine.evaluate("var old = []; for (var i = 0; i < 1000; ++i) old.push({ young: null });");
+    mm->runGC(/*forceFullCollection*/ true);
+
+    // Old objects pointing to young ones are only found through the write barrier
+    // in a minor collection.
+    bool sawMinorCollection = false;
+    for (int round = 0; round < 20; ++round) {
+        QJSValue result = engine.evaluate(QString::fromLatin1(
+                "for (var i = 0; i < old.length; ++i) {\n"
+                "    var garbage = [];\n"
+                "    for (var j = 0; j < 20; ++j) garbage.push('tmp' + j + i);\n"
+                "    old[i].young = { round: %1, text: 'young' + i };\n"
+                "}\n"
+                "var ok = true;\n"
+                "for (var i = 0; i < old.length; ++i)\n"
+                "    ok = ok && old[i].young.round === %1 && old[i].young.text === 'young' + i;\n"
+                "ok;\n").arg(round));
+        QVERIFY(result.toBool());
+        mm->runGC();
+        sawMinorCollection |= mm->lastGCCycleStats().minorCollection;
+        QVERIFY(mm->nursery.chunks.size() <= 4);
+    }
+    QVERIFY(sawMinorCollection);
+}
+
+void tst_qv4mm::parallelMarking()
+{
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+    mm->setMarkingThreadCount(4);
+
+    // a wide tree to keep all threads busy, and a long list that can't be split up
+    engine.evaluate("function makeTree(depth) {\n"
+                    "    if (!depth) return { leaf: 'leaf' };\n"
+                    "    var children = [];\n"
+                    "    for (var i = 0; i < 8; ++i) children.push(makeTree(depth - 1));\n"
+                    "    return { children: children };\n"
+                    "}\n"
+                    "function countLeaves(node) {\n"
+                    "    if (!node.children) return node.leaf === 'leaf' ? 1 : 0;\n"
+                    "    var n = 0;\n"
+                    "    for (var i = 0; i < node.children.length; ++i) n += countLeaves(node.children[i]);\n"
+                    "    return n;\n"
+                    "}\n"
+                    "var tree = makeTree(5);\n"
+                    "var list = null;\n"
+                    "for (var i = 0; i < 20000; ++i) list = { next: list, value: i };\n");
+
+    for (int i = 0; i < 3; ++i) {
+        engine.evaluate("for (var i = 0; i < 10000; ++i) var garbage = { value: 'garbage' + i };");
+        mm->runGC(/*forceFullCollection*/ true);
+        QCOMPARE(mm->lastGCCycleStats().markingThreads, uint(mm->markingThreadCount()));
+    }
+
+    QCOMPARE(engine.evaluate("countLeaves(tree)").toInt(), 8*8*8*8*8);
+    QCOMPARE(engine.evaluate("var n = 0; for (var l = list; l; l = l.next) ++n; n").toInt(), 20000);
+}
+
+void tst_qv4mm::pacingPolicy()
+{
+    const char *churn = "for (var i = 0; i < 200000; ++i) var garbage = { a: i, b: i + 1, c: [i, i] };";
+    const size_t limit = 4*1024*1024;
+
+    QV4::GCPacingPolicy policy;
+    policy.targetHeapSize = 32*1024*1024;
+    policy.growthFactor = 8;
+
+    {
+        QJSEngine engine;
+        QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+        QJSEnginePrivate::setGCPacingPolicy(&engine, policy);
+        QCOMPARE(QJSEnginePrivate::gcPacingPolicy(&engine).targetHeapSize, policy.targetHeapSize);
+        engine.evaluate(churn);
+        QVERIFY(mm->heapSize() > 2*limit);
+    }
+
+    policy.maxHeapSize = limit;
+    {
+        QJSEngine engine;
+        QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+        QJSEnginePrivate::setGCPacingPolicy(&engine, policy);
+        engine.evaluate(churn);
+        QVERIFY(mm->heapSize() < 2*limit);
+    }
+
+    // Live data beyond the limit lets the heap grow in proportion to it, instead of collecting
+    // whenever the heap needs another chunk
+    policy.growthFactor = 2;
+    {
+        QJSEngine engine;
+        QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+        QJSEnginePrivate::setGCPacingPolicy(&engine, policy);
+        engine.evaluate("var live = [];\n"
+                        "for (var i = 0; i < 100000; ++i) live.push({ a: i, b: [i] });\n");
+        mm->runGC(/*forceFullCollection*/ true);
+        QVERIFY(mm->getUsedMem() > limit);
+
+        const uint collectionsBefore = mm->collectionCount();
+        engine.evaluate(churn);
+        QVERIFY(mm->collectionCount() - collectionsBefore < 50);
+        QCOMPARE(engine.evaluate("live[99999].b[0]").toInt(), 99999);
+    }
+}
+
+void tst_qv4mm::releaseFreeMemory()
+{
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+
+    // keep a few objects spread all over the heap alive
+    engine.evaluate("var all = [];\n"
+                    "for (var i = 0; i < 100000; ++i) all.push({ value: i });\n"
+                    "var kept = [];\n"
+                    "for (var i = 0; i < all.length; i += 50) kept.push(all[i]);\n"
+                    "all = null;\n");
+    mm->runGC(/*forceFullCollection*/ true);
+
+    const size_t allocatedBefore = mm->getAllocatedMem();
+    const qreal fragmentationBefore = mm->fragmentationRatio();
+    QVERIFY(fragmentationBefore > 0.5);
+
+    const size_t released = mm->releaseFreeMemory();
+    QVERIFY(released > 0);
+    QCOMPARE(mm->getAllocatedMem(), allocatedBefore - released);
+    QVERIFY(mm->fragmentationRatio() < fragmentationBefore);
+
+    // sparse chunks are taken back into use once the allocator runs out of space
+    QJSValue result = engine.evaluate("var more = [];\n"
+                                      "for (var i = 0; i < 50000; ++i) more.push({ value: -i });\n"
+                                      "var ok = true;\n"
+                                      "for (var i = 0; i < kept.length; ++i) ok = ok && kept[i].value === i*50;\n"
+                                      "for (var i = 0; i < more.length; ++i) ok = ok && more[i].value === -i;\n"
+                                      "ok");
+    QVERIFY(result.toBool());
+
+    engine.evaluate("kept = null; more = null;");
+    mm->runGC(/*forceFullCollection*/ true);
+    mm->releaseFreeMemory();
+    QVERIFY(mm->getAllocatedMem() < allocatedBefore);
+}
+
+void tst_qv4mm::temporaryStrings()
+{
+    QQmlEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+    TemporaryStringProbe probe(mm);
+    engine.rootContext()->setContextProperty("probe", &probe);
+
+    QQmlComponent component(&engine);
+    component.setData("import QtQml 2.0\n"
+                      "QtObject {\n"
+                      "    property string label: '<' + probe.text + ':' + probe.text.length + '>' + probe.arena\n"
+                      "    property var kept: '<' + probe.text + '>'\n"
+                      "}", QUrl());
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY(object);
+
+    for (int i = 0; i < 1000; ++i) {
+        const QString text = QString::number(i);
+        probe.setText(text);
+        QCOMPARE(object->property("label").toString(), QString("<%1:%2>0").arg(text).arg(text.length()));
+        // nothing is left in the arena once the bindings have been written
+        QCOMPARE(mm->temporaryMem(), size_t(0));
+        if (i % 100 == 0)
+            engine.collectGarbage();
+    }
+    QVERIFY(probe.largestArena > 0);
+
+    // the var property keeps the JS string itself, so that had to go to the GC heap
+    engine.collectGarbage();
+    QCOMPARE(object->property("kept").toString(), QString("<999>"));
+}
+
+void tst_qv4mm::jsonParseDuringGC()
+{
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+
+    // Collect on every allocation, so that the keys of an object have to survive the
+    // collections run while its values are parsed. Array index keys are not identifiers.
+    mm->aggressiveGC = true;
+    QJSValue result = engine.evaluate(
+                "var text = '{\"2\": \"two\", \"a\": [\"x\", \"y\"], \"10\": {\"1\": \"one\", \"b\": \"bee\"}, \"c\": \"see\"}';\n"
+                "var ok = true;\n"
+                "for (var i = 0; i < 10; ++i) {\n"
+                "    var o = JSON.parse(text);\n"
+                "    if (o[2] !== 'two' || o.a[1] !== 'y' || o[10][1] !== 'one' || o[10].b !== 'bee' || o.c !== 'see')\n"
+                "        ok = false;\n"
+                "    if (Object.keys(o).join() !== '2,10,a,c')\n"
+                "        ok = false;\n"
+                "}\n"
+                "ok;\n");
+    mm->aggressiveGC = false;
+    QVERIFY(!result.isError());
+    QVERIFY(result.toBool());
+}
+
 QTEST_MAIN(tst_qv4mm)
 
 #include "tst_qv4mm.moc"
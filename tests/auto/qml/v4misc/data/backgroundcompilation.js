@@ -0,0 +1,8 @@
+.pragma library
+
+function sum(n) {
+    var s = 0;
+    for (var i = 1; i <= n; ++i)
+        s += i;
+    return s;
+}
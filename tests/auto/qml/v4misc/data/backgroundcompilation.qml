@@ -0,0 +1,8 @@
+import QtQml 2.0
+import "backgroundcompilation.js" as Script
+
+QtObject {
+    function compute(n) {
+        return Script.sum(n);
+    }
+}
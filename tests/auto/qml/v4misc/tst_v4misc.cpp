@@ -30,6 +30,18 @@
 
 #define V4_AUTOTEST
 #include <private/qv4ssa_p.h>
+#include <private/qv4codegen_p.h>
+#include <private/qqmljsengine_p.h>
+#include <private/qqmljslexer_p.h>
+#include <private/qqmljsparser_p.h>
+#include <private/qv4identifiertable_p.h>
+#include <private/qv8engine_p.h>
+#include <private/qv4arraybuffer_p.h>
+#include <private/qv4internalclass_p.h>
+#include <private/qv4tieredcompiler_p.h>
+#include <QtQml/qjsengine.h>
+#include <QtQml/qqmlengine.h>
+#include <QtQml/qqmlcomponent.h>
 
 class tst_v4misc: public QObject
 {
@@ -44,6 +56,23 @@ private slots:
 
     void moveMapping_1();
     void moveMapping_2();
+
+    void functionInlining_data();
+    void functionInlining();
+
+    void sharedIdentifiers();
+
+    void polymorphicLookups_data();
+    void polymorphicLookups();
+
+    void externalArrayBuffers();
+
+    void packedArrays();
+    void densifySparseArrays();
+
+    void internalClassTransitions();
+    void tieredCompilation();
+    void backgroundScriptCompilation();
 };
 
 QT_BEGIN_NAMESPACE
@@ -231,6 +260,504 @@ void tst_v4misc::moveMapping_2()
     QVERIFY(mapping._moves.at(9).needsSwap);
 }
 
+void tst_v4misc::functionInlining_data()
+{
+    QTest::addColumn<QString>("code");
+    QTest::addColumn<int>("inlinedCalls");
+
+    QTest::newRow("nested helper") << QStringLiteral(
+            "function outer(a) { function square(x) { return x * x; } return square(a) + square(a + 1); }") << 2;
+    QTest::newRow("helper using outer variables") << QStringLiteral(
+            "function outer(a) {\n"
+            "    var k = 3;\n"
+            "    function scale(x) { return x * k; }\n"
+            "    function add(x, y) { return scale(x) + y; }\n"
+            "    return add(a, 1) + scale(a);\n"
+            "}") << 2;
+    QTest::newRow("recursive helper") << QStringLiteral(
+            "function outer(n) { function fact(n) { return n <= 1 ? 1 : n * fact(n - 1); } return fact(n); }") << 1;
+    QTest::newRow("reassigned helper") << QStringLiteral(
+            "function outer(a) { function f(x) { return x + 1; } if (a) f = Math.abs; return f(a); }") << 0;
+    QTest::newRow("reassigned in nested function") << QStringLiteral(
+            "function outer(a) { function f(x) { return x + 1; } function g() { f = null; } return [g, f(a)]; }") << 0;
+    QTest::newRow("eval in owner") << QStringLiteral(
+            "function outer(a) { function f(x) { return x; } eval('f = null'); return f(a); }") << 0;
+    QTest::newRow("with in owner") << QStringLiteral(
+            "function outer(o) { function f(x) { return x; } with (o) { f = null; } return f(1); }") << 0;
+    QTest::newRow("uses this") << QStringLiteral(
+            "function outer(a) { function f() { return this; } return f(); }") << 0;
+    QTest::newRow("uses arguments") << QStringLiteral(
+            "function outer(a) { function f() { return arguments.length; } return f(a); }") << 0;
+    QTest::newRow("strict helper") << QStringLiteral(
+            "function outer(a) { function f(x) { 'use strict'; return x; } return f(a); }") << 0;
+    QTest::newRow("global hidden by formal") << QStringLiteral(
+            "function outer(a) { function half(x) { return Math.floor(x / 2); } function g(Math) { return half(Math) + arguments.length; } return g(a) + half(a); }") << 1;
+    QTest::newRow("global hidden by local") << QStringLiteral(
+            "function outer(a) { function half(x) { return Math.floor(x / 2); } function g(x) { var Math = 0; return half(x) + arguments.length; } return g(a); }") << 0;
+    QTest::newRow("global function") << QStringLiteral(
+            "function f(x) { return x; } f(1);") << 0;
+    QTest::newRow("big helper") << QStringLiteral(
+            "function outer(a) { function f(x) { %1return x; } return f(a); }").arg(QStringLiteral("x = x * 2 + 1; ").repeated(30)) << 0;
+}
+
+void tst_v4misc::functionInlining()
+{
+    QFETCH(QString, code);
+    QFETCH(int, inlinedCalls);
+
+    QQmlJS::Engine ee;
+    QQmlJS::Lexer lexer(&ee);
+    lexer.setCode(code, /*line*/1, /*qml mode*/false);
+    QQmlJS::Parser parser(&ee);
+    QVERIFY(parser.parseProgram());
+
+    Module module(/*debugMode*/false);
+    QQmlJS::Codegen cg(/*strict mode*/false);
+    cg.generateFromProgram(QStringLiteral("inlining.js"), code, QQmlJS::AST::cast<QQmlJS::AST::Program *>(parser.rootNode()),
+                           &module, QQmlJS::Codegen::GlobalCode);
+    QVERIFY(cg.qmlErrors().isEmpty());
+
+    QCOMPARE(Optimizer::inlineFunctionCalls(&module), inlinedCalls);
+}
+
+void tst_v4misc::sharedIdentifiers()
+{
+    QV4::SharedIdentifierTable::setEnabled(true);
+    {
+        QJSEngine first;
+        QJSEngine second;
+        QV4::IdentifierTable *firstTable = QV8Engine::getV4(&first)->identifierTable;
+        QV4::IdentifierTable *secondTable = QV8Engine::getV4(&second)->identifierTable;
+        QV4::SharedIdentifierTable *shared = QV4::SharedIdentifierTable::instance();
+        QVERIFY(shared);
+        QCOMPARE(firstTable->sharedTable(), shared);
+
+        const QString script = QStringLiteral("var sharedObject = { sharedProperty: 1 }; sharedObject.sharedProperty");
+        QCOMPARE(first.evaluate(script).toInt(), 1);
+        QCOMPARE(second.evaluate(script).toInt(), 1);
+
+        // names from the compiled code are shared
+        QV4::Identifier *identifier = firstTable->identifier(QStringLiteral("sharedProperty"));
+        QVERIFY(identifier);
+        QVERIFY(shared->contains(identifier));
+        QCOMPARE(secondTable->identifier(QStringLiteral("sharedProperty")), identifier);
+        QCOMPARE(secondTable->identifier("sharedProperty", 14), identifier);
+        QCOMPARE(secondTable->stringFromIdentifier(identifier)->toQString(), QStringLiteral("sharedProperty"));
+        QCOMPARE(second.evaluate("Object.keys(sharedObject).join()").toString(), QStringLiteral("sharedProperty"));
+
+        // others stay with the engine that created them
+        QV4::Identifier *local = firstTable->identifier(QStringLiteral("onlyInFirst"));
+        QVERIFY(local);
+        QVERIFY(!shared->contains(local));
+        QVERIFY(secondTable->identifier(QStringLiteral("onlyInFirst")) != local);
+        QCOMPARE(firstTable->identifier(QStringLiteral("onlyInFirst")), local);
+
+        // array indices never become identifiers
+        QVERIFY(!firstTable->identifier(QStringLiteral("42")));
+
+        // string literals that aren't names aren't kept for the whole process
+        QCOMPARE(first.evaluate("var literal = 'not a name'; literal").toString(), QStringLiteral("not a name"));
+        const QString literal = QStringLiteral("not a name");
+        QVERIFY(!shared->lookup(literal, QV4::String::createHashValue(literal.constData(), literal.length(), nullptr)));
+
+        // the table grows without moving the identifiers it has already handed out
+        const int sizeBefore = shared->size();
+        for (int i = 0; i < 1000; ++i)
+            first.evaluate(QStringLiteral("var growName%1 = 1").arg(i));
+        QVERIFY(shared->size() >= sizeBefore + 1000);
+        QCOMPARE(secondTable->identifier(QStringLiteral("sharedProperty")), identifier);
+        QVERIFY(shared->contains(secondTable->identifier(QStringLiteral("growName999"))));
+    }
+    QV4::SharedIdentifierTable::setEnabled(false);
+    QVERIFY(!QV4::SharedIdentifierTable::instance());
+}
+
+void tst_v4misc::polymorphicLookups_data()
+{
+    QTest::addColumn<int>("shapes");
+    QTest::addColumn<int>("megamorphicLookups");
+
+    QTest::newRow("2 shapes") << 2 << 0;
+    QTest::newRow("6 shapes") << 6 << 0;
+    QTest::newRow("8 shapes") << 8 << 0;
+    // the getter in sum(), and the getter and setter in update()
+    QTest::newRow("16 shapes") << 16 << 3;
+}
+
+void tst_v4misc::polymorphicLookups()
+{
+    QFETCH(int, shapes);
+    QFETCH(int, megamorphicLookups);
+
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+
+    // Every object has a different shape, some of them find value on their prototype
+    engine.evaluate(QStringLiteral(
+            "function makeObjects(shapes) {\n"
+            "    var objects = [];\n"
+            "    var proto = { value: -1 };\n"
+            "    for (var i = 0; i < shapes; ++i) {\n"
+            "        var o = i % 3 ? {} : Object.create(proto);\n"
+            "        o['padding' + i] = i;\n"
+            "        if (i % 3)\n"
+            "            o.value = i;\n"
+            "        objects.push(o);\n"
+            "    }\n"
+            "    return objects;\n"
+            "}\n"
+            "function sum(objects) {\n"
+            "    var result = 0;\n"
+            "    for (var i = 0; i < objects.length; ++i)\n"
+            "        result += objects[i].value;\n"
+            "    return result;\n"
+            "}\n"
+            "function update(objects) {\n"
+            "    for (var i = 0; i < objects.length; ++i) {\n"
+            "        if (i % 3)\n"
+            "            objects[i].value = objects[i].value + 1;\n"
+            "    }\n"
+            "}\n"
+            "function count(values) {\n"
+            "    var result = 0;\n"
+            "    for (var i = 0; i < values.length; ++i) {\n"
+            "        if (values[i].value !== undefined)\n"
+            "            ++result;\n"
+            "    }\n"
+            "    return result;\n"
+            "}\n"));
+
+    QJSValue objects = engine.globalObject().property("makeObjects").call(QJSValueList() << shapes);
+    QJSValue sum = engine.globalObject().property("sum");
+    QJSValue update = engine.globalObject().property("update");
+
+    int expected = 0;
+    for (int i = 0; i < shapes; ++i)
+        expected += (i % 3) ? i : -1;
+
+    for (int round = 0; round < 3; ++round) {
+        QCOMPARE(sum.call(QJSValueList() << objects).toInt(), expected);
+        update.call(QJSValueList() << objects);
+        for (int i = 0; i < shapes; ++i) {
+            if (i % 3)
+                ++expected;
+        }
+    }
+    QCOMPARE(v4->nMegamorphicLookups, megamorphicLookups);
+
+    // primitive receivers don't change the state of a polymorphic lookup
+    if (megamorphicLookups == 0) {
+        QJSValue values = objects.property("concat").callWithInstance(objects, QJSValueList()
+                << 1 << QJSValue(QStringLiteral("one")) << true);
+        QJSValue count = engine.globalObject().property("count");
+        for (int round = 0; round < 2; ++round)
+            QCOMPARE(count.call(QJSValueList() << values).toInt(), shapes);
+        QCOMPARE(v4->nMegamorphicLookups, 0);
+    }
+}
+
+void tst_v4misc::externalArrayBuffers()
+{
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+
+    engine.evaluate(QStringLiteral(
+            "function sum(buffer) {\n"
+            "    var bytes = new Uint8Array(buffer);\n"
+            "    var result = 0;\n"
+            "    for (var i = 0; i < bytes.length; ++i)\n"
+            "        result += bytes[i];\n"
+            "    return result;\n"
+            "}\n"
+            "function fill(buffer, value) {\n"
+            "    new DataView(buffer).setUint8(0, value);\n"
+            "    return new Uint8Array(buffer)[0];\n"
+            "}\n"));
+    QJSValue sum = engine.globalObject().property("sum");
+    QJSValue fill = engine.globalObject().property("fill");
+
+    // a QByteArray is shared with the buffer until JS writes to it
+    QByteArray bytes("\x01\x02\x03", 3);
+    QJSValue buffer = engine.toScriptValue(bytes);
+    QCOMPARE(sum.call(QJSValueList() << buffer).toInt(), 6);
+    QCOMPARE(fill.call(QJSValueList() << buffer << 10).toInt(), 10);
+    QCOMPARE(bytes, QByteArray("\x01\x02\x03", 3));
+    QCOMPARE(buffer.toVariant().toByteArray(), QByteArray("\x0a\x02\x03", 3));
+
+    // external memory is read in place, and released on the first write
+    QSharedPointer<QVector<uchar> > samples(new QVector<uchar>({ 4, 5, 6 }));
+    QWeakPointer<QVector<uchar> > weakSamples = samples;
+    const char *sampleData = reinterpret_cast<const char *>(samples->constData());
+
+    QV4::Scope scope(v4);
+    QV4::Scoped<QV4::ArrayBuffer> external(scope, v4->newArrayBuffer(sampleData, samples->size(), samples));
+    QCOMPARE(external->constData(), sampleData);
+    QV4::ScopedString name(scope, v4->newString(QStringLiteral("externalBuffer")));
+    v4->globalObject->put(name, external);
+    samples.reset();
+
+    QCOMPARE(engine.evaluate("sum(externalBuffer)").toInt(), 15);
+    QVERIFY(!weakSamples.isNull());
+    QCOMPARE(external->asByteArray(), QByteArray("\x04\x05\x06", 3));
+
+    QCOMPARE(engine.evaluate("fill(externalBuffer, 7)").toInt(), 7);
+    QVERIFY(weakSamples.isNull());
+    QVERIFY(external->constData() != sampleData);
+    QCOMPARE(engine.evaluate("sum(externalBuffer)").toInt(), 18);
+}
+
+void tst_v4misc::packedArrays()
+{
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    QV4::Scope scope(v4);
+
+    auto elementKind = [&](const QString &name) {
+        QV4::ScopedString s(scope, v4->newString(name));
+        QV4::ScopedObject o(scope, v4->globalObject->get(s));
+        return QV4::Heap::ArrayData::ElementKind(o->arrayData()->elementKind);
+    };
+
+    engine.evaluate(QStringLiteral(
+            "var ints = [3, 1, 20, 2];\n"
+            "var doubles = [1.5, 2, 3];\n"
+            "var mixed = [1, 2, 3]; mixed.push('x');\n"
+            "var holey = [1, 2, 3]; delete holey[1];\n"));
+    QCOMPARE(elementKind("ints"), QV4::Heap::ArrayData::PackedInt32);
+    QCOMPARE(elementKind("doubles"), QV4::Heap::ArrayData::PackedDouble);
+    QCOMPARE(elementKind("mixed"), QV4::Heap::ArrayData::Generic);
+    QCOMPARE(elementKind("holey"), QV4::Heap::ArrayData::Generic);
+
+    QCOMPARE(engine.evaluate("ints.indexOf(20)").toInt(), 2);
+    QCOMPARE(engine.evaluate("ints.indexOf(20.0)").toInt(), 2);
+    QCOMPARE(engine.evaluate("ints.indexOf('20')").toInt(), -1);
+    QCOMPARE(engine.evaluate("ints.indexOf(3, 1)").toInt(), -1);
+    QCOMPARE(engine.evaluate("doubles.indexOf(2)").toInt(), 1);
+    QCOMPARE(engine.evaluate("doubles.lastIndexOf(1.5)").toInt(), 0);
+    QCOMPARE(engine.evaluate("[NaN, 1.5].indexOf(NaN)").toInt(), -1);
+    QCOMPARE(engine.evaluate("ints.slice().sort().join()").toString(), QStringLiteral("1,2,20,3"));
+    QCOMPARE(engine.evaluate("doubles.slice().sort(function(a, b) { return b - a; }).join()").toString(), QStringLiteral("3,2,1.5"));
+    QCOMPARE(engine.evaluate("ints.map(function(x) { return x * 2; }).join()").toString(), QStringLiteral("6,2,40,4"));
+
+    // the callback turns the array into a generic one while map() is iterating over it
+    QCOMPARE(engine.evaluate("ints.map(function(x, i) { if (!i) ints[2] = 'z'; return x; }).join()").toString(),
+             QStringLiteral("3,1,z,2"));
+    QCOMPARE(elementKind("ints"), QV4::Heap::ArrayData::Generic);
+    QCOMPARE(engine.evaluate("ints.indexOf('z')").toInt(), 2);
+
+    // clearing an array makes it packed again
+    engine.evaluate("ints.length = 0; ints.push(4)");
+    QCOMPARE(elementKind("ints"), QV4::Heap::ArrayData::PackedInt32);
+}
+
+void tst_v4misc::densifySparseArrays()
+{
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    QV4::Scope scope(v4);
+
+    auto arrayType = [&](const QString &name) {
+        QV4::ScopedString s(scope, v4->newString(name));
+        QV4::ScopedObject o(scope, v4->globalObject->get(s));
+        return o->arrayType();
+    };
+
+    engine.evaluate(QStringLiteral(
+            "var strided = [];\n"
+            "for (var i = 0; i < 1000; ++i)\n"
+            "    strided[i * 16 + 10000] = i;\n"
+            "var backfilled = [];\n"
+            "backfilled[10000] = -1;\n"
+            "for (var i = 0; i < 9000; ++i)\n"
+            "    backfilled[i] = i;\n"));
+    QCOMPARE(arrayType("strided"), QV4::Heap::ArrayData::Sparse);
+    QCOMPARE(arrayType("backfilled"), QV4::Heap::ArrayData::Simple);
+    QCOMPARE(engine.evaluate("backfilled.length").toInt(), 10001);
+    QCOMPARE(engine.evaluate("backfilled[8999] + backfilled[10000]").toInt(), 8998);
+    QVERIFY(engine.evaluate("!(9000 in backfilled) && !(9999 in backfilled)").toBool());
+    QCOMPARE(engine.evaluate("strided[16 * 999 + 10000]").toInt(), 999);
+
+    // the array becomes dense while a for-in loop is walking over its sparse entries
+    QCOMPARE(engine.evaluate(QStringLiteral(
+            "var a = [];\n"
+            "a[5000] = 0;\n"
+            "for (var i = 0; i < 2000; ++i)\n"
+            "    a[i] = i;\n"
+            "var visited = 0;\n"
+            "for (var k in a) {\n"
+            "    if (k == 0) {\n"
+            "        for (var j = 2000; j < 4096; ++j)\n"
+            "            a[j] = j;\n"
+            "    }\n"
+            "    ++visited;\n"
+            "}\n"
+            "visited")).toInt(), 4097);
+    QCOMPARE(arrayType("a"), QV4::Heap::ArrayData::Simple);
+
+    // Appending a dense array to a sparse one densifies the result while it
+    // is being filled; the remaining values must still be stored correctly.
+    QVERIFY(engine.evaluate(QStringLiteral(
+            "var s = [];\n"
+            "s[5000] = 'x';\n"
+            "for (var i = 0; i <= 2600; ++i)\n"
+            "    s[i] = i;\n"
+            "var d = [];\n"
+            "for (var i = 0; i < 1600; ++i)\n"
+            "    d.push(i);\n"
+            "var c = s.concat(d);\n"
+            "c.length === 6601 && c[5000] === 'x' && c[2600] === 2600\n"
+            "    && c[5001] === 0 && c[6600] === 1599 && !(3000 in c)")).toBool());
+    QCOMPARE(arrayType("c"), QV4::Heap::ArrayData::Simple);
+
+    // for-in continues after the last key when the array becomes dense and then sparse
+    // again inside the loop body
+    QCOMPARE(engine.evaluate(QStringLiteral(
+            "var t = [];\n"
+            "t[10] = 10;\n"
+            "t[5000] = 5000;\n"
+            "var seen = [];\n"
+            "for (var k in t) {\n"
+            "    seen.push(k);\n"
+            "    if (k == 10) {\n"
+            "        for (var i = 11; i < 4200; ++i)\n"
+            "            t[i] = i;\n"
+            "        t[100000] = 'far';\n"
+            "    }\n"
+            "}\n"
+            "[seen.length, seen[1], seen[4189], seen[4190], seen[4191]].join()")).toString(),
+             QStringLiteral("4192,11,4199,5000,100000"));
+    QCOMPARE(arrayType("t"), QV4::Heap::ArrayData::Sparse);
+}
+
+void tst_v4misc::internalClassTransitions()
+{
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+
+    const QString build = QStringLiteral(
+            "(function() {\n"
+            "    var objects = [];\n"
+            "    for (var n = 0; n < 100; ++n) {\n"
+            "        var o = {};\n"
+            "        for (var i = 0; i < 40; ++i)\n"
+            "            o['key' + i] = i;\n"
+            "        objects.push(o);\n"
+            "    }\n"
+            "    return objects;\n"
+            "})()");
+    engine.evaluate(build);
+    const QV4::InternalClassStatistics before = v4->internalClassStatistics();
+    QVERIFY(before.memoryUsage > 0);
+
+    // building the same shapes again only follows existing transitions
+    QJSValue objects = engine.evaluate(build);
+    QCOMPARE(objects.property(99).property(QStringLiteral("key39")).toInt(), 39);
+    QCOMPARE(v4->internalClassStatistics().classCount, before.classCount);
+
+    // enough siblings on the empty class to go through the transition index
+    QVERIFY(engine.evaluate(QStringLiteral(
+            "var siblings = [];\n"
+            "for (var i = 0; i < 200; ++i) {\n"
+            "    var o = {};\n"
+            "    o['p' + i] = i;\n"
+            "    siblings.push(o);\n"
+            "}\n"
+            "var ok = siblings[150].p150 === 150;\n"
+            "for (var i = 0; i < 200; ++i) {\n"
+            "    var o = {};\n"
+            "    o['p' + i] = -i;\n"
+            "    ok = ok && Object.keys(o)[0] === 'p' + i;\n"
+            "}\n"
+            "ok")).toBool());
+    const QV4::InternalClassStatistics after = v4->internalClassStatistics();
+    QVERIFY(after.classCount >= before.classCount + 200);
+    QVERIFY(after.transitionCount >= before.transitionCount + 200);
+
+    // changing attributes shares the layout with the original class, and both can still grow
+    QCOMPARE(engine.evaluate(QStringLiteral(
+            "var f = { a: 1, b: 2 };\n"
+            "Object.defineProperty(f, 'a', { writable: false });\n"
+            "f.a = 5;\n"
+            "f.b = 3;\n"
+            "f.c = 10;\n"
+            "var g = { a: 1, b: 2 };\n"
+            "g.d = 4;\n"
+            "[f.a + f.b, Object.keys(f).join(), f.c, g.c, g.d, Object.keys(g).join()].join(' ')")).toString(),
+             QStringLiteral("4 a,b,c 10  4 a,b,d"));
+
+    // changing attributes on a class whose property data is shared with a larger child
+    QCOMPARE(engine.evaluate(QStringLiteral(
+            "var h = {};\n"
+            "h.x = 1;\n"
+            "var k = {};\n"
+            "k.x = 1;\n"
+            "k.y = 2;\n"
+            "Object.defineProperty(h, 'x', { writable: false });\n"
+            "h.z = 3;\n"
+            "h.x = 7;\n"
+            "[h.x, h.z, Object.keys(h).join(), k.x, k.y, Object.keys(k).join()].join(' ')")).toString(),
+             QStringLiteral("1 3 x,z 1 2 x,y"));
+}
+
+void tst_v4misc::tieredCompilation()
+{
+    qputenv("QV4_JIT_CALL_THRESHOLD", "50");
+    QJSEngine engine;
+    qunsetenv("QV4_JIT_CALL_THRESHOLD");
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    if (!v4->tieredCompiler)
+        QSKIP("Tiered compilation needs both the interpreter and the JIT");
+
+    QJSValue fib = engine.evaluate(QStringLiteral(
+            "(function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); })"));
+    QJSValue sum = engine.evaluate(QStringLiteral(
+            "(function(n) { var s = 0; for (var i = 0; i < n; ++i) s += i; return s; })"));
+    QJSValue cold = engine.evaluate(QStringLiteral("(function(a, b) { return a + b; })"));
+    QCOMPARE(v4->tieredCompiler->installedUnitCount(), 0);
+
+    // recursion and loop iterations both make a function hot
+    QCOMPARE(fib.call(QJSValueList() << 15).toInt(), 610);
+    QCOMPARE(sum.call(QJSValueList() << 1000).toInt(), 499500);
+    v4->tieredCompiler->waitForIdle();
+    QCOMPARE(v4->tieredCompiler->compiledUnitCount(), 2);
+
+    // the compiled code gets picked up by the next hot call, and computes the same
+    QCOMPARE(fib.call(QJSValueList() << 20).toInt(), 6765);
+    QCOMPARE(sum.call(QJSValueList() << 1000).toInt(), 499500);
+    QCOMPARE(v4->tieredCompiler->installedUnitCount(), 2);
+    QCOMPARE(fib.call(QJSValueList() << 10).toInt(), 55);
+    QCOMPARE(sum.call(QJSValueList() << 10).toInt(), 45);
+
+    // functions that never get hot stay in the interpreter
+    QCOMPARE(cold.call(QJSValueList() << 1 << 2).toInt(), 3);
+    QCOMPARE(v4->tieredCompiler->compiledUnitCount(), 2);
+}
+
+void tst_v4misc::backgroundScriptCompilation()
+{
+    QQmlEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    if (!v4->tieredCompiler)
+        QSKIP("Tiered compilation needs both the interpreter and the JIT");
+
+    // Resources never end up in the disk cache, so the imported script is handed to the JIT as
+    // soon as it is loaded.
+    QQmlComponent component(&engine, QUrl(QStringLiteral("qrc:/data/backgroundcompilation.qml")));
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY2(object, qPrintable(component.errorString()));
+    v4->tieredCompiler->waitForIdle();
+    QCOMPARE(v4->tieredCompiler->compiledUnitCount(), 1);
+    QCOMPARE(v4->tieredCompiler->installedUnitCount(), 0);
+
+    // The first call picks up the generated code without the function ever getting hot.
+    QVariant result;
+    QVERIFY(QMetaObject::invokeMethod(object.data(), "compute", Q_RETURN_ARG(QVariant, result), Q_ARG(QVariant, 10)));
+    QCOMPARE(result.toInt(), 55);
+    QCOMPARE(v4->tieredCompiler->installedUnitCount(), 1);
+    QVERIFY(QMetaObject::invokeMethod(object.data(), "compute", Q_RETURN_ARG(QVariant, result), Q_ARG(QVariant, 100)));
+    QCOMPARE(result.toInt(), 5050);
+}
+
 QTEST_MAIN(tst_v4misc)
 
 #include "tst_v4misc.moc"
@@ -3,5 +3,6 @@ TARGET = tst_v4misc
 macx:CONFIG -= app_bundle
 
 SOURCES += tst_v4misc.cpp
+RESOURCES += v4misc.qrc
 
 QT += core-private qml-private testlib
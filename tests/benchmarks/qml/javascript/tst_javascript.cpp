@@ -31,6 +31,9 @@
 #include <qtest.h>
 #include <QQmlEngine>
 #include <QQmlComponent>
+#include <QJSEngine>
+#include <private/qv8engine_p.h>
+#include <private/qv4mm_p.h>
 
 #include "testtypes.h"
 
@@ -46,6 +49,21 @@ private slots:
     void run_data();
     void run();
 
+    void shortLivedObjects_data();
+    void shortLivedObjects();
+
+    void markLargeHeap_data();
+    void markLargeHeap();
+
+    void stringBuilder_data();
+    void stringBuilder();
+
+    void helperCalls_data();
+    void helperCalls();
+
+    void loops_data();
+    void loops();
+
 private:
     QQmlEngine engine;
 };
@@ -105,6 +123,233 @@ void tst_javascript::run()
     delete o;
 }
 
+void tst_javascript::shortLivedObjects_data()
+{
+    QTest::addColumn<int>("nurserySize");
+
+    QTest::newRow("no nursery") << 0;
+    QTest::newRow("256KB nursery") << 256*1024;
+    QTest::newRow("1MB nursery") << 1024*1024;
+}
+
+void tst_javascript::shortLivedObjects()
+{
+    QFETCH(int, nurserySize);
+
+    QJSEngine jsEngine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&jsEngine)->memoryManager;
+    mm->setNurserySize(nurserySize);
+
+    // A long lived heap that full collections need to traverse over and over again.
+    jsEngine.evaluate("var retained = []; for (var i = 0; i < 100000; ++i) retained.push({ index: i, name: 'item' + i });");
+    mm->runGC(/*forceFullCollection*/ true);
+
+    QJSValue churn = jsEngine.evaluate(
+            "(function() {\n"
+            "    var sum = 0;\n"
+            "    for (var i = 0; i < 100000; ++i) {\n"
+            "        var tmp = { x: i, y: [i, i + 1], s: 'tmp' + i };\n"
+            "        sum += tmp.y[1] + tmp.s.length;\n"
+            "    }\n"
+            "    return sum;\n"
+            "})");
+    QVERIFY(churn.isCallable());
+
+    QBENCHMARK {
+        churn.call();
+    }
+}
+
+void tst_javascript::markLargeHeap_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("8 threads") << 8;
+}
+
+void tst_javascript::markLargeHeap()
+{
+    QFETCH(int, threads);
+
+    QJSEngine jsEngine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&jsEngine)->memoryManager;
+    mm->setMarkingThreadCount(threads);
+
+    jsEngine.evaluate("var heap = [];\n"
+                      "for (var i = 0; i < 200; ++i) {\n"
+                      "    var group = [];\n"
+                      "    for (var j = 0; j < 2000; ++j) group.push({ index: j, name: 'item' + j, next: null });\n"
+                      "    for (var j = 1; j < group.length; ++j) group[j - 1].next = group[j];\n"
+                      "    heap.push(group);\n"
+                      "}\n");
+
+    QBENCHMARK {
+        mm->runGC(/*forceFullCollection*/ true);
+    }
+}
+
+void tst_javascript::stringBuilder_data()
+{
+    QTest::addColumn<QString>("function");
+
+    QTest::newRow("append") << QStringLiteral(
+            "(function() {\n"
+            "    var s = '';\n"
+            "    for (var i = 0; i < 100000; ++i)\n"
+            "        s += 'item' + i + ',';\n"
+            "    return s.length;\n"
+            "})");
+    QTest::newRow("prepend") << QStringLiteral(
+            "(function() {\n"
+            "    var s = '';\n"
+            "    for (var i = 0; i < 100000; ++i)\n"
+            "        s = i + ',' + s;\n"
+            "    return s.length;\n"
+            "})");
+    QTest::newRow("append and compare") << QStringLiteral(
+            "(function() {\n"
+            "    var a = '', b = '', equal = 0;\n"
+            "    for (var i = 0; i < 20000; ++i) {\n"
+            "        a += i;\n"
+            "        b += i;\n"
+            "        if (a === b)\n"
+            "            ++equal;\n"
+            "    }\n"
+            "    return equal;\n"
+            "})");
+    QTest::newRow("append and read") << QStringLiteral(
+            "(function() {\n"
+            "    var s = '', n = 0;\n"
+            "    for (var i = 0; i < 20000; ++i) {\n"
+            "        s += 'x';\n"
+            "        if (i % 1000 == 0)\n"
+            "            n += s.indexOf('y');\n"
+            "    }\n"
+            "    return n;\n"
+            "})");
+}
+
+void tst_javascript::stringBuilder()
+{
+    QFETCH(QString, function);
+
+    QJSEngine jsEngine;
+    QJSValue build = jsEngine.evaluate(function);
+    QVERIFY(build.isCallable());
+
+    QBENCHMARK {
+        QJSValue result = build.call();
+        QVERIFY(result.isNumber());
+    }
+}
+
+void tst_javascript::helperCalls_data()
+{
+    QTest::addColumn<QString>("function");
+
+    const QString helpers = QStringLiteral(
+            "function clamp(x, lo, hi) { return x < lo ? lo : (x > hi ? hi : x); }\n"
+            "function lerp(a, b, t) { return a + (b - a) * t; }\n");
+    const QString loop = QStringLiteral(
+            "    var sum = 0;\n"
+            "    for (var i = 0; i < 100000; ++i)\n"
+            "        sum += lerp(0, 255, clamp((i % 300) / 255, 0, 1));\n"
+            "    return sum;\n");
+
+    // Helpers declared inside the function get inlined into the loop.
+    QTest::newRow("nested helpers") << QStringLiteral("(function() {\n%1%2})").arg(helpers, loop);
+    // Global functions are looked up and called on every iteration.
+    QTest::newRow("global helpers") << QStringLiteral("%1(function() {\n%2})").arg(helpers, loop);
+    // Helpers that may be replaced at run-time are called through their closure.
+    QTest::newRow("reassignable helpers") << QStringLiteral(
+            "(function() {\n%1    if (typeof clamp !== 'function') clamp = lerp = null;\n%2})").arg(helpers, loop);
+}
+
+void tst_javascript::helperCalls()
+{
+    QFETCH(QString, function);
+
+    QJSEngine jsEngine;
+    QJSValue run = jsEngine.evaluate(function);
+    QVERIFY(run.isCallable());
+
+    QBENCHMARK {
+        QJSValue result = run.call();
+        QVERIFY(result.isNumber());
+    }
+}
+
+void tst_javascript::loops_data()
+{
+    QTest::addColumn<QString>("function");
+
+    // The counter is compared against an int32, so it is narrowed to int32.
+    QTest::newRow("int32 bound") << QStringLiteral(
+            "(function() {\n"
+            "    var sum = 0;\n"
+            "    for (var i = 0; i < 1000000; ++i)\n"
+            "        sum += i & 0xff;\n"
+            "    return sum;\n"
+            "})");
+    // The same loop with a bound that doesn't fit in an int32 keeps a double counter.
+    QTest::newRow("double bound") << QStringLiteral(
+            "(function() {\n"
+            "    var sum = 0;\n"
+            "    for (var i = 0; i < 1000000.5; ++i)\n"
+            "        sum += i & 0xff;\n"
+            "    return sum;\n"
+            "})");
+    // a * b + c is calculated once, before the loop.
+    QTest::newRow("invariant arithmetic") << QStringLiteral(
+            "(function(x, y, z) {\n"
+            "    var a = x | 0, b = y * 0.5, c = z | 0, sum = 0;\n"
+            "    for (var i = 0; i < 1000000; ++i)\n"
+            "        sum += (a * b + c) * (i & 0xff);\n"
+            "    return sum;\n"
+            "})");
+
+    const QString arrayLoop = QStringLiteral(
+            "(function() {\n"
+            "    var arr = [];\n"
+            "    for (var j = 0; j < 1000; ++j)\n"
+            "        arr.push(j);\n"
+            "    var scale = { factor: 2 };\n"
+            "    var sum = 0;\n"
+            "    for (var k = 0; k < 1000; ++k) {\n"
+            "%1"
+            "    }\n"
+            "    return sum;\n"
+            "})");
+    // arr.length and scale.factor are read on every iteration, and the counter is a double.
+    QTest::newRow("array, length bound") << arrayLoop.arg(QStringLiteral(
+            "        for (var i = 0; i < arr.length; ++i)\n"
+            "            sum += arr[i] * scale.factor;\n"));
+    // Reading them once, with the length as an int32, gives an int32 counter and index.
+    QTest::newRow("array, int32 bound") << arrayLoop.arg(QStringLiteral(
+            "        var n = arr.length | 0, factor = +scale.factor;\n"
+            "        for (var i = 0; i < n; ++i)\n"
+            "            sum += arr[i] * factor;\n"));
+}
+
+void tst_javascript::loops()
+{
+    QFETCH(QString, function);
+
+    QJSEngine jsEngine;
+    QJSValue run = jsEngine.evaluate(function);
+    QVERIFY(run.isCallable());
+
+    QJSValueList args;
+    args << 3 << 5 << 7;
+    QBENCHMARK {
+        QJSValue result = run.call(args);
+        QVERIFY(result.isNumber());
+    }
+}
+
 QTEST_MAIN(tst_javascript)
 
 #include "tst_javascript.moc"
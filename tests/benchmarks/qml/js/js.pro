@@ -3,6 +3,13 @@ SUBDIRS = \
         qjsengine \
 #        qjsvalue \ ### FIXME: doesn't build
         qjsvalueiterator \
+        json \
+        sparsearray \
+        sequence \
+        numberconversion \
+        tieredcompilation \
+        numericarray \
+        packedarray \
 
 TRUSTED_BENCHMARKS += \
     qjsvalue \
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_json
+
+SOURCES += tst_json.cpp
+
+QT += qml testlib
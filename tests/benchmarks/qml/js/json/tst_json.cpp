@@ -0,0 +1,126 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <qtest.h>
+#include <QtQml/qjsvalue.h>
+#include <QtQml/qjsengine.h>
+
+class tst_json : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+    void stringify_data();
+    void stringify();
+
+private:
+    void addPayloads();
+};
+
+// Builds a payload similar to what telemetry views get from their servers: an array of
+// records with the same keys, some nesting, and optionally indentation
+static QString payload(int records, bool indented)
+{
+    QJSEngine engine;
+    QJSValue make = engine.evaluate(QStringLiteral(
+            "(function(records, indented) {\n"
+            "    var data = [];\n"
+            "    for (var i = 0; i < records; ++i) {\n"
+            "        data.push({\n"
+            "            id: i,\n"
+            "            name: 'sensor ' + i,\n"
+            "            enabled: i % 2 == 0,\n"
+            "            value: i * 0.25,\n"
+            "            unit: 'm/s',\n"
+            "            position: { x: i, y: -i, z: i * 1.5 },\n"
+            "            samples: [i, i + 1, i + 2, i + 3],\n"
+            "            comment: 'a \"quoted\" note\\nwith a line break'\n"
+            "        });\n"
+            "    }\n"
+            "    return JSON.stringify(data, null, indented ? 4 : undefined);\n"
+            "})"));
+    return make.call(QJSValueList() << records << indented).toString();
+}
+
+void tst_json::addPayloads()
+{
+    QTest::addColumn<int>("records");
+    QTest::addColumn<bool>("indented");
+
+    QTest::newRow("1000 records") << 1000 << false;
+    QTest::newRow("1000 records, indented") << 1000 << true;
+    QTest::newRow("50000 records") << 50000 << false;
+    QTest::newRow("50000 records, indented") << 50000 << true;
+}
+
+void tst_json::parse_data()
+{
+    addPayloads();
+}
+
+void tst_json::parse()
+{
+    QFETCH(int, records);
+    QFETCH(bool, indented);
+
+    QJSEngine engine;
+    QJSValue text(payload(records, indented));
+    QJSValue parse = engine.evaluate(QStringLiteral("(function(text) { return JSON.parse(text).length; })"));
+    QVERIFY(parse.isCallable());
+
+    QBENCHMARK {
+        QCOMPARE(parse.call(QJSValueList() << text).toInt(), records);
+    }
+}
+
+void tst_json::stringify_data()
+{
+    addPayloads();
+}
+
+void tst_json::stringify()
+{
+    QFETCH(int, records);
+    QFETCH(bool, indented);
+
+    QJSEngine engine;
+    QJSValue data = engine.evaluate(QStringLiteral("JSON.parse")).call(QJSValueList() << payload(records, false));
+    QJSValue stringify = engine.evaluate(QStringLiteral(
+            "(function(data, indented) { return JSON.stringify(data, null, indented ? 4 : undefined).length; })"));
+    QVERIFY(stringify.isCallable());
+
+    QBENCHMARK {
+        QVERIFY(stringify.call(QJSValueList() << data << indented).toInt() > 0);
+    }
+}
+
+QTEST_MAIN(tst_json)
+#include "tst_json.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_numberconversion
+
+SOURCES += tst_numberconversion.cpp
+
+QT += qml testlib
@@ -0,0 +1,86 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+
+#include <qtest.h>
+
+
+
+#include <qtest.h>
+#include <QtQml/qjsvalue.h>
+#include <QtQml/qjsengine.h>
+
+class tst_numberconversion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void convert_data();
+    void convert();
+};
+
+void tst_numberconversion::convert_data()
+{
+    QTest::addColumn<QString>("expression");
+
+    // each expression is evaluated for i in [0, 10000) and x = i * 0.37
+    QTest::newRow("toString integer") << QStringLiteral("i.toString()");
+    QTest::newRow("toString double") << QStringLiteral("x.toString()");
+    QTest::newRow("toFixed integer") << QStringLiteral("i.toFixed(2)");
+    QTest::newRow("toFixed double") << QStringLiteral("x.toFixed(2)");
+    QTest::newRow("concat integer") << QStringLiteral("'Item ' + i");
+    QTest::newRow("concat double") << QStringLiteral("'' + x");
+    QTest::newRow("concat toFixed") << QStringLiteral("'' + x.toFixed(2)");
+    QTest::newRow("parse integer") << QStringLiteral("+String(i)");
+}
+
+void tst_numberconversion::convert()
+{
+    QFETCH(QString, expression);
+
+    QJSEngine engine;
+    QJSValue run = engine.evaluate(QStringLiteral(
+            "(function() {\n"
+            "    var length = 0;\n"
+            "    for (var i = 0; i < 10000; ++i) {\n"
+            "        var x = i * 0.37;\n"
+            "        var s = %1;\n"
+            "        length += s.length === undefined ? 1 : s.length;\n"
+            "    }\n"
+            "    return length;\n"
+            "})").arg(expression));
+    QVERIFY(run.isCallable());
+
+    QBENCHMARK {
+        QVERIFY(run.call().toInt() > 0);
+    }
+}
+
+QTEST_MAIN(tst_numberconversion)
+#include "tst_numberconversion.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_numericarray
+
+SOURCES += tst_numericarray.cpp
+
+QT += qml testlib
@@ -0,0 +1,83 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <qtest.h>
+#include <QtQml/qjsvalue.h>
+#include <QtQml/qjsengine.h>
+
+class tst_numericarray : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void loop_data();
+    void loop();
+};
+
+void tst_numericarray::loop_data()
+{
+    QTest::addColumn<QString>("body");
+
+    // each body runs for every index i of the 10000 element array 'data', which holds a mix of
+    // integers and doubles, like the samples of a chart
+    QTest::newRow("sum") << QStringLiteral("result += data[i];");
+    QTest::newRow("min max") << QStringLiteral("var v = data[i];\n"
+                                               "if (v < min) min = v;\n"
+                                               "if (v > max) max = v;\n"
+                                               "result = max - min;");
+    QTest::newRow("scale") << QStringLiteral("var y = (data[i] - min) * scale;\n"
+                                             "if (y >= 0 && y <= height) result += -y;");
+}
+
+void tst_numericarray::loop()
+{
+    QFETCH(QString, body);
+
+    QJSEngine engine;
+    QJSValue run = engine.evaluate(QStringLiteral(
+            "(function() {\n"
+            "    var data = [];\n"
+            "    for (var n = 0; n < 10000; ++n)\n"
+            "        data.push(n % 3 ? n * 0.5 : n);\n"
+            "    return function() {\n"
+            "        var result = 0, min = Infinity, max = -Infinity, scale = 0.01, height = 1000;\n"
+            "        for (var i = 0; i < data.length; ++i) {\n"
+            "            %1\n"
+            "        }\n"
+            "        return result;\n"
+            "    };\n"
+            "})()").arg(body));
+    QVERIFY(run.isCallable());
+
+    QBENCHMARK {
+        run.call();
+    }
+}
+
+QTEST_MAIN(tst_numericarray)
+#include "tst_numericarray.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_packedarray
+
+SOURCES += tst_packedarray.cpp
+
+QT += qml testlib
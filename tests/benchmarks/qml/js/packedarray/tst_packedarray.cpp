@@ -0,0 +1,89 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <qtest.h>
+#include <QtQml/qjsvalue.h>
+#include <QtQml/qjsengine.h>
+
+class tst_packedarray : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void builtins_data();
+    void builtins();
+};
+
+void tst_packedarray::builtins_data()
+{
+    QTest::addColumn<QString>("call");
+    QTest::addColumn<bool>("packed");
+
+    // each call runs on the 10000 element array 'data', which holds integers
+    const QStringList calls = {
+        QStringLiteral("data.indexOf(-1)"),
+        QStringLiteral("data.indexOf('1')"),
+        QStringLiteral("data.lastIndexOf(-1)"),
+        QStringLiteral("data.sort()"),
+        QStringLiteral("data.map(function(v) { return v + 1; })")
+    };
+    for (const QString &call : calls) {
+        QTest::newRow(qPrintable(call + QLatin1String(" packed"))) << call << true;
+        QTest::newRow(qPrintable(call + QLatin1String(" generic"))) << call << false;
+    }
+}
+
+void tst_packedarray::builtins()
+{
+    QFETCH(QString, call);
+    QFETCH(bool, packed);
+
+    // Both arrays hold the same integers, but storing an object once makes the generic one lose
+    // its packed element kind for good.
+    QJSEngine engine;
+    QJSValue run = engine.evaluate(QStringLiteral(
+            "(function(packed) {\n"
+            "    var data = [];\n"
+            "    for (var n = 0; n < 10000; ++n)\n"
+            "        data.push((n * 7919) % 10000);\n"
+            "    if (!packed) {\n"
+            "        data.push({});\n"
+            "        data.pop();\n"
+            "    }\n"
+            "    return function() { return %1; };\n"
+            "})").arg(call)).call(QJSValueList() << packed);
+    QVERIFY(run.isCallable());
+
+    QBENCHMARK {
+        run.call();
+    }
+}
+
+QTEST_MAIN(tst_packedarray)
+#include "tst_packedarray.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_sequence
+
+SOURCES += tst_sequence.cpp
+
+QT += qml testlib
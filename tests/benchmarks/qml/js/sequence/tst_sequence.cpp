@@ -0,0 +1,130 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+
+#include <qtest.h>
+
+#include <qtest.h>
+#include <QtQml/qqmlengine.h>
+#include <QtQml/qqmlcomponent.h>
+
+class SequenceProvider : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QList<qreal> values READ values WRITE setValues NOTIFY valuesChanged)
+public:
+    QList<qreal> values() const { return m_values; }
+    void setValues(const QList<qreal> &values) { m_values = values; emit valuesChanged(); }
+
+signals:
+    void valuesChanged();
+
+private:
+    QList<qreal> m_values;
+};
+
+class tst_sequence : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void indexedRead();
+    void forEach();
+    void slice();
+
+private:
+    void run(const char *function);
+
+    QQmlEngine engine;
+    SequenceProvider provider;
+    QScopedPointer<QObject> root;
+};
+
+void tst_sequence::initTestCase()
+{
+    QList<qreal> values;
+    values.reserve(10000);
+    for (int i = 0; i < 10000; ++i)
+        values.append(i * 0.5);
+    provider.setValues(values);
+
+    QQmlComponent component(&engine);
+    component.setData("import QtQml 2.0\n"
+                      "QtObject {\n"
+                      "    property QtObject provider\n"
+                      "    function indexedRead() {\n"
+                      "        var values = provider.values;\n"
+                      "        var sum = 0;\n"
+                      "        for (var i = 0; i < values.length; ++i)\n"
+                      "            sum += values[i];\n"
+                      "        return sum;\n"
+                      "    }\n"
+                      "    function forEach() {\n"
+                      "        var sum = 0;\n"
+                      "        provider.values.forEach(function(v) { sum += v; });\n"
+                      "        return sum;\n"
+                      "    }\n"
+                      "    function slice() {\n"
+                      "        return provider.values.slice(1000, 9000).length;\n"
+                      "    }\n"
+                      "}\n", QUrl());
+    root.reset(component.beginCreate(engine.rootContext()));
+    QVERIFY2(root, qPrintable(component.errorString()));
+    root->setProperty("provider", QVariant::fromValue<QObject *>(&provider));
+    component.completeCreate();
+}
+
+void tst_sequence::run(const char *function)
+{
+    QVariant result;
+    QBENCHMARK {
+        QMetaObject::invokeMethod(root.data(), function, Q_RETURN_ARG(QVariant, result));
+    }
+    QVERIFY(result.isValid());
+}
+
+void tst_sequence::indexedRead()
+{
+    run("indexedRead");
+}
+
+void tst_sequence::forEach()
+{
+    run("forEach");
+}
+
+void tst_sequence::slice()
+{
+    run("slice");
+}
+
+QTEST_MAIN(tst_sequence)
+
+#include "tst_sequence.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_sparsearray
+
+SOURCES += tst_sparsearray.cpp
+
+QT += qml testlib
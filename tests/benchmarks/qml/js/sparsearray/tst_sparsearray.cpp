@@ -0,0 +1,149 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+
+#include <qtest.h>
+#include <QtQml/qjsvalue.h>
+#include <QtQml/qjsengine.h>
+
+class tst_sparsearray : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void insert_data();
+    void insert();
+    void lookup_data();
+    void lookup();
+    void iterate_data();
+    void iterate();
+
+private:
+    void addLayouts();
+};
+
+// "strided" arrays only use every 16th index and stay sparse. "backfilled" arrays start
+// with a write far past their end and then get filled from the front, like log views
+// that allocate their last row first.
+static const char *buildFunction =
+        "(function(size, stride) {\n"
+        "    var a = [];\n"
+        "    if (stride == 1)\n"
+        "        a[size] = 0;\n"
+        "    for (var i = 0; i < size; ++i)\n"
+        "        a[i * stride] = i;\n"
+        "    return a;\n"
+        "})";
+
+void tst_sparsearray::addLayouts()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("stride");
+
+    QTest::newRow("100000 strided") << 100000 << 16;
+    QTest::newRow("100000 backfilled") << 100000 << 1;
+    QTest::newRow("1000000 strided") << 1000000 << 16;
+    QTest::newRow("1000000 backfilled") << 1000000 << 1;
+}
+
+void tst_sparsearray::insert_data()
+{
+    addLayouts();
+}
+
+void tst_sparsearray::insert()
+{
+    QFETCH(int, size);
+    QFETCH(int, stride);
+
+    QJSEngine engine;
+    QJSValue build = engine.evaluate(QString::fromLatin1(buildFunction));
+    QVERIFY(build.isCallable());
+
+    QBENCHMARK {
+        QVERIFY(build.call(QJSValueList() << size << stride).isArray());
+    }
+}
+
+void tst_sparsearray::lookup_data()
+{
+    addLayouts();
+}
+
+void tst_sparsearray::lookup()
+{
+    QFETCH(int, size);
+    QFETCH(int, stride);
+
+    QJSEngine engine;
+    QJSValue array = engine.evaluate(QString::fromLatin1(buildFunction)).call(QJSValueList() << size << stride);
+    QJSValue sum = engine.evaluate(QStringLiteral(
+            "(function(a, size, stride) {\n"
+            "    var sum = 0;\n"
+            "    for (var i = 0; i < size; ++i)\n"
+            "        sum += a[i * stride];\n"
+            "    return sum;\n"
+            "})"));
+    QVERIFY(sum.isCallable());
+
+    const double expected = double(size) * (size - 1) / 2;
+    QBENCHMARK {
+        QCOMPARE(sum.call(QJSValueList() << array << size << stride).toNumber(), expected);
+    }
+}
+
+void tst_sparsearray::iterate_data()
+{
+    addLayouts();
+}
+
+void tst_sparsearray::iterate()
+{
+    QFETCH(int, size);
+    QFETCH(int, stride);
+
+    QJSEngine engine;
+    QJSValue array = engine.evaluate(QString::fromLatin1(buildFunction)).call(QJSValueList() << size << stride);
+    QJSValue count = engine.evaluate(QStringLiteral(
+            "(function(a) {\n"
+            "    var count = 0;\n"
+            "    for (var k in a)\n"
+            "        ++count;\n"
+            "    return count;\n"
+            "})"));
+    QVERIFY(count.isCallable());
+
+    const int expected = stride == 1 ? size + 1 : size;
+    QBENCHMARK {
+        QCOMPARE(count.call(QJSValueList() << array).toInt(), expected);
+    }
+}
+
+QTEST_MAIN(tst_sparsearray)
+#include "tst_sparsearray.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_tieredcompilation
+
+SOURCES += tst_tieredcompilation.cpp
+
+QT += qml-private testlib
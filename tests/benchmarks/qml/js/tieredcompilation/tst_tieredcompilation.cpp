@@ -0,0 +1,147 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <qtest.h>
+#include <QtQml/qjsvalue.h>
+#include <QtQml/qjsengine.h>
+#include <private/qv8engine_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4executableallocator_p.h>
+
+class tst_tieredcompilation : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void startup_data();
+    void startup();
+    void codeSize_data();
+    void codeSize();
+    void hotLoop_data();
+    void hotLoop();
+
+private:
+    void addTiers();
+};
+
+// A script shaped like typical application code: lots of small functions, few of them hot.
+static QString manyFunctions()
+{
+    QString script;
+    for (int i = 0; i < 500; ++i) {
+        script += QStringLiteral("function f%1(o, n) {\n"
+                                 "    var r = o.a + n * %1;\n"
+                                 "    if (r > 1000) return r - o.b;\n"
+                                 "    return [r, o.b, n].join('-');\n"
+                                 "}\n").arg(i);
+    }
+    script += QStringLiteral("var total = 0;\n"
+                             "for (var i = 0; i < 5; ++i)\n"
+                             "    total += f0({ a: i, b: 2 }, i).length;\n"
+                             "total\n");
+    return script;
+}
+
+class CallThreshold
+{
+public:
+    CallThreshold(const QByteArray &threshold) { qputenv("QV4_JIT_CALL_THRESHOLD", threshold); }
+    ~CallThreshold() { qunsetenv("QV4_JIT_CALL_THRESHOLD"); }
+};
+
+void tst_tieredcompilation::addTiers()
+{
+    QTest::addColumn<QByteArray>("threshold");
+
+    QTest::newRow("tiered") << QByteArray("1000");
+    QTest::newRow("jit") << QByteArray("0");
+}
+
+void tst_tieredcompilation::startup_data()
+{
+    addTiers();
+}
+
+void tst_tieredcompilation::startup()
+{
+    QFETCH(QByteArray, threshold);
+
+    const QString script = manyFunctions();
+    CallThreshold callThreshold(threshold);
+
+    QBENCHMARK {
+        QJSEngine engine;
+        QVERIFY(engine.evaluate(script).toInt() > 0);
+    }
+}
+
+void tst_tieredcompilation::codeSize_data()
+{
+    addTiers();
+}
+
+void tst_tieredcompilation::codeSize()
+{
+    QFETCH(QByteArray, threshold);
+
+    CallThreshold callThreshold(threshold);
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    const size_t before = v4->executableAllocator->usedSize();
+    QVERIFY(engine.evaluate(manyFunctions()).toInt() > 0);
+
+    QTest::setBenchmarkResult(v4->executableAllocator->usedSize() - before, QTest::BytesAllocated);
+}
+
+void tst_tieredcompilation::hotLoop_data()
+{
+    addTiers();
+}
+
+void tst_tieredcompilation::hotLoop()
+{
+    QFETCH(QByteArray, threshold);
+
+    CallThreshold callThreshold(threshold);
+    QJSEngine engine;
+    QJSValue run = engine.evaluate(QStringLiteral(
+            "(function() {\n"
+            "    var sum = 0;\n"
+            "    for (var i = 0; i < 100000; ++i)\n"
+            "        sum = (sum + i * 3) % 65521;\n"
+            "    return sum;\n"
+            "})"));
+    QVERIFY(run.isCallable());
+
+    QBENCHMARK {
+        QVERIFY(run.call().toInt() >= 0);
+    }
+}
+
+QTEST_MAIN(tst_tieredcompilation)
+#include "tst_tieredcompilation.moc"